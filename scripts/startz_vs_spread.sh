@@ -7,32 +7,13 @@
 # Variables
 node_count=50
 starting_z_height=30000
-terminal_velocity=8.0
 spread_factor=20
 interval=100
-z_height=$starting_z_height
 
 dir=output/startz_vs_spread/$(date +"%Y-%m-%d-%H-%M-%S")
 mkdir -p $dir
 
-total=0.0
-count=0
-while [ $z_height -gt 0 ];
-do
-    ./dwsn -d1 -c$node_count -z$z_height -t$terminal_velocity -s$spread_factor | grep 'final\ position' | \
-    awk '{print $11,$12}' |
-    while read -r line; 
-        do 
-        ((count=count+1))
-        x_coordinate=$(echo $line | cut -f1 -d' ')
-        y_coordinate=$(echo $line | cut -f2 -d' ')
-        distance=$(echo "sqrt($x_coordinate^2 + $y_coordinate^2)" | bc)
-        export total=$(echo "$total + $distance" | bc)
-        if [ $count == $node_count ]
-        then
-            average=$(echo "$total / $count" | bc)
-            echo "$z_height $average" >> $dir/output.txt
-        fi
-    done 
-    ((z_height=z_height-interval))
-done
+# Columns are start_z, runs, then mean/variance pairs, mean_spread_mean is 15
+./dwsn -v0 -c$node_count -s$spread_factor -w start_z=$interval:$starting_z_height:$interval | \
+grep -v '^[A-Z]' > $dir/sweep.txt
+awk '!/^#/ {print $1, $15}' $dir/sweep.txt > $dir/output.txt
@@ -0,0 +1,465 @@
+/**
+ * @file    bench.c
+ * @brief   dwsn-bench, scaling scenarios and hot path microbenchmarks
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "mcu_emulation.h"
+#include "mcu_functions.h"
+#include "packet.h"
+#include "settings.h"
+#include "simulation.h"
+
+/**
+ * Allocation counting, the bench is linked with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=aligned_alloc so
+ * every allocation the simulator makes comes through here
+**/
+static unsigned long allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap_aligned_alloc(size_t alignment, size_t size) {
+    allocations++;
+    return __real_aligned_alloc(alignment, size);
+}
+
+static const int bench_nodes[] = {10, 100, 1000, 10000};
+static const int bench_channels[] = {4, 16, 64};
+static const double bench_resolutions[] = {0.01, 0.001};
+
+// Signal store every scenario uses, -l and -f
+static int bench_signal_store = 0;
+static int bench_signal_format = 0;
+// SINR reception instead of binary collisions, -i
+static int bench_sinr = 0;
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+// What a scenario child sends back over its pipe
+struct Scenario_Result {
+    unsigned long ticks;
+    double seconds;
+    unsigned long allocations;
+};
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Same drop as the sample ini with the bench's fixed seed, nothing printed
+// or written
+static void bench_settings(struct Settings* settings, int nodes, int channels, double resolution) {
+    static int sensor_types[] = {0, 1, 2};
+    set_program_defaults(settings);
+    settings->node_count = nodes;
+    settings->channels = channels;
+    settings->time_resolution = resolution;
+    settings->random_seed = 1;
+    settings->verbose = 0;
+    settings->debug = 0;
+    settings->output = 0;
+    settings->sensor_count = 3;
+    settings->sensor_types = sensor_types;
+    settings->signal_store = bench_signal_store;
+    settings->signal_format = bench_signal_format;
+    settings->sinr = bench_sinr;
+}
+
+/**
+ * Run scenario
+ * Desc: Steps a fresh simulation until max_ticks or budget seconds, always
+ *       at least one tick. Setup isn't timed or counted.
+**/
+static void run_scenario(const struct Settings* settings, unsigned long max_ticks, double budget,
+                         struct Scenario_Result* result) {
+    struct Simulation* sim = simulation_create(settings);
+    double start = now_seconds();
+    unsigned long start_allocations = allocations;
+
+    result->ticks = 0;
+    do {
+        simulation_step(sim);
+        result->ticks++;
+    } while (result->ticks < max_ticks && sim->state.moving_nodes > 0 && now_seconds() - start < budget);
+
+    result->seconds = now_seconds() - start;
+    result->allocations = allocations - start_allocations;
+    simulation_destroy(sim);
+}
+
+// Each scenario runs in its own process so peak RSS is its own
+static int fork_scenario(const struct Settings* settings, unsigned long max_ticks, double budget,
+                         struct Scenario_Result* result, long* peak_rss_kb) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        run_scenario(settings, max_ticks, budget, result);
+        _exit(write(fds[1], result, sizeof(*result)) == sizeof(*result) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        got != sizeof(*result)) {
+        return -1;
+    }
+    *peak_rss_kb = usage.ru_maxrss;
+    return 0;
+}
+
+// Micro benchmarks loop until they've run at least this long
+#define MICRO_SECONDS   0.2
+
+struct Micro_Result {
+    const char* name;
+    unsigned long iterations;
+    double seconds;
+};
+
+// Keeps results the compiler could otherwise throw away
+static volatile double sink;
+
+static void micro_update_signal(struct Simulation* sim, struct Micro_Result* result) {
+    int n = sim->settings.node_count;
+    double start = now_seconds();
+    result->iterations = 0;
+    do {
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                update_signal(sim, i, j);
+            }
+        }
+        result->iterations += (unsigned long)n * n;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    result->seconds = now_seconds() - start;
+    sink = get_signal(sim, n - 1, 0);
+}
+
+// Same pairs as update_signal, a receiver's whole row per batch call
+static void micro_signal_batch(struct Simulation* sim, struct Micro_Result* result) {
+    int n = sim->settings.node_count;
+    int* transmitters = malloc(sizeof(int) * n);
+    double* signals = malloc(sizeof(double) * n);
+    if (transmitters == NULL || signals == NULL) {
+        printf("Bench memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < n; i++) {
+        transmitters[i] = i;
+    }
+    double start = now_seconds();
+    result->iterations = 0;
+    do {
+        for (int i = 0; i < n; i++) {
+            signal_batch_to(sim, i, 0, transmitters, n, signals);
+        }
+        result->iterations += (unsigned long)n * n;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    result->seconds = now_seconds() - start;
+    sink = signals[0];
+    free(transmitters);
+    free(signals);
+}
+
+// Largest difference between the fast kernel and the exact loss over
+// distances from 1 mm to 1000 km
+static double path_loss_max_error(void) {
+    double distances[PATH_LOSS_BATCH];
+    double loss[PATH_LOSS_BATCH];
+    double constant = 20 * log(PATH_LOSS_FREQUENCY) + 32.44;
+    double max_error = 0;
+    for (int step = 0; step < 100000; step += PATH_LOSS_BATCH) {
+        for (int i = 0; i < PATH_LOSS_BATCH; i++) {
+            double distance = 1e-3 * pow(1e9, (step + i) / 100000.0);
+            distances[i] = distance * distance;
+        }
+        path_loss_fast(distances, loss, PATH_LOSS_BATCH, constant);
+        for (int i = 0; i < PATH_LOSS_BATCH; i++) {
+            double error = fabs(loss[i] - path_loss_exact(sqrt(distances[i])));
+            if (error > max_error) {
+                max_error = error;
+            }
+        }
+    }
+    return max_error;
+}
+
+// Table lookup and busy time policy for a function with a fixed busy time,
+// the path every mcu_call() goes through first
+static void micro_mcu_dispatch(struct Simulation* sim, struct Micro_Result* result) {
+    int n = sim->settings.node_count;
+    struct Node* nodes = sim->nodes;
+    double start = now_seconds();
+    result->iterations = 0;
+    do {
+        for (int i = 0; i < n; i++) {
+            nodes[i].current_function = 1;
+            nodes[i].busy_pending = 1;
+            nodes[i].wake_cycle = sim->state.current_cycle;
+            mcu_run_function(sim, i);
+        }
+        result->iterations += n;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    result->seconds = now_seconds() - start;
+}
+
+// mcu_call() into check_channel_busy and back out, with a quarter of the
+// nodes transmitting
+static void micro_check_channel_busy(struct Simulation* sim, struct Micro_Result* result) {
+    int n = sim->settings.node_count;
+    struct Node* nodes = sim->nodes;
+    for (int i = 0; i < n; i++) {
+        set_active_channel(sim, i, i % sim->settings.channels);
+        if (i % 4 == 0) {
+            set_transmit_active(sim, i, 1);
+        }
+    }
+    double start = now_seconds();
+    result->iterations = 0;
+    do {
+        for (int i = 0; i < n; i++) {
+            mcu_call(sim, i, 0, 0, 4);
+            mcu_function_check_channel_busy(sim, i);
+            sink = nodes[i].return_stack->return_value;
+            rs_pop(&nodes[i]);
+        }
+        result->iterations += n;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    result->seconds = now_seconds() - start;
+    for (int i = 0; i < n; i += 4) {
+        set_transmit_active(sim, i, 0);
+    }
+}
+
+static void sample_packet(struct Packet* packet) {
+    memset(packet, 0, sizeof(*packet));
+    packet->dest = PACKET_ADDR_GROUND;
+    packet->src = 17;
+    packet->type = PACKET_TYPE_RELAY;
+    packet->seq = 42;
+    packet->timestamp = 123.456;
+    packet->payload.origin = 23;
+    packet->payload.time = 120.5;
+    packet->payload.reading_count = 3;
+    for (int i = 0; i < 3; i++) {
+        packet->payload.readings[i].type = i;
+        packet->payload.readings[i].value_count = i + 1;
+        for (int j = 0; j <= i; j++) {
+            packet->payload.readings[i].values[j] = 1000.0 / (i + j + 3);
+        }
+    }
+}
+
+static void micro_packets(struct Micro_Result* encode, struct Micro_Result* decode, struct Micro_Result* format) {
+    struct Packet packet;
+    struct Packet decoded;
+    unsigned char frame[PACKET_MAX_SIZE];
+    char text[PACKET_TEXT_SIZE];
+    sample_packet(&packet);
+    int length = packet_encode(&packet, frame, sizeof(frame));
+
+    double start = now_seconds();
+    encode->iterations = 0;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            packet.seq = i;
+            sink = packet_encode(&packet, frame, sizeof(frame));
+        }
+        encode->iterations += 1000;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    encode->seconds = now_seconds() - start;
+
+    start = now_seconds();
+    decode->iterations = 0;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            packet_decode(frame, length, &decoded);
+            sink = decoded.payload.time;
+        }
+        decode->iterations += 1000;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    decode->seconds = now_seconds() - start;
+
+    start = now_seconds();
+    format->iterations = 0;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            sink = packet_format(&decoded, text, sizeof(text));
+        }
+        format->iterations += 1000;
+    } while (now_seconds() - start < MICRO_SECONDS);
+    format->seconds = now_seconds() - start;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+        "Usage: dwsn-bench [-n max ticks] [-s seconds] [-m max nodes] [-l layout] [-f format] [-i] [-u]\n"
+        "  -n  ticks per scenario at most (default 2000)\n"
+        "  -s  seconds per scenario at most, at least one tick runs (default 2)\n"
+        "  -m  skip scenarios with more nodes (default 10000)\n"
+        "  -l  signal_store layout, 0 dense, 1 triangular, 2 sparse (default 0)\n"
+        "  -f  signal_format, 0 double, 1 float, 2 int16, 3 int8 (default 0)\n"
+        "  -i  SINR reception\n"
+        "  -u  microbenchmarks only\n"
+        "JSON results go to stdout, progress to stderr\n");
+}
+
+int main(int argc, char** argv) {
+    unsigned long max_ticks = 2000;
+    double budget = 2.0;
+    int max_nodes = 10000;
+    int micro_only = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:m:l:f:iuh")) != -1) {
+        switch (c) {
+            case 'n':
+                max_ticks = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                budget = atof(optarg);
+                break;
+            case 'm':
+                max_nodes = atoi(optarg);
+                break;
+            case 'l':
+                bench_signal_store = atoi(optarg);
+                break;
+            case 'f':
+                bench_signal_format = atoi(optarg);
+                break;
+            case 'i':
+                bench_sinr = 1;
+                break;
+            case 'u':
+                micro_only = 1;
+                break;
+            default:
+                usage();
+                return 2;
+        }
+    }
+
+    printf("{\n  \"build\": {\"compiler\": \"%s\", \"soa\": %d, \"profile\": %d},\n", __VERSION__,
+#ifdef KINEMATICS_SOA
+           1,
+#else
+           0,
+#endif
+#ifdef PROFILE
+           1);
+#else
+           0);
+#endif
+    printf("  \"scenario_limits\": {\"max_ticks\": %lu, \"seconds\": %f},\n", max_ticks, budget);
+    printf("  \"signal_store\": {\"layout\": %d, \"format\": %d},\n", bench_signal_store, bench_signal_format);
+    printf("  \"sinr\": %d,\n", bench_sinr);
+
+    printf("  \"scenarios\": [");
+    int first = 1;
+    for (int n = 0; n < COUNT(bench_nodes) && !micro_only; n++) {
+        if (bench_nodes[n] > max_nodes) {
+            continue;
+        }
+        for (int ch = 0; ch < COUNT(bench_channels); ch++) {
+            for (int r = 0; r < COUNT(bench_resolutions); r++) {
+                struct Settings settings;
+                struct Scenario_Result result;
+                long peak_rss_kb = 0;
+                bench_settings(&settings, bench_nodes[n], bench_channels[ch], bench_resolutions[r]);
+                fprintf(stderr, "nodes %d, channels %d, time resolution %g: ",
+                        bench_nodes[n], bench_channels[ch], bench_resolutions[r]);
+                fflush(stdout);
+                fflush(stderr);
+
+                printf("%s\n    {\"nodes\": %d, \"channels\": %d, \"time_resolution\": %g, ",
+                       first ? "" : ",", bench_nodes[n], bench_channels[ch], bench_resolutions[r]);
+                first = 0;
+                if (fork_scenario(&settings, max_ticks, budget, &result, &peak_rss_kb) != 0) {
+                    fprintf(stderr, "failed\n");
+                    printf("\"error\": \"scenario failed\"}");
+                    continue;
+                }
+                double ticks_per_sec = result.seconds > 0 ? result.ticks / result.seconds : 0;
+                fprintf(stderr, "%.1f ticks/sec\n", ticks_per_sec);
+                printf("\"ticks\": %lu, \"seconds\": %f, \"ticks_per_sec\": %f, \"node_ticks_per_sec\": %f, "
+                       "\"peak_rss_kb\": %ld, \"allocations_per_tick\": %f}",
+                       result.ticks, result.seconds, ticks_per_sec, ticks_per_sec * bench_nodes[n],
+                       peak_rss_kb, (double)result.allocations / result.ticks);
+            }
+        }
+    }
+    printf("\n  ],\n");
+
+    // Microbenchmarks share one 100 node simulation a few seconds into the drop
+    struct Settings settings;
+    struct Micro_Result micro[7] = {
+        {"update_signal"}, {"signal_batch_to"}, {"mcu_run_function_dispatch"}, {"check_channel_busy"},
+        {"packet_encode"}, {"packet_decode"}, {"packet_format"}
+    };
+    bench_settings(&settings, 100, 16, 0.001);
+    struct Simulation* sim = simulation_create(&settings);
+    simulation_run_until(sim, 5.0);
+    fprintf(stderr, "microbenchmarks\n");
+    micro_update_signal(sim, &micro[0]);
+    micro_signal_batch(sim, &micro[1]);
+    micro_mcu_dispatch(sim, &micro[2]);
+    micro_check_channel_busy(sim, &micro[3]);
+    micro_packets(&micro[4], &micro[5], &micro[6]);
+    simulation_destroy(sim);
+
+    printf("  \"micro\": [");
+    for (int i = 0; i < COUNT(micro); i++) {
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %lu, \"seconds\": %f, \"ns_per_op\": %f}",
+               i == 0 ? "" : ",", micro[i].name, micro[i].iterations, micro[i].seconds,
+               micro[i].iterations > 0 ? 1e9 * micro[i].seconds / micro[i].iterations : 0);
+    }
+    printf("\n  ],\n");
+    printf("  \"path_loss_max_error_db\": %g\n}\n", path_loss_max_error());
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+/**
+ * @file    channels.c
+ * @brief   Per-channel transmitter occupancy index
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "channels.h"
+#include "mcu_emulation.h"
+#include "simulation.h"
+
+#define CHANNEL_INITIAL_CAPACITY 4
+// Shorter channel lists are scanned without looking at the spatial grid,
+// counting its cells costs about as much
+#define CHANNEL_SCAN_MIN 32
+
+int initialize_channel_index(struct Simulation* sim) {
+    struct Channel_Occupancy* channel_index = malloc(sizeof(struct Channel_Occupancy) * sim->settings.channels);
+    if (channel_index == NULL) {
+        printf("Channel index memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < sim->settings.channels; i++) {
+        channel_index[i].transmitter_count = 0;
+        channel_index[i].capacity = CHANNEL_INITIAL_CAPACITY;
+        channel_index[i].transmitters = malloc(sizeof(int) * CHANNEL_INITIAL_CAPACITY);
+        if (channel_index[i].transmitters == NULL) {
+            printf("Channel index memory allocation error\n");
+            exit(0);
+        }
+    }
+    sim->channel_index = channel_index;
+
+    // One waiter list per channel, then one for nodes waiting on any channel
+    struct Channel_Waiters* waiters = malloc(sizeof(struct Channel_Waiters) * (sim->settings.channels + 1));
+    if (waiters == NULL) {
+        printf("Channel index memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i <= sim->settings.channels; i++) {
+        waiters[i].count = 0;
+        waiters[i].capacity = CHANNEL_INITIAL_CAPACITY;
+        waiters[i].nodes = malloc(sizeof(int) * CHANNEL_INITIAL_CAPACITY);
+        if (waiters[i].nodes == NULL) {
+            printf("Channel index memory allocation error\n");
+            exit(0);
+        }
+    }
+    sim->channel_waiters = waiters;
+    return 0;
+}
+
+int free_channel_index(struct Simulation* sim) {
+    for (int i = 0; i < sim->settings.channels; i++) {
+        free(sim->channel_index[i].transmitters);
+    }
+    free(sim->channel_index);
+    sim->channel_index = NULL;
+    for (int i = 0; i <= sim->settings.channels; i++) {
+        free(sim->channel_waiters[i].nodes);
+    }
+    free(sim->channel_waiters);
+    sim->channel_waiters = NULL;
+    return 0;
+}
+
+static struct Channel_Waiters* channel_waiters(struct Simulation* sim, int channel) {
+    return &sim->channel_waiters[channel == CHANNEL_WAIT_ANY ? sim->settings.channels : channel];
+}
+
+static void channel_waiters_add(struct Simulation* sim, int id) {
+    struct Channel_Waiters* waiters = channel_waiters(sim, sim->nodes[id].wait_channel);
+    if (waiters->count == waiters->capacity) {
+        waiters->capacity *= 2;
+        waiters->nodes = realloc(waiters->nodes, sizeof(int) * waiters->capacity);
+        if (waiters->nodes == NULL) {
+            printf("Channel index memory allocation error\n");
+            exit(0);
+        }
+    }
+    sim->nodes[id].wait_slot = waiters->count;
+    waiters->nodes[waiters->count++] = id;
+}
+
+// Every node waiting on the list is due next cycle
+static void channel_waiters_wake(struct Simulation* sim, struct Channel_Waiters* waiters) {
+    for (int i = 0; i < waiters->count; i++) {
+        sim->nodes[waiters->nodes[i]].wait_channel = CHANNEL_WAIT_NONE;
+        mcu_wake(sim, waiters->nodes[i]);
+    }
+    waiters->count = 0;
+}
+
+// No transmitter besides id on channel, or on any channel with CHANNEL_WAIT_ANY
+static int channel_quiet(struct Simulation* sim, int channel, int id) {
+    if (channel != CHANNEL_WAIT_ANY) {
+        return channel_transmitters(sim, channel, id) == 0;
+    }
+    for (int i = 0; i < sim->settings.channels; i++) {
+        if (channel_transmitters(sim, i, id) > 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int channel_index_add(struct Simulation* sim, int channel, int id) {
+    struct Channel_Occupancy* occupancy = &sim->channel_index[channel];
+    if (occupancy->transmitter_count == occupancy->capacity) {
+        occupancy->capacity *= 2;
+        occupancy->transmitters = realloc(occupancy->transmitters, sizeof(int) * occupancy->capacity);
+        if (occupancy->transmitters == NULL) {
+            printf("Channel index memory allocation error\n");
+            exit(0);
+        }
+    }
+    occupancy->transmitters[occupancy->transmitter_count++] = id;
+
+    // Worker threads wake waiters when the index is rebuilt
+    if (sim->node_views == NULL) {
+        channel_waiters_wake(sim, &sim->channel_waiters[channel]);
+        channel_waiters_wake(sim, &sim->channel_waiters[sim->settings.channels]);
+    }
+    return 0;
+}
+
+int channel_index_remove(struct Simulation* sim, int channel, int id) {
+    struct Channel_Occupancy* occupancy = &sim->channel_index[channel];
+    for (int i = 0; i < occupancy->transmitter_count; i++) {
+        if (occupancy->transmitters[i] == id) {
+            // order doesn't matter, move last entry into the gap
+            occupancy->transmitters[i] = occupancy->transmitters[--occupancy->transmitter_count];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Channel index rebuild
+ * Desc: Rebuilds the index and waiter lists from scratch, used when nodes
+ *       update in parallel and after a checkpoint is restored. Neither has
+ *       an engine queue to move woken nodes in, so waiters on a channel that
+ *       is busy now just get a wake-up cycle of the next cycle.
+**/
+int channel_index_rebuild(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
+
+    for (int i = 0; i < sim->settings.channels; i++) {
+        sim->channel_index[i].transmitter_count = 0;
+    }
+    for (int i = 0; i <= sim->settings.channels; i++) {
+        sim->channel_waiters[i].count = 0;
+    }
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        if (nodes[i].transmit_active == 1) {
+            channel_index_add(sim, nodes[i].active_channel, i);
+        }
+    }
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        if (nodes[i].wait_channel == CHANNEL_WAIT_NONE) {
+            continue;
+        }
+        if (!channel_quiet(sim, nodes[i].wait_channel, i)) {
+            nodes[i].wait_channel = CHANNEL_WAIT_NONE;
+            nodes[i].wake_cycle = sim->state.current_cycle + 1;
+        }
+        else if (sim->node_views == NULL) {
+            channel_waiters_add(sim, i);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Channel wait
+ * Desc: Listening MCU functions poll their channel with check_channel_busy
+ *       or receive. While nothing transmits on it (on any channel with
+ *       CHANNEL_WAIT_ANY) every poll comes back empty, so instead the node
+ *       sleeps until a transmitter starts there or until wake_cycle,
+ *       whichever is first. Call it after queuing the next poll.
+ *
+ * Returns: 1 if the node is waiting, 0 if the channel is busy and polling
+ *          carries on as before
+**/
+int channel_wait(struct Simulation* sim, int id, int channel, unsigned long wake_cycle) {
+    struct Node* nodes = sim->nodes;
+    if (wake_cycle <= nodes[id].wake_cycle || !channel_quiet(sim, channel, id)) {
+        return 0;
+    }
+    nodes[id].wake_cycle = wake_cycle;
+    nodes[id].wait_channel = channel;
+    // Worker threads can't share the lists, the rebuild wakes their nodes
+    if (sim->node_views == NULL) {
+        channel_waiters_add(sim, id);
+    }
+    return 1;
+}
+
+// Node woke up without a transmitter starting, take it off its waiter list
+int channel_wait_cancel(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
+    if (sim->node_views == NULL) {
+        struct Channel_Waiters* waiters = channel_waiters(sim, nodes[id].wait_channel);
+        int moved = waiters->nodes[--waiters->count];
+        waiters->nodes[nodes[id].wait_slot] = moved;
+        nodes[moved].wait_slot = nodes[id].wait_slot;
+    }
+    nodes[id].wait_channel = CHANNEL_WAIT_NONE;
+    return 0;
+}
+
+// Number of nodes transmitting on channel, not counting exclude_id
+int channel_transmitters(struct Simulation* sim, int channel, int exclude_id) {
+    struct Channel_Occupancy* occupancy = &sim->channel_index[channel];
+    int count = occupancy->transmitter_count;
+    for (int i = 0; i < occupancy->transmitter_count; i++) {
+        if (occupancy->transmitters[i] == exclude_id) {
+            count--;
+        }
+    }
+    return count;
+}
+
+// Transmitters one receiver can hear on a channel
+struct Audible_Scan {
+    int receiver;
+    int channel;
+    struct Signal_Peak* peak;       // signals are updated when set
+    int count;
+    int last;
+    int heard[PATH_LOSS_BATCH];     // signals left to update
+    int heard_count;
+};
+
+// Counts transmitter if it's within its radio range of the receiver
+static void audible_check(struct Simulation* sim, int transmitter, struct Audible_Scan* scan) {
+    double dx = NODE_KIN(sim, scan->receiver, x_pos) - NODE_KIN(sim, transmitter, x_pos);
+    double dy = NODE_KIN(sim, scan->receiver, y_pos) - NODE_KIN(sim, transmitter, y_pos);
+    double dz = NODE_KIN(sim, scan->receiver, z_pos) - NODE_KIN(sim, transmitter, z_pos);
+    if (dx * dx + dy * dy + dz * dz > sim->grid.range_squared[transmitter]) {
+        return;
+    }
+    scan->count++;
+    if (transmitter > scan->last) {
+        scan->last = transmitter;
+    }
+    if (scan->peak != NULL) {
+        scan->heard[scan->heard_count++] = transmitter;
+        if (scan->heard_count == PATH_LOSS_BATCH) {
+            update_signals(sim, scan->receiver, scan->channel, scan->heard, scan->heard_count, scan->peak);
+            scan->heard_count = 0;
+        }
+    }
+}
+
+static void audible_visit(struct Simulation* sim, int id, void* context) {
+    struct Audible_Scan* scan = context;
+    if (id != scan->receiver && peer_transmit_active(sim, id) && peer_active_channel(sim, id) == scan->channel) {
+        audible_check(sim, id, scan);
+    }
+}
+
+/**
+ * Channel audible transmitters
+ * Desc: Like channel_transmitters() but only counting transmitters within
+ *       radio range of receiver, needs the spatial grid. Whichever is
+ *       smaller is scanned, the channel's transmitters or the receiver's
+ *       neighbor list (nodes in grid cells around it without neighbor
+ *       lists), so the cost follows local density. With peak set the
+ *       receiver's signal from each one is updated, the strongest going in
+ *       peak.
+ *
+ * Returns: number of transmitters heard, last is set to the highest id
+ *          heard (-1 if none)
+**/
+int channel_audible_transmitters(struct Simulation* sim, int channel, int receiver, struct Signal_Peak* peak,
+                                 int* last) {
+    struct Channel_Occupancy* occupancy = &sim->channel_index[channel];
+    struct Audible_Scan scan = {receiver, channel, peak, 0, -1, {0}, 0};
+    double x = NODE_KIN(sim, receiver, x_pos);
+    double y = NODE_KIN(sim, receiver, y_pos);
+    double z = NODE_KIN(sim, receiver, z_pos);
+
+    int scanned = 0;
+    if (sim->neighbors.enabled) {
+        struct Neighbor_Lists* lists = &sim->neighbors;
+        if (lists->start[receiver + 1] - lists->start[receiver] < occupancy->transmitter_count) {
+            for (int j = lists->start[receiver]; j < lists->start[receiver + 1]; j++) {
+                audible_visit(sim, lists->peers[j], &scan);
+            }
+            scanned = 1;
+        }
+    }
+    else if (occupancy->transmitter_count > CHANNEL_SCAN_MIN &&
+             occupancy->transmitter_count > spatial_grid_count(&sim->grid, x, y, z, sim->grid.range)) {
+        scanned = spatial_grid_visit(sim, x, y, z, sim->grid.range, audible_visit, &scan) == 0;
+    }
+    if (!scanned) {
+        for (int j = 0; j < occupancy->transmitter_count; j++) {
+            if (occupancy->transmitters[j] != receiver) {
+                audible_check(sim, occupancy->transmitters[j], &scan);
+            }
+        }
+    }
+    if (scan.heard_count > 0) {
+        update_signals(sim, receiver, channel, scan.heard, scan.heard_count, peak);
+    }
+    if (last != NULL) {
+        *last = scan.last;
+    }
+    return scan.count;
+}
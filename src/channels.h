@@ -0,0 +1,45 @@
+/**
+ * @file    channels.h
+ * @brief   Per-channel transmitter occupancy index
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "node.h"
+
+#ifndef channels_H
+#define channels_H
+
+// Nodes currently transmitting on one channel
+struct Channel_Occupancy {
+    int transmitter_count;
+    int capacity;
+    int* transmitters;
+};
+
+// Node wait_channel values besides a channel number
+#define CHANNEL_WAIT_NONE   -1
+#define CHANNEL_WAIT_ANY    -2
+
+// Nodes sleeping until a transmitter starts on one channel, see channel_wait()
+struct Channel_Waiters {
+    int count;
+    int capacity;
+    int* nodes;
+};
+
+struct Simulation;
+
+int initialize_channel_index(struct Simulation* sim);
+int free_channel_index(struct Simulation* sim);
+int channel_index_add(struct Simulation* sim, int channel, int id);
+int channel_index_remove(struct Simulation* sim, int channel, int id);
+int channel_index_rebuild(struct Simulation* sim);
+int channel_wait(struct Simulation* sim, int id, int channel, unsigned long wake_cycle);
+int channel_wait_cancel(struct Simulation* sim, int id);
+int channel_transmitters(struct Simulation* sim, int channel, int exclude_id);
+int channel_audible_transmitters(struct Simulation* sim, int channel, int receiver, struct Signal_Peak* peak,
+                                 int* last);
+
+#endif
@@ -0,0 +1,629 @@
+/**
+ * @file    checkpoint.c
+ * @brief   Binary checkpoint and restore of a whole simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "channels.h"
+#include "checkpoint.h"
+#include "simulation.h"
+
+/**
+ * Layout, all values in native byte order:
+ *   header      magic, version, node/channel/group/sensor counts,
+ *               time resolution, seed, RNG key
+ *   state       counters and clock, start_time isn't kept
+ *   ground      counters, position, per channel message flags
+ *   nodes       kinematics, scalar fields, arrays, the call/return stacks
+ *               as a depth and their elements bottom up, armed cycle timers
+ *               as a count and (function, label, start, expiration) each,
+ *               then the relay queue as a count, its drop counter and each
+ *               message oldest first.
+ *               Sensor readings are written field by field, packets (the
+ *               node's send_packet and each stored message) as a frame
+ *               length and its bytes, 0 for none
+ *   signals     for each receiver a count and (transmitter, dBm) for every
+ *               nonzero signal it has stored, whatever the signal store
+ *               layout and format
+ *   holds       for each node a count of the receivers its transmission's
+ *               interference is held in (-1 when it isn't, always without
+ *               sinr), then its channel, the receivers and the mW held
+ *               for each
+ * Channel occupancy, the MCU wheel/event queue and worker views are rebuilt
+ * from the node fields on restore.
+**/
+
+#define WRITE_VALUE(fp, value) fwrite(&(value), sizeof(value), 1, (fp))
+#define WRITE_ARRAY(fp, array, count) fwrite((array), sizeof(*(array)), (count), (fp))
+#define READ_VALUE(fp, value, ok) read_block((fp), &(value), sizeof(value), 1, (ok))
+#define READ_ARRAY(fp, array, count, ok) read_block((fp), (array), sizeof(*(array)), (count), (ok))
+
+// Fields a checkpoint has to agree with the settings on, they size the
+// node arrays or set what a cycle means
+struct Checkpoint_Header {
+    uint32_t version;
+    int node_count;
+    int channels;
+    int group_max;
+    int sensor_count;
+    double time_resolution;
+    int random_seed;
+    struct RNG rng;
+};
+
+// Short reads clear ok and make every later read a no-op, so a truncated
+// checkpoint only needs checking once at the end
+static void read_block(FILE* fp, void* out, size_t size, size_t count, int* ok) {
+    if (*ok && fread(out, size, count, fp) != count) {
+        *ok = 0;
+    }
+}
+
+static void write_header(FILE* fp, struct Simulation* sim) {
+    uint32_t version = CHECKPOINT_VERSION;
+
+    fwrite(CHECKPOINT_MAGIC, 1, strlen(CHECKPOINT_MAGIC), fp);
+    WRITE_VALUE(fp, version);
+    WRITE_VALUE(fp, sim->settings.node_count);
+    WRITE_VALUE(fp, sim->settings.channels);
+    WRITE_VALUE(fp, sim->settings.group_max);
+    WRITE_VALUE(fp, sim->settings.sensor_count);
+    WRITE_VALUE(fp, sim->settings.time_resolution);
+    WRITE_VALUE(fp, sim->settings.random_seed);
+    WRITE_VALUE(fp, sim->rng);
+}
+
+static int read_header(FILE* fp, struct Checkpoint_Header* header) {
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {0};
+    int ok = 1;
+
+    read_block(fp, magic, 1, strlen(CHECKPOINT_MAGIC), &ok);
+    if (!ok || strcmp(magic, CHECKPOINT_MAGIC) != 0) {
+        fprintf(stderr, "Not a simulation checkpoint\n");
+        return 1;
+    }
+    READ_VALUE(fp, header->version, &ok);
+    if (ok && header->version != CHECKPOINT_VERSION) {
+        fprintf(stderr, "Checkpoint version %u, expected %d\n", header->version, CHECKPOINT_VERSION);
+        return 1;
+    }
+    READ_VALUE(fp, header->node_count, &ok);
+    READ_VALUE(fp, header->channels, &ok);
+    READ_VALUE(fp, header->group_max, &ok);
+    READ_VALUE(fp, header->sensor_count, &ok);
+    READ_VALUE(fp, header->time_resolution, &ok);
+    READ_VALUE(fp, header->random_seed, &ok);
+    READ_VALUE(fp, header->rng, &ok);
+    if (!ok) {
+        fprintf(stderr, "Checkpoint truncated\n");
+        return 1;
+    }
+    return 0;
+}
+
+static void write_reading(FILE* fp, const struct Sensor_Reading* reading) {
+    WRITE_VALUE(fp, reading->type);
+    WRITE_VALUE(fp, reading->value_count);
+    WRITE_ARRAY(fp, reading->values, SENSOR_MAX_VALUES);
+}
+
+static void read_reading(FILE* fp, struct Sensor_Reading* reading, int* ok) {
+    READ_VALUE(fp, reading->type, ok);
+    READ_VALUE(fp, reading->value_count, ok);
+    READ_ARRAY(fp, reading->values, SENSOR_MAX_VALUES, ok);
+    if (*ok && (reading->value_count < 0 || reading->value_count > SENSOR_MAX_VALUES)) {
+        *ok = 0;
+    }
+}
+
+static void write_packet(FILE* fp, struct Simulation* sim, int handle) {
+    int length = 0;
+    if (handle != PACKET_NONE) {
+        length = packet_slot(&sim->packets, handle)->length;
+    }
+    WRITE_VALUE(fp, length);
+    if (length > 0) {
+        WRITE_ARRAY(fp, packet_slot(&sim->packets, handle)->frame, length);
+    }
+}
+
+// Packets come back in slots of their own, packets that were shared are
+// restored as separate copies
+static int read_packet(FILE* fp, struct Simulation* sim, int* ok) {
+    int length = 0;
+    unsigned char frame[PACKET_MAX_SIZE];
+    READ_VALUE(fp, length, ok);
+    if (*ok && (length < 0 || length > PACKET_MAX_SIZE)) {
+        *ok = 0;
+    }
+    if (!*ok || length == 0) {
+        return PACKET_NONE;
+    }
+    READ_ARRAY(fp, frame, length, ok);
+    return *ok ? packet_slab_store(&sim->packets, frame, length) : PACKET_NONE;
+}
+
+static void write_node(FILE* fp, struct Simulation* sim, int id) {
+    struct Node* node = &sim->nodes[id];
+    double kinematics[10] = {
+        NODE_KIN(sim, id, terminal_velocity),
+        NODE_KIN(sim, id, x_pos),
+        NODE_KIN(sim, id, y_pos),
+        NODE_KIN(sim, id, z_pos),
+        NODE_KIN(sim, id, x_velocity),
+        NODE_KIN(sim, id, y_velocity),
+        NODE_KIN(sim, id, z_velocity),
+        NODE_KIN(sim, id, x_acceleration),
+        NODE_KIN(sim, id, y_acceleration),
+        NODE_KIN(sim, id, z_acceleration)
+    };
+    int count;
+
+    WRITE_ARRAY(fp, kinematics, 10);
+    WRITE_VALUE(fp, node->power_output);
+    WRITE_VALUE(fp, node->transmit_active);
+    WRITE_VALUE(fp, node->active_channel);
+    WRITE_VALUE(fp, node->current_function);
+    WRITE_VALUE(fp, node->busy_pending);
+    WRITE_VALUE(fp, node->wake_cycle);
+    WRITE_VALUE(fp, node->wait_channel);
+    WRITE_ARRAY(fp, node->group_list, sim->settings.group_max);
+    write_packet(fp, sim, node->send_packet);
+    WRITE_VALUE(fp, node->packet_seq);
+    WRITE_ARRAY(fp, node->tmp_lfg_chans, sim->settings.channels);
+    WRITE_ARRAY(fp, node->tmp_scanned_chans, sim->settings.channels);
+    WRITE_VALUE(fp, node->tmp_start_time);
+    WRITE_VALUE(fp, node->dest_node);
+    WRITE_VALUE(fp, node->broadcaster);
+    WRITE_VALUE(fp, node->group_cycle_start);
+    for (int i = 0; i < sim->settings.sensor_count; i++) {
+        write_reading(fp, &node->sensors[i]);
+    }
+
+    // Call/return stacks, bottom element first
+    count = node->function_stack - node->function_stack_base + 1;
+    WRITE_VALUE(fp, count);
+    WRITE_ARRAY(fp, node->function_stack_base, count);
+    count = node->return_stack - node->return_stack_base + 1;
+    WRITE_VALUE(fp, count);
+    WRITE_ARRAY(fp, node->return_stack_base, count);
+
+    // Armed cycle timers
+    count = 0;
+    for (int i = 0; i < CYCLE_TIMER_SLOTS; i++) {
+        count += node->timers[i].armed;
+    }
+    WRITE_VALUE(fp, count);
+    for (int i = 0; i < CYCLE_TIMER_SLOTS; i++) {
+        if (node->timers[i].armed) {
+            int function = i / CYCLE_TIMER_LABELS;
+            int label = i % CYCLE_TIMER_LABELS;
+            WRITE_VALUE(fp, function);
+            WRITE_VALUE(fp, label);
+            WRITE_VALUE(fp, node->timers[i].start);
+            WRITE_VALUE(fp, node->timers[i].expiration);
+        }
+    }
+
+    // Relay queue
+    WRITE_VALUE(fp, node->relay_queue.count);
+    WRITE_VALUE(fp, node->relay_queue.dropped);
+    for (int i = 0; i < node->relay_queue.count; i++) {
+        struct stored_message* message = relay_queue_at(&node->relay_queue, i);
+        WRITE_VALUE(fp, message->sender);
+        write_packet(fp, sim, message->packet);
+    }
+}
+
+// After every node so the triangular layout has the transmitter powers
+static void write_signals(FILE* fp, struct Simulation* sim) {
+    int n = sim->settings.node_count;
+    double* row = malloc(sizeof(double) * n);
+    if (row == NULL) {
+        printf("Checkpoint memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        signal_row(sim, i, row);
+        for (int j = 0; j < n; j++) {
+            count += row[j] != 0;
+        }
+        WRITE_VALUE(fp, count);
+        for (int j = 0; j < n; j++) {
+            if (row[j] != 0) {
+                WRITE_VALUE(fp, j);
+                WRITE_VALUE(fp, row[j]);
+            }
+        }
+    }
+    free(row);
+}
+
+static void read_signals(FILE* fp, struct Simulation* sim, int* ok) {
+    int n = sim->settings.node_count;
+    for (int i = 0; *ok && i < n; i++) {
+        int count = 0;
+        READ_VALUE(fp, count, ok);
+        for (int j = 0; *ok && j < count; j++) {
+            int transmitter = -1;
+            double value = 0;
+            READ_VALUE(fp, transmitter, ok);
+            READ_VALUE(fp, value, ok);
+            if (*ok && (transmitter < 0 || transmitter >= n)) {
+                *ok = 0;
+            }
+            if (*ok) {
+                set_signal(sim, i, transmitter, value);
+            }
+        }
+    }
+}
+
+static void write_interference(FILE* fp, struct Simulation* sim) {
+    struct Interference* interference = &sim->interference;
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        int count = -1;
+        if (!interference->enabled || interference->hold[i] == -1) {
+            WRITE_VALUE(fp, count);
+            continue;
+        }
+        struct Interference_Hold* hold = &interference->holds[interference->hold[i]];
+        WRITE_VALUE(fp, hold->count);
+        WRITE_VALUE(fp, hold->channel);
+        WRITE_ARRAY(fp, hold->receivers, hold->count);
+        WRITE_ARRAY(fp, hold->power, hold->count);
+    }
+}
+
+// Holds from a run without sinr are skipped, transmitters without one are
+// started from current positions once the spatial grid is up
+static void read_interference(FILE* fp, struct Simulation* sim, int* ok) {
+    int n = sim->settings.node_count;
+    int* receivers = malloc(sizeof(int) * (n > 0 ? n : 1));
+    double* power = malloc(sizeof(double) * (n > 0 ? n : 1));
+    if (receivers == NULL || power == NULL) {
+        printf("Checkpoint memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; *ok && i < n; i++) {
+        int count = -1;
+        int channel = -1;
+        READ_VALUE(fp, count, ok);
+        if (!*ok || count == -1) {
+            continue;
+        }
+        READ_VALUE(fp, channel, ok);
+        if (*ok && (count < 0 || count > n || channel < 0 || channel >= sim->settings.channels)) {
+            *ok = 0;
+        }
+        READ_ARRAY(fp, receivers, count, ok);
+        READ_ARRAY(fp, power, count, ok);
+        for (int j = 0; *ok && j < count; j++) {
+            if (receivers[j] < 0 || receivers[j] >= n) {
+                *ok = 0;
+            }
+        }
+        if (*ok) {
+            interference_restore(sim, i, channel, receivers, power, count);
+        }
+    }
+    free(receivers);
+    free(power);
+}
+
+static void read_node(FILE* fp, struct Simulation* sim, int id, int* ok) {
+    struct Node* node = &sim->nodes[id];
+    double kinematics[10];
+    int count;
+
+    READ_ARRAY(fp, kinematics, 10, ok);
+    NODE_KIN(sim, id, terminal_velocity) = kinematics[0];
+    NODE_KIN(sim, id, x_pos) = kinematics[1];
+    NODE_KIN(sim, id, y_pos) = kinematics[2];
+    NODE_KIN(sim, id, z_pos) = kinematics[3];
+    NODE_KIN(sim, id, x_velocity) = kinematics[4];
+    NODE_KIN(sim, id, y_velocity) = kinematics[5];
+    NODE_KIN(sim, id, z_velocity) = kinematics[6];
+    NODE_KIN(sim, id, x_acceleration) = kinematics[7];
+    NODE_KIN(sim, id, y_acceleration) = kinematics[8];
+    NODE_KIN(sim, id, z_acceleration) = kinematics[9];
+    READ_VALUE(fp, node->power_output, ok);
+    READ_VALUE(fp, node->transmit_active, ok);
+    READ_VALUE(fp, node->active_channel, ok);
+    READ_VALUE(fp, node->current_function, ok);
+    READ_VALUE(fp, node->busy_pending, ok);
+    READ_VALUE(fp, node->wake_cycle, ok);
+    READ_VALUE(fp, node->wait_channel, ok);
+    if (*ok && (node->wait_channel < CHANNEL_WAIT_ANY || node->wait_channel >= sim->settings.channels)) {
+        *ok = 0;
+    }
+    READ_ARRAY(fp, node->group_list, sim->settings.group_max, ok);
+    packet_unref(&sim->packets, node->send_packet);
+    node->send_packet = read_packet(fp, sim, ok);
+    READ_VALUE(fp, node->packet_seq, ok);
+    READ_ARRAY(fp, node->tmp_lfg_chans, sim->settings.channels, ok);
+    READ_ARRAY(fp, node->tmp_scanned_chans, sim->settings.channels, ok);
+    READ_VALUE(fp, node->tmp_start_time, ok);
+    READ_VALUE(fp, node->dest_node, ok);
+    READ_VALUE(fp, node->broadcaster, ok);
+    READ_VALUE(fp, node->group_cycle_start, ok);
+    for (int i = 0; i < sim->settings.sensor_count; i++) {
+        read_reading(fp, &node->sensors[i], ok);
+    }
+
+    // Call/return stacks
+    count = 0;
+    READ_VALUE(fp, count, ok);
+    if (*ok && (count < 1 || count > MCU_STACK_DEPTH)) {
+        *ok = 0;
+    }
+    READ_ARRAY(fp, node->function_stack_base, count, ok);
+    node->function_stack = node->function_stack_base + (*ok ? count - 1 : 0);
+    count = 0;
+    READ_VALUE(fp, count, ok);
+    if (*ok && (count < 1 || count > MCU_STACK_DEPTH)) {
+        *ok = 0;
+    }
+    READ_ARRAY(fp, node->return_stack_base, count, ok);
+    node->return_stack = node->return_stack_base + (*ok ? count - 1 : 0);
+
+    // Armed cycle timers
+    for (int i = 0; i < CYCLE_TIMER_SLOTS; i++) {
+        node->timers[i].armed = 0;
+    }
+    count = 0;
+    READ_VALUE(fp, count, ok);
+    for (int i = 0; *ok && i < count; i++) {
+        int function = -1;
+        int label = -1;
+        unsigned long start = 0;
+        unsigned long expiration = 0;
+        READ_VALUE(fp, function, ok);
+        READ_VALUE(fp, label, ok);
+        READ_VALUE(fp, start, ok);
+        READ_VALUE(fp, expiration, ok);
+        if (*ok && (function < 0 || function >= CYCLE_TIMER_FUNCTIONS || 
+            label < 0 || label >= CYCLE_TIMER_LABELS)) {
+            *ok = 0;
+        }
+        if (*ok) {
+            cycle_timer_arm(node->timers, function, label, start, expiration);
+        }
+    }
+
+    // Relay queue, messages go back through the overflow policy in case
+    // this run has a smaller queue than the checkpointed one
+    unsigned long dropped = 0;
+    struct stored_message message;
+    while (relay_queue_pop(&node->relay_queue, &message) == 0) {
+        packet_unref(&sim->packets, message.packet);
+    }
+    node->relay_queue.dropped = 0;
+    count = 0;
+    READ_VALUE(fp, count, ok);
+    READ_VALUE(fp, dropped, ok);
+    for (int i = 0; *ok && i < count; i++) {
+        int sender = -1;
+        READ_VALUE(fp, sender, ok);
+        int packet = read_packet(fp, sim, ok);
+        if (relay_queue_push(&node->relay_queue, sim->settings.relay_overflow, sender, packet, &message)) {
+            packet_unref(&sim->packets, message.packet);
+            sim->state.relay_drops++;
+        }
+    }
+    node->relay_queue.dropped += dropped;
+}
+
+/**
+ * Checkpoint capture
+ * Desc: Serializes everything needed to carry on the simulation from its
+ *       current cycle into an in memory checkpoint
+**/
+int checkpoint_capture(struct Simulation* sim, struct Checkpoint* checkpoint) {
+    checkpoint->data = NULL;
+    checkpoint->size = 0;
+    FILE* fp = open_memstream(&checkpoint->data, &checkpoint->size);
+    if (fp == NULL) {
+        perror("open_memstream");
+        return 1;
+    }
+
+    write_header(fp, sim);
+
+    WRITE_VALUE(fp, sim->state.moving_nodes);
+    WRITE_VALUE(fp, sim->state.current_time);
+    WRITE_VALUE(fp, sim->state.collisions);
+    WRITE_VALUE(fp, sim->state.current_cycle);
+    WRITE_VALUE(fp, sim->state.sent_messages);
+    WRITE_VALUE(fp, sim->state.group_joins);
+    WRITE_VALUE(fp, sim->state.relay_drops);
+    WRITE_VALUE(fp, sim->state.sinr_captures);
+
+    WRITE_VALUE(fp, sim->ground.messages_received);
+    WRITE_VALUE(fp, sim->ground.collisions_detected);
+    WRITE_VALUE(fp, sim->ground.x_pos);
+    WRITE_VALUE(fp, sim->ground.y_pos);
+    WRITE_VALUE(fp, sim->ground.z_pos);
+    WRITE_ARRAY(fp, sim->ground.new_message_available, sim->settings.channels);
+
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        write_node(fp, sim, i);
+    }
+    write_signals(fp, sim);
+    write_interference(fp, sim);
+
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed) {
+        fprintf(stderr, "Unable to write checkpoint\n");
+        free(checkpoint->data);
+        checkpoint->data = NULL;
+        checkpoint->size = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Checkpoint compatibility
+ * Desc: Checks a checkpoint can be restored with settings. Anything else in
+ *       settings may differ, which is how branches get their own protocol
+ *       settings. Fields only read when nodes are created (start position,
+ *       terminal velocity, power output, sensor types) keep their
+ *       checkpointed values.
+**/
+int checkpoint_check(const struct Checkpoint* checkpoint, const struct Settings* settings) {
+    struct Checkpoint_Header header;
+    FILE* fp = fmemopen(checkpoint->data, checkpoint->size, "rb");
+    if (fp == NULL) {
+        perror("fmemopen");
+        return 1;
+    }
+    int ret = read_header(fp, &header);
+    fclose(fp);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (header.node_count != settings->node_count) {
+        fprintf(stderr, "Checkpoint has %d nodes, settings have %d\n",
+            header.node_count, settings->node_count);
+        return 1;
+    }
+    if (header.channels != settings->channels) {
+        fprintf(stderr, "Checkpoint has %d channels, settings have %d\n",
+            header.channels, settings->channels);
+        return 1;
+    }
+    if (header.group_max != settings->group_max) {
+        fprintf(stderr, "Checkpoint has group_max %d, settings have %d\n",
+            header.group_max, settings->group_max);
+        return 1;
+    }
+    if (header.sensor_count != settings->sensor_count) {
+        fprintf(stderr, "Checkpoint has %d sensors, settings have %d\n",
+            header.sensor_count, settings->sensor_count);
+        return 1;
+    }
+    if (header.time_resolution != settings->time_resolution) {
+        fprintf(stderr, "Checkpoint time resolution is %f, settings have %f\n",
+            header.time_resolution, settings->time_resolution);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Checkpoint apply
+ * Desc: Overwrites a freshly created simulation with a checkpoint. The RNG
+ *       key is only restored when the seed matches the checkpoint, so runs
+ *       branched with another seed diverge from the checkpointed cycle on.
+ *       The engine has to be set up after this since it schedules from the
+ *       restored cycle.
+**/
+int checkpoint_apply(struct Simulation* sim, const struct Checkpoint* checkpoint) {
+    struct Checkpoint_Header header;
+    int ok = 1;
+
+    if (checkpoint_check(checkpoint, &sim->settings) != 0) {
+        return 1;
+    }
+    FILE* fp = fmemopen(checkpoint->data, checkpoint->size, "rb");
+    if (fp == NULL) {
+        perror("fmemopen");
+        return 1;
+    }
+    read_header(fp, &header);
+    if (header.random_seed == sim->settings.random_seed) {
+        sim->rng = header.rng;
+    }
+
+    READ_VALUE(fp, sim->state.moving_nodes, &ok);
+    READ_VALUE(fp, sim->state.current_time, &ok);
+    READ_VALUE(fp, sim->state.collisions, &ok);
+    READ_VALUE(fp, sim->state.current_cycle, &ok);
+    READ_VALUE(fp, sim->state.sent_messages, &ok);
+    READ_VALUE(fp, sim->state.group_joins, &ok);
+    READ_VALUE(fp, sim->state.relay_drops, &ok);
+    READ_VALUE(fp, sim->state.sinr_captures, &ok);
+
+    READ_VALUE(fp, sim->ground.messages_received, &ok);
+    READ_VALUE(fp, sim->ground.collisions_detected, &ok);
+    READ_VALUE(fp, sim->ground.x_pos, &ok);
+    READ_VALUE(fp, sim->ground.y_pos, &ok);
+    READ_VALUE(fp, sim->ground.z_pos, &ok);
+    READ_ARRAY(fp, sim->ground.new_message_available, sim->settings.channels, &ok);
+
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        read_node(fp, sim, i, &ok);
+    }
+    read_signals(fp, sim, &ok);
+    read_interference(fp, sim, &ok);
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "Checkpoint truncated\n");
+        return 1;
+    }
+
+    channel_index_rebuild(sim);
+    return 0;
+}
+
+int checkpoint_save(const struct Checkpoint* checkpoint, const char* path) {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t written = fwrite(checkpoint->data, 1, checkpoint->size, fp);
+    if (fclose(fp) != 0 || written != checkpoint->size) {
+        fprintf(stderr, "Unable to write checkpoint \"%s\"\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+int checkpoint_load(struct Checkpoint* checkpoint, const char* path) {
+    checkpoint->data = NULL;
+    checkpoint->size = 0;
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        perror(path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        fprintf(stderr, "Checkpoint \"%s\" is empty\n", path);
+        fclose(fp);
+        return 1;
+    }
+
+    checkpoint->data = malloc(size);
+    if (checkpoint->data == NULL) {
+        printf("Checkpoint memory allocation error\n");
+        exit(0);
+    }
+    checkpoint->size = fread(checkpoint->data, 1, size, fp);
+    fclose(fp);
+    if (checkpoint->size != (size_t)size) {
+        fprintf(stderr, "Unable to read checkpoint \"%s\"\n", path);
+        checkpoint_free(checkpoint);
+        return 1;
+    }
+    return 0;
+}
+
+void checkpoint_free(struct Checkpoint* checkpoint) {
+    free(checkpoint->data);
+    checkpoint->data = NULL;
+    checkpoint->size = 0;
+}
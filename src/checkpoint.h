@@ -0,0 +1,33 @@
+/**
+ * @file    checkpoint.h
+ * @brief   Binary checkpoint and restore of a whole simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stddef.h>
+#include "settings.h"
+
+#ifndef checkpoint_H
+#define checkpoint_H
+
+#define CHECKPOINT_MAGIC    "DWSNCKPT"
+#define CHECKPOINT_VERSION  9
+
+// Serialized simulation, kept in memory so many runs can branch from it
+struct Checkpoint {
+    char* data;
+    size_t size;
+};
+
+struct Simulation;
+
+int checkpoint_capture(struct Simulation* sim, struct Checkpoint* checkpoint);
+int checkpoint_apply(struct Simulation* sim, const struct Checkpoint* checkpoint);
+int checkpoint_check(const struct Checkpoint* checkpoint, const struct Settings* settings);
+int checkpoint_save(const struct Checkpoint* checkpoint, const char* path);
+int checkpoint_load(struct Checkpoint* checkpoint, const char* path);
+void checkpoint_free(struct Checkpoint* checkpoint);
+
+#endif
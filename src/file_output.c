@@ -6,19 +6,22 @@
  * @date    1/3/2021
 **/
 
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
 #include "file_output.h"
+#include "channels.h"
+#include "packet.h"
+#include "simulation.h"
 #include "state.h"
 
-extern struct Settings settings;
-extern struct State state;
-
-int create_log_dir() {
-    struct tm *timenow;
+int create_log_dir(struct Simulation* sim) {
+    struct tm timenow;
     time_t now = time(NULL);
-    timenow = gmtime(&now);
-    strftime(settings.output_dir, sizeof(char) * 50, "output/run/%Y-%m-%d-%H-%M-%S", timenow);
-    if (settings.verbose) {
-        printf("Creating output directory \"%s\": ", settings.output_dir);
+    gmtime_r(&now, &timenow);
+    strftime(sim->settings.output_dir, sizeof(char) * 50, "output/run/%Y-%m-%d-%H-%M-%S", &timenow);
+    if (sim->settings.verbose) {
+        printf("Creating output directory \"%s\": ", sim->settings.output_dir);
     }
 
     // Make path for timestamped directory if it doesn't already exist
@@ -30,17 +33,23 @@ int create_log_dir() {
         mkdir("output/run", 0777);
     }
 
-    // Make directory just for this run
-    int ret = mkdir(settings.output_dir,0777); 
+    // Make directory just for this run, simulations started in the same
+    // second get a numbered suffix
+    int ret = mkdir(sim->settings.output_dir,0777); 
+    size_t base_length = strlen(sim->settings.output_dir);
+    for (int i = 1; ret != 0 && errno == EEXIST && i < 1000; i++) {
+        snprintf(sim->settings.output_dir + base_length, 50 - base_length, "-%d", i);
+        ret = mkdir(sim->settings.output_dir, 0777);
+    }
 
     // check if directory is created or not 
     if (!ret) {
-        if (settings.verbose) {
+        if (sim->settings.verbose) {
             printf("OK\n"); 
         }
     }
     else { 
-        if (settings.verbose) {
+        if (sim->settings.verbose) {
             printf("Unable to create directory, exiting\n"); 
         }
         exit(1); 
@@ -48,151 +57,251 @@ int create_log_dir() {
     return 0; 
 }
 
-int create_transmit_history_file() {
-    char file_path[100];
-    sprintf(file_path, "%s/transmit_history.txt", settings.output_dir);
-    FILE *transmit_history_file;
-    transmit_history_file = fopen (file_path, "a");
-    // Build line of output for this clock tick
-    char buffer[10];
-    sprintf(buffer, "Time\t\t");
-    fputs(buffer, transmit_history_file);
-    for (int i = 0; i < settings.channels; i++) {
-        if (i < settings.channels -1) {
-            sprintf(buffer, "%d\t", i);
-            fputs(buffer, transmit_history_file);
+// Signals go along for the text files, the trace only keeps them if asked
+static int sample_has_signals(struct Simulation* sim) {
+    return sim->settings.output_format == OUTPUT_FORMAT_TEXT || sim->settings.trace_signals;
+}
+
+/**
+ * Sample record layout, doubles first so everything stays aligned:
+ *  time, x, y, z (node count each), signals (node count rows of node count,
+ *  when kept), channel, function (node count ints each), channel active
+ *  (one char per channel)
+**/
+static size_t sample_size(struct Simulation* sim) {
+    size_t n = sim->settings.node_count;
+    size_t size = sizeof(double) * (1 + 3 * n) + sizeof(int) * 2 * n + sim->settings.channels;
+    if (sample_has_signals(sim)) {
+        size += sizeof(double) * n * n;
+    }
+    return size;
+}
+
+static void sample_view(struct Simulation* sim, unsigned char* data, struct Output_Sample* sample) {
+    size_t n = sim->settings.node_count;
+    double* d = (double*)data;
+    sample->x = d + 1;
+    sample->y = sample->x + n;
+    sample->z = sample->y + n;
+    sample->signals = sample_has_signals(sim) ? sample->z + n : NULL;
+    int* columns = (int*)(sample->z + n + (sample->signals != NULL ? n * n : 0));
+    sample->channel = columns;
+    sample->function = columns + n;
+    sample->channel_active = (char*)(columns + 2 * n);
+}
+
+/**
+ * Queue sample
+ * Desc: Copies what the output files need from the nodes into a queued
+ *       record, formatting and writing happen on the writer thread
+**/
+static void queue_sample(struct Simulation* sim, int type) {
+    struct Output_Sample sample;
+    struct Node* nodes = sim->nodes;
+    int n = sim->settings.node_count;
+    unsigned char* record = output_queue_reserve(&sim->output_queue, sample_size(sim));
+
+    sample_view(sim, record, &sample);
+    *(double*)record = sim->state.current_time;
+    for (int i = 0; i < n; i++) {
+        sample.x[i] = NODE_KIN(sim, i, x_pos);
+        sample.y[i] = NODE_KIN(sim, i, y_pos);
+        sample.z[i] = NODE_KIN(sim, i, z_pos);
+        sample.channel[i] = nodes[i].active_channel;
+        sample.function[i] = nodes[i].current_function;
+        if (sample.signals != NULL) {
+            signal_row(sim, i, sample.signals + (size_t)i * n);
+        }
+    }
+    for (int i = 0; i < sim->settings.channels; i++) {
+        sample.channel_active[i] = sim->channel_index[i].transmitter_count > 0;
+    }
+    output_queue_commit(&sim->output_queue, type);
+}
 
+// Transmit history line for a sample, an "X" for each channel something
+// was transmitting on and a "." for the rest
+static void write_transmit_history(struct Simulation* sim, const struct Output_Sample* sample) {
+    int channels = sim->settings.channels;
+    char channel_active[channels * 2 + 1];
+
+    for (int i = 0; i < channels; i++) {
+        channel_active[i * 2] = sample->channel_active[i] ? 'X' : '.';
+        channel_active[i * 2 + 1] = '\t';
+    }
+    // No tab after the last channel
+    channel_active[channels > 0 ? channels * 2 - 1 : 0] = '\0';
+
+    if (sim->settings.debug> 1) {
+        printf("Writing data to file\n");
+    }
+    output_printf(&sim->output, OUTPUT_TRANSMIT_HISTORY(sim), "%f\t%s\n", sample->time, channel_active);
+}
+
+// Formats one queued record into the output files, on the writer thread
+// when there is one
+static int output_record(void* context, int type, const unsigned char* data, size_t length) {
+    struct Simulation* sim = context;
+    struct Output_Sample sample;
+    struct Packet packet;
+
+    switch (type) {
+    case OUTPUT_RECORD_NODES:
+    case OUTPUT_RECORD_INTERVAL:
+        sample_view(sim, (unsigned char*)data, &sample);
+        sample.time = *(const double*)data;
+        if (sim->settings.output_format == OUTPUT_FORMAT_TRACE) {
+            write_trace_sample(sim, &sample);
         }
         else {
-            sprintf(buffer, "%d", i);
-            fputs(buffer, transmit_history_file);
+            for (int i = 0; i < sim->settings.node_count; i++) {
+                // output node specific info into one file per node
+                write_node_data(sim, &sample, i);
+            }
+        }
+        if (type == OUTPUT_RECORD_INTERVAL) {
+            write_transmit_history(sim, &sample);
+        }
+        break;
+    case OUTPUT_RECORD_GROUND:
+        // Same text as the old text packets
+        if (packet_decode(data, length, &packet) == 0) {
+            char readings[PACKET_TEXT_SIZE];
+            char message[PACKET_TEXT_SIZE + 16];
+            payload_format(&packet.payload, readings, sizeof(readings));
+            snprintf(message, sizeof(message), "N-%d %s ", packet.payload.origin, readings);
+            output_write(&sim->output, OUTPUT_GROUND_RECEIVED(sim), message, strlen(message));
+            output_write(&sim->output, OUTPUT_GROUND_RECEIVED(sim), "\n", 1);
         }
+        break;
     }
-    sprintf(buffer, "\n");
-    fputs(buffer, transmit_history_file);
-    fclose(transmit_history_file);
+    return 0;
+}
 
+/**
+ * Open output files
+ * Desc: Sets up the buffered writer behind every output file of the run,
+ *       files stay open (up to max_open_files descriptors) until
+ *       close_output_files()
+**/
+int open_output_files(struct Simulation* sim) {
+    int max_open = sim->settings.max_open_files;
+    if (max_open <= 0) {
+        // Leave most descriptors to everything else, sweeps run several
+        // simulations in one process
+        struct rlimit limit;
+        max_open = OUTPUT_AUTO_MAX_OPEN;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+            limit.rlim_cur / 4 < OUTPUT_AUTO_MAX_OPEN) {
+            max_open = limit.rlim_cur / 4;
+        }
+    }
+    output_writer_init(&sim->output, OUTPUT_FILE_COUNT(sim), 
+                       (size_t)sim->settings.output_buffer_kb * 1024, max_open);
+    output_queue_init(&sim->output_queue, (size_t)sim->settings.output_queue_kb * 1024,
+                      sample_size(sim) > PACKET_MAX_SIZE ? sample_size(sim) : PACKET_MAX_SIZE,
+                      output_record, sim);
     return 0;
 }
 
-int create_ground_received_file() {
-    char file_path[100];
-    sprintf(file_path, "%s/ground_received.txt", settings.output_dir);
-    FILE *ground_received_file;
-    ground_received_file = fopen (file_path, "a");
-    fclose(ground_received_file);
+// Moves writing to the writer thread when async output is on, everything
+// before this was written on the simulation thread
+int start_output_writer(struct Simulation* sim) {
+    if (sim->settings.output_async) {
+        output_queue_start(&sim->output_queue);
+    }
+    return 0;
+}
 
+// Writes out everything still queued or buffered and closes the files
+int close_output_files(struct Simulation* sim) {
+    output_queue_close(&sim->output_queue);
+    output_writer_close(&sim->output);
+    free_trace(sim);
     return 0;
 }
 
-int log_ground_received_message(char* message, int length) {
-    // Open file for writing
+// One file per node, starting with the node's current data. The binary
+// trace replaces them when it's the output format.
+int create_node_files(struct Simulation* sim) {
     char file_path[100];
-    sprintf(file_path, "%s/ground_received.txt", settings.output_dir);
-    FILE *ground_received_file;
-    ground_received_file = fopen (file_path, "a");
+    if (sim->settings.output_format == OUTPUT_FORMAT_TRACE) {
+        create_trace_files(sim);
+    }
+    else {
+        for (int i = 0; i < sim->settings.node_count; i++) {
+            snprintf(file_path, sizeof(file_path), "%s/node-%d%s", sim->settings.output_dir, i, ".txt");
+            if (sim->settings.debug) {
+                printf("Creating output file \"%s\"\n", file_path);
+            }
+            output_file_create(&sim->output, OUTPUT_NODE_FILE(i), file_path);
+        }
+    }
+    queue_sample(sim, OUTPUT_RECORD_NODES);
+    return 0;
+}
 
-    // Write received message to file
-    fputs(message, ground_received_file);
-    fputc('\n', ground_received_file);
+int create_transmit_history_file(struct Simulation* sim) {
+    char file_path[100];
+    int file = OUTPUT_TRANSMIT_HISTORY(sim);
+    snprintf(file_path, sizeof(file_path), "%s/transmit_history.txt", sim->settings.output_dir);
+    output_file_create(&sim->output, file, file_path);
 
-    // Close file
-    fclose(ground_received_file);
+    // Header line, one column per channel
+    output_printf(&sim->output, file, "Time\t\t");
+    for (int i = 0; i < sim->settings.channels; i++) {
+        output_printf(&sim->output, file, i < sim->settings.channels - 1 ? "%d\t" : "%d", i);
+    }
+    output_printf(&sim->output, file, "\n");
 
     return 0;
 }
 
-int check_write_interval(struct Node* nodes) {
-
+int create_ground_received_file(struct Simulation* sim) {
     char file_path[100];
-    char channel_active[settings.channels * 2 + 1];
+    snprintf(file_path, sizeof(file_path), "%s/ground_received.txt", sim->settings.output_dir);
+    output_file_create(&sim->output, OUTPUT_GROUND_RECEIVED(sim), file_path);
 
-    if (settings.debug > 1) {
-        printf("debug level: %d\n", settings.debug);
-        printf("Checking write interval: ");
-    }
-    
-    if (fmod(state.current_time, settings.write_interval) < settings.time_resolution) {
-        if (settings.debug > 1) {
-            printf ("Match, writing output\n");
-        }
-        for (int i = 0; i < settings.node_count; i++) {
-            // output node specific info into one file per node
-            sprintf(file_path, "%s/node-%d%s", settings.output_dir, i, ".txt");
-            FILE *node_data_file;
-            
-            if (settings.debug> 1) {
-                printf("Opening %s for append\n", file_path);
-            }
-            node_data_file  = fopen (file_path, "a");
+    return 0;
+}
 
-            if (settings.debug> 1) {
-                printf("Writing data to file\n");
-            }
-            write_node_data(nodes, i, node_data_file);
+// Queues the frame of a RELAY the ground station took in, the writer turns
+// it into text
+int log_ground_received_packet(struct Simulation* sim, int packet) {
+    struct Packet_Slot* slot = packet_slot(&sim->packets, packet);
+    unsigned char* record = output_queue_reserve(&sim->output_queue, slot->length);
+    memcpy(record, slot->frame, slot->length);
+    output_queue_commit(&sim->output_queue, OUTPUT_RECORD_GROUND);
 
-            if (settings.debug> 1) {
-                printf("Closing file\n");
-            }
-            fclose(node_data_file);
-        }
-        // Open transmit_history file for writing
-        sprintf(file_path, "%s/transmit_history.txt", settings.output_dir);
-        FILE *transmit_history_file;
-        if (settings.debug> 1) {
-            printf("Opening %s for append\n", file_path);
-        }
-        transmit_history_file = fopen (file_path, "a");
-        // Build line of output for this timeslice
-        char buffer[sizeof(settings.channels) * 2 + 100];
-        if (settings.debug> 1) {
-            printf("Allocated buffer\n");
-        }
-        int transmit_count = 0;
-        for (int i = 0; i < settings.channels; i++) {
-            if (settings.debug> 1) {
-                printf("Checking channel %d\n", i);
-            }
-            // Do this for each channel
-            for (int j = 0; j < settings.node_count; j++) {
-                // Check each node to see if it is transmitting on channel
-                if (nodes[j].active_channel == i && nodes[j].transmit_active == 1) {
-                    transmit_count++;
-                }
-            }
-            if (transmit_count > 0) {
-                // If any nodes were transmitting on this channel output an "X"
-                // into history file and reset counter
-                channel_active[i * 2] = 88;
-                transmit_count = 0;
-            }
-            else {
-                // If no signals detected, output a "."
-                channel_active[i * 2] = 46;
-            } 
-            if (i < settings.channels - 1) {
-                // Remove trailing tab or else we get garbage output
-                channel_active[i * 2 + 1] = 9;
-            }
-        }
-        // Write output line to file and close
-        if (settings.debug> 1) {
-            printf("Putting line into buffer\n");
-        }
-        sprintf(buffer, "%f\t%s\n", state.current_time, channel_active);
+    return 0;
+}
 
-        if (settings.debug> 1) {
-            printf("Writing data to file\n");
+// Ticks from now until check_write_interval() next writes, at most ticks
+unsigned long ticks_to_write_interval(struct Simulation* sim, unsigned long ticks) {
+    double time = sim->state.current_time;
+    for (unsigned long i = 1; i < ticks; i++) {
+        time += sim->settings.time_resolution;
+        if (fmod(time, sim->settings.write_interval) < sim->settings.time_resolution) {
+            return i;
         }
-        fputs(buffer, transmit_history_file);
+    }
+    return ticks;
+}
 
-        if (settings.debug> 1) {
-            printf("Closing file\n");
+int check_write_interval(struct Simulation* sim) {
+    if (sim->settings.debug > 1) {
+        printf("debug level: %d\n", sim->settings.debug);
+        printf("Checking write interval: ");
+    }
+    
+    if (fmod(sim->state.current_time, sim->settings.write_interval) < sim->settings.time_resolution) {
+        if (sim->settings.debug > 1) {
+            printf ("Match, writing output\n");
         }
-        fclose(transmit_history_file);
+        queue_sample(sim, OUTPUT_RECORD_INTERVAL);
     }
     else {
-        if (settings.debug> 1) {
+        if (sim->settings.debug> 1) {
             printf("Not at interval\n");
         }
     }
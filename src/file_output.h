@@ -10,15 +10,53 @@
 #include <time.h>
 #include <sys/stat.h>
 #include "node.h"
+#include "output_queue.h"
+#include "output_writer.h"
 #include "settings.h"
+#include "trace.h"
 
 #ifndef fileoutput_H
 #define fileoutput_H
 
-int check_write_interval(struct Node*);
-int create_log_dir();
-int create_transmit_history_file();
-int create_ground_received_file();
-int log_ground_received_message(char*, int);
+// Writer file numbers, node files first
+#define OUTPUT_NODE_FILE(id)            (id)
+#define OUTPUT_TRANSMIT_HISTORY(sim)    ((sim)->settings.node_count)
+#define OUTPUT_GROUND_RECEIVED(sim)     ((sim)->settings.node_count + 1)
+#define OUTPUT_TRACE(sim)               ((sim)->settings.node_count + 2)
+#define OUTPUT_TRACE_SIGNALS(sim)       ((sim)->settings.node_count + 3)
+#define OUTPUT_FILE_COUNT(sim)          ((sim)->settings.node_count + 4)
+
+// Descriptor cache size when max_open_files is 0
+#define OUTPUT_AUTO_MAX_OPEN            256
+
+// Output queue record types
+#define OUTPUT_RECORD_NODES             1   // node files/trace only
+#define OUTPUT_RECORD_INTERVAL          2   // plus a transmit history line
+#define OUTPUT_RECORD_GROUND            3   // frame of a RELAY ground took in
+
+// Node state copied out at a write interval, pointing into a queued record
+struct Output_Sample {
+    double time;
+    double* x;
+    double* y;
+    double* z;
+    double* signals;                // node count rows of node count, NULL if not kept
+    int* channel;
+    int* function;
+    char* channel_active;           // per channel, 1 if anything was transmitting
+};
+
+struct Simulation;
+
+int open_output_files(struct Simulation*);
+int start_output_writer(struct Simulation*);
+int close_output_files(struct Simulation*);
+int check_write_interval(struct Simulation*);
+unsigned long ticks_to_write_interval(struct Simulation*, unsigned long);
+int create_log_dir(struct Simulation*);
+int create_node_files(struct Simulation*);
+int create_transmit_history_file(struct Simulation*);
+int create_ground_received_file(struct Simulation*);
+int log_ground_received_packet(struct Simulation*, int);
 
 #endif
\ No newline at end of file
@@ -6,83 +6,133 @@
  * @date    3/6/2021
 **/
 
+#include <math.h>
 #include <string.h>
+#include "channels.h"
 #include "file_output.h"
 #include "ground.h"
+#include "packet_slab.h"
 #include "settings.h"
+#include "simulation.h"
 #include "state.h"
 
-extern struct Settings settings;
-extern struct State state;
+int initialize_ground(struct Simulation* sim) {
+    struct Ground_Station* ground = &sim->ground;
+
 
-int initialize_ground(struct Ground_Station* ground) {
     ground->messages_received = 0;
     ground->collisions_detected = 0;
     ground->x_pos = 0.0;
     ground->y_pos = 0.0;
     ground->z_pos = 0.0;
-    ground->new_message_available = malloc(sizeof(int) * settings.channels);
-    for (int i = 0; i < settings.channels; i++) {
+    ground->new_message_available = malloc(sizeof(int) * sim->settings.channels);
+    for (int i = 0; i < sim->settings.channels; i++) {
         ground->new_message_available[i] = 1;
     }
 
     return 0;
 }
 
-int update_ground(struct Node* nodes, struct Ground_Station* ground) {
+// Transmitters on one channel the ground station hears
+struct Ground_Scan {
+    int count;
+    int node;                       // the strongest, ties to the higher id
+    double strongest;               // mW, with sinr
+    double total;
+};
+
+// Counts id if the ground is within its radio range, with sinr adding its
+// power from current positions since the ground is only one receiver
+static void ground_hear(struct Simulation* sim, int id, struct Ground_Scan* scan) {
+    struct Ground_Station* ground = &sim->ground;
+    double dx = NODE_KIN(sim, id, x_pos) - ground->x_pos;
+    double dy = NODE_KIN(sim, id, y_pos) - ground->y_pos;
+    double dz = NODE_KIN(sim, id, z_pos) - ground->z_pos;
+    if (sim->grid.enabled && dx * dx + dy * dy + dz * dz > sim->grid.range_squared[id]) {
+        return;
+    }
+    scan->count++;
+    if (!sim->interference.enabled) {
+        scan->node = id;
+        return;
+    }
+    double distance = sqrt(pow(dx, 2) + pow(dy, 2) + pow(dz, 2));
+    double power = dbm_to_mw(sim->nodes[id].power_output - path_loss_exact(distance));
+    scan->total += power;
+    if (scan->node == -1 || power > scan->strongest || (power == scan->strongest && id > scan->node)) {
+        scan->strongest = power;
+        scan->node = id;
+    }
+}
+
+// Scans whichever is shorter, the channel's transmitters or the ground
+// station's neighbor list, on ticks that list was checked. The ground runs
+// once every MCU has, so both read live node state, not the previous tick
+// views worker threads' MCUs see.
+static void ground_scan(struct Simulation* sim, int channel, struct Ground_Scan* scan) {
+    struct Channel_Occupancy* occupancy = &sim->channel_index[channel];
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    struct Node* nodes = sim->nodes;
+    scan->count = 0;
+    scan->node = -1;
+    scan->strongest = 0;
+    scan->total = 0;
+    if (lists->enabled && lists->ground_checked == sim->state.current_cycle &&
+        lists->ground_count < occupancy->transmitter_count) {
+        for (int j = 0; j < lists->ground_count; j++) {
+            int id = lists->ground_peers[j];
+            if (nodes[id].transmit_active == 1 && nodes[id].active_channel == channel) {
+                ground_hear(sim, id, scan);
+            }
+        }
+        return;
+    }
+    for (int j = 0; j < occupancy->transmitter_count; j++) {
+        ground_hear(sim, occupancy->transmitters[j], scan);
+    }
+}
+
+/**
+ * Update ground
+ * Desc: Receives on every channel, with a receiver_sensitivity cutoff only
+ *       transmitters within their radio range of the ground station are
+ *       heard
+**/
+int update_ground(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
+    struct Ground_Station* ground = &sim->ground;
+    struct Ground_Scan scan;
     int signals_detected;
+    int decoded;
     int transmitting_node = -1;
 
     // Scan each channel
-    for (int i = 0; i < settings.channels; i++) {
-        signals_detected = 0;
-        // Check each node
-        // Later add signal strength update/checking
-        for (int j = 0; j < settings.node_count; j++) {
-            if (nodes[j].transmit_active == 1 && nodes[j].active_channel == i) {
-                signals_detected++;
-                transmitting_node = j;
-            }
+    for (int i = 0; i < sim->settings.channels; i++) {
+        ground_scan(sim, i, &scan);
+        signals_detected = scan.count;
+        if (signals_detected > 0) {
+            transmitting_node = scan.node;
+        }
+        // 1 for a message, -1 for a collision, 0 for nothing
+        decoded = signals_detected == 1 ? 1 : (signals_detected > 1 ? -1 : 0);
+        if (sim->interference.enabled && signals_detected > 0) {
+            double others = signals_detected > 1 ? scan.total - scan.strongest : 0;
+            decoded = sinr_decode(&sim->interference, scan.strongest, others > 0 ? others : 0);
         }
         // Check for collision
-        if (signals_detected > 1) {
+        if (decoded == -1) {
             ground->collisions_detected++;
         }
-        else if (signals_detected == 1 && ground->new_message_available[i] == 1) {
-            // Check for DATA message
-            char* token;
-            char incoming_buffer[256];
-            char message[256];
-
-            // Zero out message string to eliminate proceeded garbage data
-            bzero(message, 256);
-
-            strncpy(incoming_buffer, nodes[transmitting_node].send_packet, 256);
-            token = strtok(incoming_buffer, " ");
-            char sender_id[6];
+        else if (decoded == 1 && ground->new_message_available[i] == 1) {
+            // Check for relayed DATA message
+            struct Packet packet;
+            packet_read(&sim->packets, nodes[transmitting_node].send_packet, &packet, 0);
             
-            // Extract dest and src node IDs from message
-            if (strcmp(token, "GROUND") == 0) {
-                token = strtok(NULL, " ");
-                strncpy(sender_id, token, 6);
-
-                // Check if third token is "DATA"
-                token = strtok(NULL, " ");
-                if (strcmp(token, "RELAY") == 0) {
-                    // Process remaining tokens
-                    token = strtok(NULL, " ");
-                    do {
-                        strncat(message, token, strlen(token));
-                        strncat(message, " ", 2);
-                        token = strtok(NULL, " ");
-                    } while (token != 0);
-
-                    // Update message counter and write to file if output flag set
-                    ground->messages_received++;
-                    if (settings.output) {
-                        // write to log file
-                        log_ground_received_message(message, strlen(message));
-                    }
+            if (packet.dest == PACKET_ADDR_GROUND && packet.type == PACKET_TYPE_RELAY) {
+                // Update message counter and write to file if output flag set
+                ground->messages_received++;
+                if (sim->settings.output) {
+                    log_ground_received_packet(sim, nodes[transmitting_node].send_packet);
                 }
             }
             // Switch message available flag
@@ -94,3 +144,15 @@ int update_ground(struct Node* nodes, struct Ground_Station* ground) {
     }
     return 0;
 }
+
+// Count channels with more than one active transmitter, collisions
+// without sinr or a receiver_sensitivity cutoff
+int ground_collision_channels(struct Simulation* sim) {
+    int collision_channels = 0;
+    for (int i = 0; i < sim->settings.channels; i++) {
+        if (sim->channel_index[i].transmitter_count > 1) {
+            collision_channels++;
+        }
+    }
+    return collision_channels;
+}
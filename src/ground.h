@@ -21,7 +21,10 @@ struct Ground_Station {
     int* new_message_available;
 };
 
-int initialize_ground(struct Ground_Station* ground);
-int update_ground(struct Node* nodes, struct Ground_Station* ground);
+struct Simulation;
+
+int initialize_ground(struct Simulation* sim);
+int update_ground(struct Simulation* sim);
+int ground_collision_channels(struct Simulation* sim);
 
 #endif
\ No newline at end of file
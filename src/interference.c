@@ -0,0 +1,297 @@
+/**
+ * @file    interference.c
+ * @brief   SINR reception with incremental per channel interference sums
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <math.h>
+#include <string.h>
+#include "interference.h"
+#include "simulation.h"
+
+#define LN10        2.30258509299404568402
+
+// Receivers of the hold being filled
+struct Interference_Fill {
+    struct Interference_Hold* hold;
+    int id;
+};
+
+static int compare_ids(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+static void hold_add(struct Interference_Hold* hold, int receiver) {
+    if (hold->count == hold->capacity) {
+        hold->capacity = hold->capacity > 0 ? hold->capacity * 2 : 64;
+        hold->receivers = realloc(hold->receivers, sizeof(int) * hold->capacity);
+        hold->power = realloc(hold->power, sizeof(double) * hold->capacity);
+        if (hold->receivers == NULL || hold->power == NULL) {
+            printf("Interference memory allocation error\n");
+            exit(0);
+        }
+    }
+    hold->receivers[hold->count++] = receiver;
+}
+
+// Adds receiver if it's within the transmitter's radio range
+static void hold_check(struct Simulation* sim, int receiver, void* context) {
+    struct Interference_Fill* fill = context;
+    if (receiver == fill->id) {
+        return;
+    }
+    double dx = NODE_KIN(sim, receiver, x_pos) - NODE_KIN(sim, fill->id, x_pos);
+    double dy = NODE_KIN(sim, receiver, y_pos) - NODE_KIN(sim, fill->id, y_pos);
+    double dz = NODE_KIN(sim, receiver, z_pos) - NODE_KIN(sim, fill->id, z_pos);
+    if (dx * dx + dy * dy + dz * dz <= sim->grid.range_squared[fill->id]) {
+        hold_add(fill->hold, receiver);
+    }
+}
+
+// A free hold slot, growing the pool when every one is in use
+static int take_hold(struct Interference* interference) {
+    if (interference->free_count > 0) {
+        return interference->free_holds[--interference->free_count];
+    }
+    int slot = interference->hold_count++;
+    interference->holds = realloc(interference->holds, sizeof(struct Interference_Hold) * interference->hold_count);
+    interference->free_holds = realloc(interference->free_holds, sizeof(int) * interference->hold_count);
+    if (interference->holds == NULL || interference->free_holds == NULL) {
+        printf("Interference memory allocation error\n");
+        exit(0);
+    }
+    memset(&interference->holds[slot], 0, sizeof(struct Interference_Hold));
+    return slot;
+}
+
+// Adds a filled in hold to the sums
+static void hold_apply(struct Interference* interference, int id, int slot) {
+    struct Interference_Hold* hold = &interference->holds[slot];
+    for (int i = 0; i < hold->count; i++) {
+        size_t at = (size_t)hold->channel * interference->node_count + hold->receivers[i];
+        interference->power[at] += hold->power[i];
+        interference->count[at]++;
+    }
+    interference->hold[id] = slot;
+}
+
+/**
+ * Initialize interference
+ * Desc: Sets up empty sums when sinr is set. Transmitters are added by
+ *       update_interference(), which needs the spatial grid, or restored
+ *       from a checkpoint before that.
+**/
+int initialize_interference(struct Simulation* sim) {
+    struct Interference* interference = &sim->interference;
+    int n = sim->settings.node_count;
+
+    memset(interference, 0, sizeof(*interference));
+    if (!sim->settings.sinr) {
+        return 0;
+    }
+    interference->node_count = n;
+    interference->capture = dbm_to_mw(sim->settings.capture_threshold);
+    interference->noise = dbm_to_mw(sim->settings.noise_floor);
+    interference->power = calloc((size_t)n * sim->settings.channels, sizeof(double));
+    interference->count = calloc((size_t)n * sim->settings.channels, sizeof(int));
+    interference->hold = malloc(sizeof(int) * n);
+    if (interference->power == NULL || interference->count == NULL || interference->hold == NULL) {
+        printf("Interference memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < n; i++) {
+        interference->hold[i] = -1;
+    }
+    interference->enabled = 1;
+    return 0;
+}
+
+int free_interference(struct Simulation* sim) {
+    struct Interference* interference = &sim->interference;
+    for (int i = 0; i < interference->hold_count; i++) {
+        free(interference->holds[i].receivers);
+        free(interference->holds[i].power);
+    }
+    free(interference->holds);
+    free(interference->free_holds);
+    free(interference->power);
+    free(interference->count);
+    free(interference->hold);
+    memset(interference, 0, sizeof(*interference));
+    return 0;
+}
+
+/**
+ * Interference start
+ * Desc: Adds id transmitting on channel to the sums of every node that can
+ *       hear it, taking off whatever it was holding before
+**/
+int interference_start(struct Simulation* sim, int id, int channel) {
+    struct Interference* interference = &sim->interference;
+    if (!interference->enabled) {
+        return 0;
+    }
+    interference_stop(sim, id);
+
+    int slot = take_hold(interference);
+    struct Interference_Hold* hold = &interference->holds[slot];
+    struct Interference_Fill fill = {hold, id};
+    hold->channel = channel;
+    hold->count = 0;
+    if (!sim->grid.enabled) {
+        for (int i = 0; i < sim->settings.node_count; i++) {
+            if (i != id) {
+                hold_add(hold, i);
+            }
+        }
+    }
+    else {
+        int visited = 0;
+        if (sim->neighbors.enabled) {
+            for (int j = sim->neighbors.start[id]; j < sim->neighbors.start[id + 1]; j++) {
+                hold_check(sim, sim->neighbors.peers[j], &fill);
+            }
+            visited = 1;
+        }
+        else {
+            visited = spatial_grid_visit(sim, NODE_KIN(sim, id, x_pos), NODE_KIN(sim, id, y_pos),
+                                         NODE_KIN(sim, id, z_pos), sim->grid.range, hold_check, &fill) == 0;
+        }
+        if (!visited) {
+            for (int i = 0; i < sim->settings.node_count; i++) {
+                hold_check(sim, i, &fill);
+            }
+        }
+        qsort(hold->receivers, hold->count, sizeof(int), compare_ids);
+    }
+
+    signal_batch_from(sim, id, channel, hold->receivers, hold->count, hold->power);
+    for (int i = 0; i < hold->count; i++) {
+        hold->power[i] = dbm_to_mw(hold->power[i]);
+    }
+    hold_apply(interference, id, slot);
+    return 0;
+}
+
+// Takes what id added off the sums again, sums left with no transmitters
+// go back to exactly 0
+int interference_stop(struct Simulation* sim, int id) {
+    struct Interference* interference = &sim->interference;
+    if (!interference->enabled || interference->hold[id] == -1) {
+        return 0;
+    }
+    int slot = interference->hold[id];
+    struct Interference_Hold* hold = &interference->holds[slot];
+    for (int i = 0; i < hold->count; i++) {
+        size_t at = (size_t)hold->channel * interference->node_count + hold->receivers[i];
+        interference->power[at] -= hold->power[i];
+        if (--interference->count[at] == 0) {
+            interference->power[at] = 0;
+        }
+    }
+    interference->hold[id] = -1;
+    interference->free_holds[interference->free_count++] = slot;
+    return 0;
+}
+
+// Puts back a hold saved in a checkpoint
+int interference_restore(struct Simulation* sim, int id, int channel, const int* receivers, const double* power,
+                         int count) {
+    struct Interference* interference = &sim->interference;
+    if (!interference->enabled) {
+        return 0;
+    }
+    interference_stop(sim, id);
+
+    int slot = take_hold(interference);
+    struct Interference_Hold* hold = &interference->holds[slot];
+    hold->channel = channel;
+    hold->count = 0;
+    for (int i = 0; i < count; i++) {
+        hold_add(hold, receivers[i]);
+        hold->power[i] = power[i];
+    }
+    hold_apply(interference, id, slot);
+    return 0;
+}
+
+/**
+ * Update interference
+ * Desc: Brings the sums in line with which nodes are transmitting on which
+ *       channel. The tick and event engines keep them up to date as
+ *       transmitters change, this is for the threaded engine and anything
+ *       set up before the spatial grid.
+**/
+int update_interference(struct Simulation* sim) {
+    struct Interference* interference = &sim->interference;
+    struct Node* nodes = sim->nodes;
+    if (!interference->enabled) {
+        return 0;
+    }
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        int channel = nodes[i].transmit_active == 1 ? nodes[i].active_channel : -1;
+        int held = interference->hold[i] == -1 ? -1 : interference->holds[interference->hold[i]].channel;
+        if (channel == held) {
+            continue;
+        }
+        if (channel == -1) {
+            interference_stop(sim, i);
+        }
+        else {
+            interference_start(sim, i, channel);
+        }
+    }
+    return 0;
+}
+
+double dbm_to_mw(double dbm) {
+    return exp(dbm * LN10 / 10);
+}
+
+/**
+ * SINR decode
+ * Desc: Checks a signal against others on the channel and the noise floor,
+ *       all in mW
+ *
+ * Returns: 1 if the signal is decoded, -1 if the other transmitters stopped
+ *          it (a collision), 0 if noise alone did
+**/
+int sinr_decode(const struct Interference* interference, double signal, double others) {
+    if (signal >= interference->capture * (others + interference->noise)) {
+        return 1;
+    }
+    return signal >= interference->capture * interference->noise ? -1 : 0;
+}
+
+/**
+ * Interference decode
+ * Desc: sinr_decode() for transmitter at receiver against receiver's sum on
+ *       channel. signal (dBm) is only used if transmitter isn't in the sum,
+ *       it was out of range when it started.
+**/
+int interference_decode(struct Simulation* sim, int receiver, int channel, int transmitter, double signal) {
+    struct Interference* interference = &sim->interference;
+    size_t at = (size_t)channel * interference->node_count + receiver;
+    double others = interference->power[at];
+
+    if (interference->hold[transmitter] != -1) {
+        struct Interference_Hold* hold = &interference->holds[interference->hold[transmitter]];
+        int index = -1;
+        if (hold->channel == channel && hold->count == sim->settings.node_count - 1) {
+            // Every other node, no need to search
+            index = receiver - (receiver > transmitter);
+        }
+        else if (hold->channel == channel) {
+            const int* found = bsearch(&receiver, hold->receivers, hold->count, sizeof(int), compare_ids);
+            index = found != NULL ? (int)(found - hold->receivers) : -1;
+        }
+        if (index != -1) {
+            double own = hold->power[index];
+            others = interference->count[at] == 1 ? 0 : others - own;
+            return sinr_decode(interference, own, others > 0 ? others : 0);
+        }
+    }
+    return sinr_decode(interference, dbm_to_mw(signal), others);
+}
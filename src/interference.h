@@ -0,0 +1,62 @@
+/**
+ * @file    interference.h
+ * @brief   SINR reception with incremental per channel interference sums
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifndef interference_H
+#define interference_H
+
+struct Simulation;
+
+// What one transmission added to the sums it's in, taken back off when it
+// ends, receivers in ascending id order. Slots are reused so steady state
+// transmissions don't allocate.
+struct Interference_Hold {
+    int channel;
+    int count;
+    int capacity;
+    int* receivers;
+    double* power;                  // mW
+};
+
+/**
+ * Power every node receives on each channel from all transmitters on it,
+ * in mW. A transmitter's contribution is worked out when it starts (or
+ * changes channel) and held until it stops, so the sums don't drift as
+ * nodes move and decoding never has to rescan the transmitters. With a
+ * receiver_sensitivity cutoff only nodes in radio range at the start are
+ * added to.
+ *
+ * A receiver decodes its strongest transmitter when
+ * signal >= capture * (everything else on the channel + noise), both as
+ * held for it, otherwise what it hears is a collision (or lost in noise).
+**/
+struct Interference {
+    int enabled;
+    int node_count;
+    double capture;                 // SINR needed, linear
+    double noise;                   // mW, 0 without a noise floor
+    double* power;                  // sums for every node, one channel after another
+    int* count;                     // transmitters in each sum
+    int* hold;                      // slot per node, -1 when not counted
+    struct Interference_Hold* holds;
+    int hold_count;
+    int* free_holds;
+    int free_count;
+};
+
+int initialize_interference(struct Simulation* sim);
+int free_interference(struct Simulation* sim);
+int interference_start(struct Simulation* sim, int id, int channel);
+int interference_stop(struct Simulation* sim, int id);
+int interference_restore(struct Simulation* sim, int id, int channel, const int* receivers, const double* power,
+                         int count);
+int update_interference(struct Simulation* sim);
+double dbm_to_mw(double dbm);
+int sinr_decode(const struct Interference* interference, double signal, double others);
+int interference_decode(struct Simulation* sim, int receiver, int channel, int transmitter, double signal);
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file    kinematics.c
+ * @brief   Structure-of-arrays node kinematics and SIMD physics kernels
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifdef KINEMATICS_SOA
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "kinematics.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define KINEMATICS_ALIGNMENT 32
+
+static double* kinematics_array(int node_count) {
+    // aligned_alloc needs a size that is a multiple of the alignment
+    size_t size = sizeof(double) * node_count;
+    size = (size + KINEMATICS_ALIGNMENT - 1) / KINEMATICS_ALIGNMENT * KINEMATICS_ALIGNMENT;
+    double* array = aligned_alloc(KINEMATICS_ALIGNMENT, size > 0 ? size : KINEMATICS_ALIGNMENT);
+    if (array == NULL) {
+        printf("Kinematics memory allocation error\n");
+        exit(0);
+    }
+    return array;
+}
+
+int initialize_kinematics(struct Kinematics* kinematics, int node_count) {
+    kinematics->terminal_velocity = kinematics_array(node_count);
+    kinematics->x_pos = kinematics_array(node_count);
+    kinematics->y_pos = kinematics_array(node_count);
+    kinematics->z_pos = kinematics_array(node_count);
+    kinematics->x_velocity = kinematics_array(node_count);
+    kinematics->y_velocity = kinematics_array(node_count);
+    kinematics->z_velocity = kinematics_array(node_count);
+    kinematics->x_acceleration = kinematics_array(node_count);
+    kinematics->y_acceleration = kinematics_array(node_count);
+    kinematics->z_acceleration = kinematics_array(node_count);
+    return 0;
+}
+
+int free_kinematics(struct Kinematics* kinematics) {
+    free(kinematics->terminal_velocity);
+    free(kinematics->x_pos);
+    free(kinematics->y_pos);
+    free(kinematics->z_pos);
+    free(kinematics->x_velocity);
+    free(kinematics->y_velocity);
+    free(kinematics->z_velocity);
+    free(kinematics->x_acceleration);
+    free(kinematics->y_acceleration);
+    free(kinematics->z_acceleration);
+    return 0;
+}
+
+/**
+ * Velocity kernel
+ * Desc: Same arithmetic as update_velocity_range() (multiply then add, no
+ *       fused multiply-add) so results are bit for bit identical. Z velocity
+ *       only changes for falling nodes below terminal velocity, and is
+ *       clamped to terminal velocity.
+**/
+int kinematics_update_velocity(struct Kinematics* kinematics, double res, int start, int end) {
+    double* tv = kinematics->terminal_velocity;
+    double* z = kinematics->z_pos;
+    double* xv = kinematics->x_velocity;
+    double* yv = kinematics->y_velocity;
+    double* zv = kinematics->z_velocity;
+    double* xa = kinematics->x_acceleration;
+    double* ya = kinematics->y_acceleration;
+    double* za = kinematics->z_acceleration;
+    int i = start;
+
+#if defined(__AVX2__)
+    __m256d v_res = _mm256_set1_pd(res);
+    __m256d v_zero = _mm256_setzero_pd();
+    for (; i + 4 <= end; i += 4) {
+        __m256d v_z = _mm256_loadu_pd(z + i);
+        __m256d v_zv = _mm256_loadu_pd(zv + i);
+        __m256d v_tv = _mm256_loadu_pd(tv + i);
+        __m256d v_next = _mm256_add_pd(v_zv, _mm256_mul_pd(_mm256_loadu_pd(za + i), v_res));
+        __m256d v_clamped = _mm256_blendv_pd(v_tv, v_next, _mm256_cmp_pd(v_next, v_tv, _CMP_LT_OQ));
+        __m256d v_update = _mm256_and_pd(_mm256_cmp_pd(v_z, v_zero, _CMP_GT_OQ),
+                                         _mm256_cmp_pd(v_zv, v_tv, _CMP_LT_OQ));
+        _mm256_storeu_pd(zv + i, _mm256_blendv_pd(v_zv, v_clamped, v_update));
+        _mm256_storeu_pd(xv + i, _mm256_add_pd(_mm256_loadu_pd(xv + i), 
+                                               _mm256_mul_pd(_mm256_loadu_pd(xa + i), v_res)));
+        _mm256_storeu_pd(yv + i, _mm256_add_pd(_mm256_loadu_pd(yv + i), 
+                                               _mm256_mul_pd(_mm256_loadu_pd(ya + i), v_res)));
+    }
+#elif defined(__SSE2__)
+    __m128d v_res = _mm_set1_pd(res);
+    __m128d v_zero = _mm_setzero_pd();
+    for (; i + 2 <= end; i += 2) {
+        __m128d v_z = _mm_loadu_pd(z + i);
+        __m128d v_zv = _mm_loadu_pd(zv + i);
+        __m128d v_tv = _mm_loadu_pd(tv + i);
+        __m128d v_next = _mm_add_pd(v_zv, _mm_mul_pd(_mm_loadu_pd(za + i), v_res));
+        __m128d v_below = _mm_cmplt_pd(v_next, v_tv);
+        __m128d v_clamped = _mm_or_pd(_mm_and_pd(v_below, v_next), _mm_andnot_pd(v_below, v_tv));
+        __m128d v_update = _mm_and_pd(_mm_cmpgt_pd(v_z, v_zero), _mm_cmplt_pd(v_zv, v_tv));
+        _mm_storeu_pd(zv + i, _mm_or_pd(_mm_and_pd(v_update, v_clamped), _mm_andnot_pd(v_update, v_zv)));
+        _mm_storeu_pd(xv + i, _mm_add_pd(_mm_loadu_pd(xv + i), _mm_mul_pd(_mm_loadu_pd(xa + i), v_res)));
+        _mm_storeu_pd(yv + i, _mm_add_pd(_mm_loadu_pd(yv + i), _mm_mul_pd(_mm_loadu_pd(ya + i), v_res)));
+    }
+#endif
+
+    // scalar fallback and remainder
+    for (; i < end; i++) {
+        if (z[i] > 0 && zv[i] < tv[i]) {
+            double next = zv[i] + za[i] * res;
+            zv[i] = next < tv[i] ? next : tv[i];
+        }
+        xv[i] += xa[i] * res;
+        yv[i] += ya[i] * res;
+    }
+    return 0;
+}
+
+/**
+ * Position kernel
+ * Desc: Same arithmetic as update_position_range(), falling nodes stop at z = 0
+**/
+int kinematics_update_position(struct Kinematics* kinematics, double res, int start, int end) {
+    double* x = kinematics->x_pos;
+    double* y = kinematics->y_pos;
+    double* z = kinematics->z_pos;
+    double* xv = kinematics->x_velocity;
+    double* yv = kinematics->y_velocity;
+    double* zv = kinematics->z_velocity;
+    int i = start;
+
+#if defined(__AVX2__)
+    __m256d v_res = _mm256_set1_pd(res);
+    __m256d v_zero = _mm256_setzero_pd();
+    for (; i + 4 <= end; i += 4) {
+        __m256d v_z = _mm256_loadu_pd(z + i);
+        __m256d v_next = _mm256_sub_pd(v_z, _mm256_mul_pd(_mm256_loadu_pd(zv + i), v_res));
+        // next > 0 ? next : 0, only for nodes still above ground
+        __m256d v_landed = _mm256_and_pd(v_next, _mm256_cmp_pd(v_next, v_zero, _CMP_GT_OQ));
+        _mm256_storeu_pd(z + i, _mm256_blendv_pd(v_z, v_landed, _mm256_cmp_pd(v_z, v_zero, _CMP_GT_OQ)));
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_loadu_pd(x + i), 
+                                              _mm256_mul_pd(_mm256_loadu_pd(xv + i), v_res)));
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), 
+                                              _mm256_mul_pd(_mm256_loadu_pd(yv + i), v_res)));
+    }
+#elif defined(__SSE2__)
+    __m128d v_res = _mm_set1_pd(res);
+    __m128d v_zero = _mm_setzero_pd();
+    for (; i + 2 <= end; i += 2) {
+        __m128d v_z = _mm_loadu_pd(z + i);
+        __m128d v_next = _mm_sub_pd(v_z, _mm_mul_pd(_mm_loadu_pd(zv + i), v_res));
+        __m128d v_landed = _mm_and_pd(v_next, _mm_cmpgt_pd(v_next, v_zero));
+        __m128d v_falling = _mm_cmpgt_pd(v_z, v_zero);
+        _mm_storeu_pd(z + i, _mm_or_pd(_mm_and_pd(v_falling, v_landed), _mm_andnot_pd(v_falling, v_z)));
+        _mm_storeu_pd(x + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_mul_pd(_mm_loadu_pd(xv + i), v_res)));
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(_mm_loadu_pd(yv + i), v_res)));
+    }
+#endif
+
+    // scalar fallback and remainder
+    for (; i < end; i++) {
+        if (z[i] > 0) {
+            double next = z[i] - zv[i] * res;
+            z[i] = next > 0 ? next : 0;
+        }
+        x[i] += xv[i] * res;
+        y[i] += yv[i] * res;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file    kinematics.h
+ * @brief   Structure-of-arrays node kinematics and SIMD physics kernels
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifndef kinematics_H
+#define kinematics_H
+
+/**
+ * Node kinematic fields are accessed with NODE_KIN(sim, id, field) so the
+ * same code works whether they live in struct Node or, when built with
+ * KINEMATICS_SOA (make SOA=1), in separate contiguous arrays per field
+**/
+#ifdef KINEMATICS_SOA
+
+struct Kinematics {
+    double* terminal_velocity;
+    double* x_pos;
+    double* y_pos;
+    double* z_pos;
+    double* x_velocity;
+    double* y_velocity;
+    double* z_velocity;
+    double* x_acceleration;
+    double* y_acceleration;
+    double* z_acceleration;
+};
+
+#define NODE_KIN(sim, id, field) ((sim)->kinematics.field[(id)])
+
+int initialize_kinematics(struct Kinematics* kinematics, int node_count);
+int free_kinematics(struct Kinematics* kinematics);
+int kinematics_update_velocity(struct Kinematics* kinematics, double res, int start, int end);
+int kinematics_update_position(struct Kinematics* kinematics, double res, int start, int end);
+
+#else
+
+#define NODE_KIN(sim, id, field) ((sim)->nodes[(id)].field)
+
+#endif
+
+#endif
@@ -13,20 +13,15 @@
 #include <time.h>
 #include <sys/types.h>
 #include <unistd.h>
-#include "node.h"
-#include "mcu_emulation.h"
-#include "file_output.h"
+#include "checkpoint.h"
 #include "settings.h"
-#include "state.h"
-#include "ground.h"
-
-struct Settings settings;
-struct State state;
+#include "simulation.h"
+#include "sweep.h"
 
 int main(int argc, char **argv) {
     // Initialization and defaults
-    int ret = 0;
-    set_program_defaults();
+    struct Settings settings;
+    set_program_defaults(&settings);
 
     // If .ini file exists parse it
     if(access("dwsn.ini", F_OK ) == 0 ) {
@@ -45,10 +40,7 @@ int main(int argc, char **argv) {
     }
 
     // get command line switches
-    get_switches(argc, argv);
-
-    // state initialization
-    initialize_state();
+    get_switches(&settings, argc, argv);
 
     // Print message about debug level
     if (settings.debug) {
@@ -59,7 +51,6 @@ int main(int argc, char **argv) {
     if (settings.random_seed < 0) {
         settings.random_seed = time(NULL);
     }
-    srand(settings.random_seed); 
     if (settings.verbose) {
         printf("Seeded random number generator with: %d\n", settings.random_seed);
     }
@@ -74,101 +65,48 @@ int main(int argc, char **argv) {
         printf("Spread factor: %f\n", settings.spread_factor);
         printf("Default power output: %f\n", settings.default_power_output);
         printf("Broadcast percentage: %d\n", settings.broadcast_percentage);
+        printf("Engine: %s\n", settings.engine == ENGINE_EVENT ? "event" : "tick");
     }
     
-    if (settings.output) {
-        // Make log directory if output option is turned on
-        create_log_dir();
-        // create transmit_history file and header
-        create_transmit_history_file();
-        // create log of received messages at ground
-        create_ground_received_file();
-    }
+    simulation_catch_signals();
 
-    // Get ground station ready
-    if (settings.verbose) {
-        printf("Initializing ground station: ");
-    }
-    struct Ground_Station ground;
-    ret = initialize_ground(&ground);
-    if (ret == 0) {
-        if (settings.verbose) {
-            printf("OK\n");
-        }
+    // Parameter sweeps run their own replicas
+    if (settings.sweep_parameter_count > 0 || settings.sweep_repeats > 1) {
+        return run_sweep(&settings);
     }
 
-    // Get nodes ready
-    if (settings.verbose) {
-        printf("Initializing nodes: ");
-    }
-    struct Node nodes[settings.node_count];
-    ret = initialize_nodes(nodes);
-    if (ret == 0) {
-        if (settings.verbose) {
-            printf("OK\n");
+    struct Simulation* sim;
+    if (settings.restore_file != NULL) {
+        struct Checkpoint checkpoint;
+        if (checkpoint_load(&checkpoint, settings.restore_file) != 0) {
+            return 1;
         }
-        state.moving_nodes = settings.node_count;
-    }
-    
-    // Run until all nodes reach z = 0;
-    if (settings.verbose) {
-        printf("Running simulation\n");
-    }
-
-    while (state.moving_nodes != 0) {
-        clock_tick(nodes, &ground);
-        state.moving_nodes = 0; 
-        for (int i = 0; i < settings.node_count; i++) {
-            if (nodes[i].z_pos > 0) {
-                state.moving_nodes++;
-            }
+        sim = simulation_restore(&settings, &checkpoint);
+        checkpoint_free(&checkpoint);
+        if (sim == NULL) {
+            return 1;
         }
     }
-
-    // Calculate simulation time
-    double runTime = (double)(clock() - state.start_time) / CLOCKS_PER_SEC;
-
-    // Print summary information
-    if (settings.verbose) {
-        printf("Simulation complete\n");
-        printf("Cycles processed: %lu\n", state.current_cycle);
-        printf("Simulation time: %f seconds\n", state.current_time);        
+    else {
+        sim = simulation_create(&settings);
     }
 
-    if (settings.debug) {
-        for (int i = 0; i < settings.node_count; i++) {
-            printf("Node %d final velocity: %f %f %f m/s, final position: %f %f %f\n", 
-                i, 
-                nodes[i].x_velocity, 
-                nodes[i].y_velocity, 
-                nodes[i].z_velocity, 
-                nodes[i].x_pos, 
-                nodes[i].y_pos, 
-                nodes[i].z_pos);
+    // Checkpoint part way down, then carry on to the ground
+    if (settings.checkpoint_file != NULL) {
+        struct Checkpoint checkpoint;
+        simulation_run_until(sim, settings.checkpoint_time);
+        if (checkpoint_capture(sim, &checkpoint) == 0 &&
+            checkpoint_save(&checkpoint, settings.checkpoint_file) == 0) {
+            if (settings.verbose) {
+                printf("Checkpoint written to \"%s\" at %f seconds\n", 
+                    settings.checkpoint_file, sim->state.current_time);
+            }
         }
-    }
-    if (settings.verbose) {
-        printf("Final clock time: %f seconds\n", runTime);
-    }
-    
-    if (settings.verbose) {
-        printf("Total collisions detected: %d\n", state.collisions);
+        checkpoint_free(&checkpoint);
     }
 
-    if (settings.verbose) {
-        printf("Total messages sent: %lu\n", state.sent_messages);
-    }
+    simulation_run(sim, NULL);
+    simulation_destroy(sim);
 
-    if (settings.verbose) {
-        printf("Ground station received %d messages\n", ground.messages_received);
-    }
-
-    if (settings.verbose) {
-        printf("Ground station detected %d collisions\n", ground.collisions_detected);
-    }
-
-    if (settings.verbose) {
-        printf("Message succeess rate: %f\n", (float)ground.messages_received / state.sent_messages);
-    }
-    return 0;
+    return simulation_interrupted() ? 130 : 0;
 }
\ No newline at end of file
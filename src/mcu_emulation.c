@@ -6,246 +6,275 @@
  * @date    12/26/2020
 **/
 
+#include "channels.h"
 #include "mcu_emulation.h"
 #include "mcu_functions.h"
+#include "rng.h"
+#include "simulation.h"
 #include "state.h"
 #include <pthread.h>
 
-extern struct Settings settings;
-extern struct State state;
+/**
+ * Microcontroller wake-up wheel initialization
+ * Desc: All nodes start out due on the first tick, except ones restored
+ *       from a checkpoint part way through a busy time or wait
+**/
+int initialize_mcu_wheel(struct Simulation* sim) {
+    struct MCU_Wheel* wheel = &sim->wheel;
+
+    wheel->slots = MCU_WHEEL_SLOTS;
+    wheel->due_words = (sim->settings.node_count + 63) / 64;
+    wheel->slot_head = malloc(sizeof(int) * wheel->slots);
+    wheel->next = malloc(sizeof(int) * sim->settings.node_count);
+    wheel->visit_cycle = malloc(sizeof(unsigned long) * sim->settings.node_count);
+    wheel->due = calloc(wheel->due_words, sizeof(unsigned long long));
+    if (wheel->slot_head == NULL || wheel->next == NULL || 
+        wheel->visit_cycle == NULL || wheel->due == NULL) {
+        printf("MCU wheel memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < wheel->slots; i++) {
+        wheel->slot_head[i] = -1;
+    }
+    for (int i = sim->settings.node_count - 1; i >= 0; i--) {
+        if (sim->nodes[i].wake_cycle > sim->state.current_cycle + 1) {
+            mcu_wheel_insert(wheel, i, sim->nodes[i].wake_cycle);
+        }
+        else {
+            mcu_wheel_insert(wheel, i, sim->state.current_cycle + 1);
+        }
+    }
+    return 0;
+}
+
+int free_mcu_wheel(struct MCU_Wheel* wheel) {
+    free(wheel->slot_head);
+    free(wheel->next);
+    free(wheel->visit_cycle);
+    free(wheel->due);
+    return 0;
+}
+
+// put node into the wheel slot for the cycle it should be visited next
+int mcu_wheel_insert(struct MCU_Wheel* wheel, int id, unsigned long cycle) {
+    int slot = cycle & (wheel->slots - 1);
+    wheel->visit_cycle[id] = cycle;
+    wheel->next[id] = wheel->slot_head[slot];
+    wheel->slot_head[slot] = id;
+    return 0;
+}
+
+// take node out of the wheel slot it was put in
+int mcu_wheel_remove(struct MCU_Wheel* wheel, int id) {
+    int* link = &wheel->slot_head[wheel->visit_cycle[id] & (wheel->slots - 1)];
+    while (*link != -1) {
+        if (*link == id) {
+            *link = wheel->next[id];
+            return 0;
+        }
+        link = &wheel->next[*link];
+    }
+    return -1;
+}
 
 /**
  * Microcontroller node selection
- * Desc: Cycles through all nodes and calls MCU function handler for each
+ * Desc: Calls MCU function handler for each node whose wake-up cycle is now.
+ *       Due nodes are taken from the current wheel slot and marked in a bitmap
+ *       so they run in ascending id order, same as visiting every node.
 **/
-int update_mcu(struct Node* nodes) {
-    for (int i = 0; i < settings.node_count; i++) {
-        // To-do!!! check to make sure nodes aren't on ground
-        mcu_run_function(nodes, i);
+int update_mcu(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
+    struct MCU_Wheel* wheel = &sim->wheel;
+    int slot = sim->state.current_cycle & (wheel->slots - 1);
+    int id = wheel->slot_head[slot];
+    wheel->slot_head[slot] = -1;
+
+    // Nodes due a later time around the wheel stay in the slot
+    while (id != -1) {
+        int next = wheel->next[id];
+        if (wheel->visit_cycle[id] == sim->state.current_cycle) {
+            wheel->due[id / 64] |= 1ULL << (id % 64);
+        }
+        else {
+            wheel->next[id] = wheel->slot_head[slot];
+            wheel->slot_head[slot] = id;
+        }
+        id = next;
+    }
+
+    for (int i = 0; i < wheel->due_words; i++) {
+        unsigned long long due = wheel->due[i];
+        wheel->due[i] = 0;
+        while (due != 0) {
+            id = i * 64 + __builtin_ctzll(due);
+            due &= due - 1;
+            // To-do!!! check to make sure nodes aren't on ground
+            mcu_run_function(sim, id);
+            if (nodes[id].wake_cycle > sim->state.current_cycle) {
+                mcu_wheel_insert(wheel, id, nodes[id].wake_cycle);
+            }
+            else {
+                mcu_wheel_insert(wheel, id, sim->state.current_cycle + 1);
+            }
+        }
     }
     return 0;
 }
 
+/**
+ * Microcontroller function table
+ * Desc: Handler, busy time and name for each MCU function number. A function
+ *       called with mcu_call() first spends its busy time, then the handler
+ *       runs on the cycle the node wakes. New protocol functions only need a
+ *       row here.
+**/
+_Static_assert(MCU_FUNCTION_COUNT == CYCLE_TIMER_FUNCTIONS, "cycle timer slots are sized to the MCU functions");
+
+const struct MCU_Function mcu_function_table[MCU_FUNCTION_COUNT] = {
+    [0]  = {"main",                      mcu_function_main,                      MCU_BUSY_NONE,   0},
+    [1]  = {"scan_lfg",                  mcu_function_scan_lfg,                  MCU_BUSY_FIXED,  0},
+    [2]  = {"broadcast_lfg",             mcu_function_broadcast_lfg,             MCU_BUSY_FIXED,  0},
+    [3]  = {"find_clear_channel",        mcu_function_find_clear_channel,        MCU_BUSY_FIXED,  0},
+    [4]  = {"check_channel_busy",        mcu_function_check_channel_busy,        MCU_BUSY_FIXED,  0},
+    [5]  = {"transmit_message_begin",    mcu_function_transmit_message_begin,    MCU_BUSY_FIXED,  0},
+    [6]  = {"transmit_message_complete", mcu_function_transmit_message_complete, MCU_BUSY_TICKS,  5},    // time to send packet
+    [7]  = {"receive",                   mcu_function_receive,                   MCU_BUSY_FIXED,  0},
+    [8]  = {"sleep",                     mcu_function_sleep,                     MCU_BUSY_FIXED,  1.0},  // sleep for 1.0 second
+    [9]  = {"respond_lfg",               mcu_function_respond_lfg,               MCU_BUSY_FIXED,  0},
+    [10] = {"scan_lfg_responses",        mcu_function_scan_lfg_responses,        MCU_BUSY_FIXED,  0},
+    [11] = {"random_wait",               mcu_function_random_wait,               MCU_BUSY_RANDOM, 500},  // up to 499 ticks
+    [12] = {"lfgr_send_ack",             mcu_function_lfgr_send_ack,             MCU_BUSY_FIXED,  0},
+    [13] = {"lfgr_get_ack",              mcu_function_lfgr_get_ack,              MCU_BUSY_FIXED,  0},
+    [14] = {"group_cycle_start",         mcu_function_group_cycle_start,         MCU_BUSY_FIXED,  0},
+    [15] = {"sensor_data_send",          mcu_function_sensor_data_send,          MCU_BUSY_FIXED,  0},
+    [16] = {"sensor_data_recv",          mcu_function_sensor_data_recv,          MCU_BUSY_FIXED,  0},
+    [17] = {"sensor_data_relay",         mcu_function_sensor_data_relay,         MCU_BUSY_FIXED,  0},
+};
+
+// Busy time in seconds a function's table entry asks for
+static double mcu_busy_time(struct Simulation* sim, int id, const struct MCU_Function* function) {
+    switch (function->busy_policy) {
+        case MCU_BUSY_TICKS:
+            return sim->settings.time_resolution * function->busy_value;
+        case MCU_BUSY_RANDOM:
+            return (node_rand(sim, id, RNG_PURPOSE_WAIT) % (uint32_t)function->busy_value) * 
+                   sim->settings.time_resolution;
+        default:
+            return function->busy_value;
+    }
+}
+
 /**
  * Microcontroller function selection handling
- * Desc: See which function a nodes MCU should be executing and set/check busy times
- *
- * Functions:
- * ----------------
- *  0: main
- *  1: scan_lfg
- *  2: broadcast_lfg
- *  3: find_clear_channel
- *  4: check_channel_busy
- *  5: transmit_message_begin
- *  6: transmit_message_complete
- *  7: receive
- *  8: sleep
- *  9: respond_lfg
- * 10: scan_lfg_responses
- * 11: random_wait
- * 12: lfgr_send_ack
- * 13: lfgr_get_ack
- * 14: group_cycle_start
- * 15: sensor_data_send
- * 16: sensor_data_recv
- * 17: sensor_data_relay
+ * Desc: See which function a nodes MCU should be executing and set/check busy
+ *       times, see mcu_function_table for the function numbers
 **/
-int mcu_run_function(struct Node* nodes, int id) {
-    double busy_time = 0.00;
-    //printf("Node %d function %d\n", id, nodes[id].current_function);
-
-    mcu_update_busy_time(nodes, id);
-
-    if (nodes[id].busy_remaining <= 0) {
-        switch (nodes[id].current_function) {
-            case 0:                         // initial starting point for all nodes
-                mcu_function_main(nodes, id);
-                break;
-            case 1:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0;      
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {
-                    mcu_function_scan_lfg(nodes, id);
-                }
-                break;
-            case 2:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0;
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {
-                    mcu_function_broadcast_lfg(nodes, id);
-                }
-                break;
-            case 3:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_find_clear_channel(nodes, id);
-                }
-                break;
-            case 4:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       // removing busy time for now
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_check_channel_busy(nodes, id);
-                }
-                break;
-            case 5:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_transmit_message_begin(nodes, id);
-                }
-                break;
-            case 6:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = settings.time_resolution * 5;                // time to send packet?
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_transmit_message_complete(nodes, id);
-                }
-                break;
-            case 7:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_receive(nodes, id);
-                }
-                break;
-            case 8:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 1.00;       // sleep for 1.0 second
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_sleep(nodes, id);
-                }
-                break;
-            case 9:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_respond_lfg(nodes, id);
-                }
-                break;
-            case 10:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_scan_lfg_responses(nodes, id);
-                }
-                break;
-            case 11:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = (rand() % 500) * settings.time_resolution;  // random busy time 
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {
-                    mcu_function_random_wait(nodes, id);
-                }
-                break;
-            case 12:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_lfgr_send_ack(nodes, id);
-                }
-                break;
-            case 13:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_lfgr_get_ack(nodes, id);
-                }
-                break;     
-            case 14:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_group_cycle_start(nodes, id);
-                }
-                break;   
-            case 15:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_sensor_data_send(nodes, id);
-                }
-                break; 
-            case 16:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_sensor_data_recv(nodes, id);
-                }
-                break;
-            case 17:
-                if (nodes[id].busy_remaining < 0) {
-                    busy_time = 0.00;       
-                    nodes[id].busy_remaining = busy_time;
-                }
-                else {            
-                    mcu_function_sensor_data_relay(nodes, id);
-                }
-                break;         
-            default:
-                abort ();
+int mcu_run_function(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
+
+    if (nodes[id].wake_cycle <= sim->state.current_cycle) {
+        if (nodes[id].current_function < 0 || nodes[id].current_function >= MCU_FUNCTION_COUNT) {
+            abort ();
+        }
+        int number = nodes[id].current_function;
+        const struct MCU_Function* function = &mcu_function_table[number];
+        if (nodes[id].wait_channel != CHANNEL_WAIT_NONE) {
+            // Waited until wake_cycle without hearing a transmitter start
+            channel_wait_cancel(sim, id);
         }
+        PROFILE_BEGIN(start);
+        if (sim->settings.debug >= 3) {
+            printf("Node %d function %s\n", id, function->name);
+        }
+
+        if (nodes[id].busy_pending && function->busy_policy != MCU_BUSY_NONE) {
+            mcu_set_busy_time(sim, id, mcu_busy_time(sim, id, function));
+        }
+        else {
+            function->handler(sim, id);
+        }
+        PROFILE_FUNCTION(sim, number, start);
+    }
+    return 0;
+}
+
+// set node wake-up cycle from busy time in seconds
+int mcu_set_busy_time(struct Simulation* sim, int id, double busy_time) {
+    struct Node* nodes = sim->nodes;
+    unsigned long busy_cycles = mcu_busy_cycles(sim, busy_time);
+    if (busy_cycles < 1) {
+        busy_cycles = 1;
     }
+    nodes[id].busy_pending = 0;
+    nodes[id].wake_cycle = sim->state.current_cycle + busy_cycles;
     return 0;
 }
 
-// update node busy times
-int mcu_update_busy_time(struct Node* nodes, int id) {
-    if (nodes[id].busy_remaining > 0) {
-        if (nodes[id].busy_remaining - settings.time_resolution > 0) {
-            nodes[id].busy_remaining -= settings.time_resolution;
+// number of ticks for busy time to count down to zero one time_resolution at a time
+unsigned long mcu_busy_cycles(struct Simulation* sim, double busy_remaining) {
+    unsigned long cycles = 0;
+    while (busy_remaining > 0) {
+        if (busy_remaining - sim->settings.time_resolution > 0) {
+            busy_remaining -= sim->settings.time_resolution;
         }
         else {
-            nodes[id].busy_remaining = 0;
-        } 
+            busy_remaining = 0;
+        }
+        cycles++;
     }
-    return 0;
+    return cycles;
 }
 
-int mcu_call(struct Node* nodes, int id, int caller, int return_to_label, int function_number) {
-    fs_push(caller, return_to_label, &nodes[id].function_stack);
-    nodes[id].busy_remaining = -1;
+int mcu_call(struct Simulation* sim, int id, int caller, int return_to_label, int function_number) {
+    struct Node* nodes = sim->nodes;
+    fs_push(&nodes[id], caller, return_to_label);
+    nodes[id].busy_pending = 1;
+    nodes[id].wake_cycle = sim->state.current_cycle + 1;
     nodes[id].current_function = function_number;
     return 0;
 }
 
-int mcu_return(struct Node* nodes, int id, int function_number, int return_value) {
+/**
+ * Microcontroller listening call
+ * Desc: mcu_call() for the next poll of a listening loop. The poll waits
+ *       for a transmitter to start on channel (any channel with
+ *       CHANNEL_WAIT_ANY) while there isn't one, but no later than
+ *       wake_cycle, see channel_wait()
+**/
+int mcu_call_listening(struct Simulation* sim, int id, int caller, int return_to_label, int function_number, 
+                       int channel, unsigned long wake_cycle) {
+    mcu_call(sim, id, caller, return_to_label, function_number);
+    channel_wait(sim, id, channel, wake_cycle);
+    return 0;
+}
+
+// Bring a waiting node's wake-up forward to the next cycle, moving it in the
+// engine's queue. Not used by worker threads, which don't keep a queue.
+int mcu_wake(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
+    unsigned long cycle = sim->state.current_cycle + 1;
+    if (nodes[id].wake_cycle <= cycle) {
+        return 0;
+    }
+    nodes[id].wake_cycle = cycle;
+    if (sim->settings.engine == ENGINE_EVENT) {
+        event_queue_remove(&sim->event_queue, id);
+        event_queue_push(&sim->event_queue, cycle, id);
+    }
+    else {
+        mcu_wheel_remove(&sim->wheel, id);
+        mcu_wheel_insert(&sim->wheel, id, cycle);
+    }
+    return 0;
+}
+
+int mcu_return(struct Simulation* sim, int id, int function_number, int return_value) {
+    struct Node* nodes = sim->nodes;
     nodes[id].current_function = nodes[id].function_stack->caller; 
-    rs_push(function_number, nodes[id].function_stack->return_to_label, return_value, &nodes[id].return_stack);
-    fs_pop(&nodes[id].function_stack);
-    nodes[id].busy_remaining = -1;
+    rs_push(&nodes[id], function_number, nodes[id].function_stack->return_to_label, return_value);
+    fs_pop(&nodes[id]);
+    nodes[id].busy_pending = 1;
+    nodes[id].wake_cycle = sim->state.current_cycle + 1;
     return 0;
 }
\ No newline at end of file
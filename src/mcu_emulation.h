@@ -12,10 +12,49 @@
 #ifndef mcuemulation_H
 #define mcuemulation_H
 
-int update_mcu(struct Node* nodes);
-int mcu_run_function(struct Node* nodes, int id);
-int mcu_update_busy_time(struct Node*, int);
-int mcu_call(struct Node*, int, int, int, int);
-int mcu_return(struct Node*, int, int, int);
+#define MCU_WHEEL_SLOTS 4096
+
+// Timing wheel of node MCU wake-up cycles
+struct MCU_Wheel {
+    int slots;
+    int* slot_head;
+    int* next;
+    unsigned long* visit_cycle;
+    unsigned long long* due;
+    int due_words;
+};
+
+struct Simulation;
+
+#define MCU_FUNCTION_COUNT  18
+
+// How a function's busy time before its handler runs is worked out
+#define MCU_BUSY_NONE       0   // no busy phase, handler runs on every wake
+#define MCU_BUSY_FIXED      1   // busy_value seconds
+#define MCU_BUSY_TICKS      2   // busy_value ticks
+#define MCU_BUSY_RANDOM     3   // random number of ticks below busy_value
+
+// One MCU function number
+struct MCU_Function {
+    const char* name;
+    int (*handler)(struct Simulation*, int);
+    int busy_policy;
+    double busy_value;
+};
+
+extern const struct MCU_Function mcu_function_table[MCU_FUNCTION_COUNT];
+
+int initialize_mcu_wheel(struct Simulation* sim);
+int free_mcu_wheel(struct MCU_Wheel* wheel);
+int mcu_wheel_insert(struct MCU_Wheel* wheel, int, unsigned long);
+int mcu_wheel_remove(struct MCU_Wheel* wheel, int);
+int update_mcu(struct Simulation* sim);
+int mcu_run_function(struct Simulation* sim, int id);
+int mcu_set_busy_time(struct Simulation*, int, double);
+unsigned long mcu_busy_cycles(struct Simulation*, double);
+int mcu_call(struct Simulation*, int, int, int, int);
+int mcu_call_listening(struct Simulation*, int, int, int, int, int, unsigned long);
+int mcu_wake(struct Simulation*, int);
+int mcu_return(struct Simulation*, int, int, int);
 
 #endif
\ No newline at end of file
@@ -6,13 +6,25 @@
  * @date    1/1/2021
 **/
 
+#include <limits.h>
 #include "mcu_functions.h"
+#include "channels.h"
 #include "messages.h"
+#include "packet.h"
+#include "rng.h"
+#include "simulation.h"
 #include "state.h"
 #include "timers.h"
 
-extern struct Settings settings;
-extern struct State state;
+// Debug text of the packet node id has ready to send
+static char* send_packet_text(struct Simulation* sim, int id, char* text, int size) {
+    struct Packet packet;
+    text[0] = '\0';
+    if (packet_read(&sim->packets, sim->nodes[id].send_packet, &packet, 1) == 0) {
+        packet_format(&packet, text, size);
+    }
+    return text;
+}
 
 /**
  * Function Number:             0
@@ -37,17 +49,18 @@ extern struct State state;
 
  * Function Returns:            nothing
 **/
-int mcu_function_main(struct Node* nodes, int id) {
+int mcu_function_main(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 0;
 
     if (nodes[id].return_stack->returning_from == 1) {
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
 
         // see if group cycle timer has expired
-        if (nodes[id].group_cycle_start + settings.group_cycle_interval <= state.current_cycle) {
+        if (nodes[id].group_cycle_start + sim->settings.group_cycle_interval <= sim->state.current_cycle) {
             // Timer expired
-            mcu_call(nodes, id, own_function_number, 7, 14);
+            mcu_call(sim, id, own_function_number, 7, 14);
             return 0;
         }
 
@@ -58,47 +71,49 @@ int mcu_function_main(struct Node* nodes, int id) {
         else {
             // respond to LFG broadcast from node with strongest signal
             int strongest_node_id = -1;
-            double strongest_signal = 1; // using 1 for testing
+            double strongest_signal = SIGNAL_LFG_THRESHOLD;
             
             // if debugging, print nodes found
-            if (settings.debug) {
+            if (sim->settings.debug) {
                 printf("After scanning node %d heard broadcasts from: \n", id);
             }
     
             // find strongest signal broadcasting LFG
-            for (int i = 0; i < settings.channels; i++) {
+            for (int i = 0; i < sim->settings.channels; i++) {
                 if (nodes[id].tmp_lfg_chans[i] != -1) {
-                    if (settings.debug) {
+                    if (sim->settings.debug) {
                         printf("  Node %d (%f dBM)\n", nodes[id].tmp_lfg_chans[i], 
-                               nodes[id].received_signals[nodes[id].tmp_lfg_chans[i]]);
+                               get_signal(sim, id, nodes[id].tmp_lfg_chans[i]));
                     }
-                    if (nodes[id].received_signals[nodes[id].tmp_lfg_chans[i]] > strongest_signal) {
+                    if (signal_over_threshold(sim, id, nodes[id].tmp_lfg_chans[i]) &&
+                        (strongest_node_id == -1 || 
+                         get_signal(sim, id, nodes[id].tmp_lfg_chans[i]) > strongest_signal)) {
                         strongest_node_id = nodes[id].tmp_lfg_chans[i];
-                        strongest_signal = nodes[id].received_signals[nodes[id].tmp_lfg_chans[i]];
+                        strongest_signal = get_signal(sim, id, nodes[id].tmp_lfg_chans[i]);
                     }
                 }
             }
             // if no available nodes, scan again
             if (strongest_node_id == -1) {
-                if (settings.debug) {
+                if (sim->settings.debug) {
                     printf("Node %d didn't hear any LFG messages, scanning again\n", id);
                 }
-                mcu_call(nodes, id, own_function_number, 1, 1);
+                mcu_call(sim, id, own_function_number, 1, 1);
                 return 0;
             }
-            if (settings.debug) {
+            if (sim->settings.debug) {
             printf("Node %d will attempt to send LFG-R to node %d on channel %d\n",
-                    id, strongest_node_id, nodes[strongest_node_id].active_channel);
+                    id, strongest_node_id, peer_active_channel(sim, strongest_node_id));
             }
             
             // set active channel to same channel as strongest LFG broadcaster
-            nodes[id].active_channel = nodes[strongest_node_id].active_channel;
+            set_active_channel(sim, id, peer_active_channel(sim, strongest_node_id));
 
             // set destination node id
             nodes[id].dest_node = strongest_node_id;
 
             // call respond_lfg
-            mcu_call(nodes, id, own_function_number, 2, 9);
+            mcu_call(sim, id, own_function_number, 2, 9);
             return 0;
         }
     }
@@ -106,116 +121,116 @@ int mcu_function_main(struct Node* nodes, int id) {
         // returning from LFG broadcast, listen for replies for specified time
         // TO-DO: make scan time a parameter later
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value < 0) {    
             printf("No clear channels found\n");    
         }
         else {
             // scan for LFG reply packets
-            if (settings.debug) {
+            if (sim->settings.debug) {
                 printf("Node %d listening for LFG replies\n", id);
             }
-            mcu_call(nodes, id, own_function_number, 4, 10);
+            mcu_call(sim, id, own_function_number, 4, 10);
             return 0;
         }
 
     }
     else if (nodes[id].return_stack->returning_from == 8) {
         int label = nodes[id].return_stack->return_to_label;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
 
         // see if group cycle timer has expired
-        if (nodes[id].group_cycle_start + settings.group_cycle_interval <= state.current_cycle) {
+        if (nodes[id].group_cycle_start + sim->settings.group_cycle_interval <= sim->state.current_cycle) {
             // Timer expired
-            mcu_call(nodes, id, own_function_number, 7, 14);
+            mcu_call(sim, id, own_function_number, 7, 14);
             return 0;
         }
 
         if (label == 3) {
             // non-broadcaster, send sensor data
             // TO-DO, add return for this
-            mcu_call(nodes, id, own_function_number, 8, 15);
+            mcu_call(sim, id, own_function_number, 8, 15);
             return 0;
         }
 
         // if timer not expired, stay asleep
-        mcu_call(nodes, id, own_function_number, 5, 8);
+        mcu_call(sim, id, own_function_number, 5, 8);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 9) {
         // for now, just go to sleep
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 3, 8);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 3, 8);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 10) {
         // listen for DATA packets
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 9, 16);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 9, 16);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 14) {
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (nodes[id].broadcaster == 1) {
-            mcu_call(nodes, id, own_function_number, 0, 2);
+            mcu_call(sim, id, own_function_number, 0, 2);
             return 0; 
         }
         else {
-            mcu_call(nodes, id, own_function_number, 1, 1);
+            mcu_call(sim, id, own_function_number, 1, 1);
             return 0;
         }
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 10) {
         // listen for DATA packets
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 9, 16);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 9, 16);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 15) {
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
 
         // see if group cycle timer has expired
-        if (nodes[id].group_cycle_start + settings.group_cycle_interval <= state.current_cycle) {
+        if (nodes[id].group_cycle_start + sim->settings.group_cycle_interval <= sim->state.current_cycle) {
             // Timer expired
-            mcu_call(nodes, id, own_function_number, 7, 14);
+            mcu_call(sim, id, own_function_number, 7, 14);
             return 0;
         }
         else {
             // keep transmitting DATA packets 
-            mcu_call(nodes, id, own_function_number, 8, 15);
+            mcu_call(sim, id, own_function_number, 8, 15);
         }
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 16) {
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // see if group cycle timer has expired
-        if (nodes[id].group_cycle_start + settings.group_cycle_interval <= state.current_cycle) {
+        if (nodes[id].group_cycle_start + sim->settings.group_cycle_interval <= sim->state.current_cycle) {
             // Timer expired
-            mcu_call(nodes, id, own_function_number, 7, 14);
+            mcu_call(sim, id, own_function_number, 7, 14);
             return 0;
         }
         // relay messages to ground
-        mcu_call(nodes, id, own_function_number, 10, 17);
+        mcu_call(sim, id, own_function_number, 10, 17);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 17) {
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // see if group cycle timer has expired
-        if (nodes[id].group_cycle_start + settings.group_cycle_interval <= state.current_cycle) {
+        if (nodes[id].group_cycle_start + sim->settings.group_cycle_interval <= sim->state.current_cycle) {
             // Timer expired
-            mcu_call(nodes, id, own_function_number, 7, 14);
+            mcu_call(sim, id, own_function_number, 7, 14);
             return 0;
         }
         
         // keep listening
-        mcu_call(nodes, id, own_function_number, 9, 16);
+        mcu_call(sim, id, own_function_number, 9, 16);
         return 0;
     }
     else {
         // First time entering main
         // Start group cycle
-        mcu_call(nodes, id, own_function_number, 7, 14);
+        mcu_call(sim, id, own_function_number, 7, 14);
     }
     return 0;
 }
@@ -233,22 +248,23 @@ int mcu_function_main(struct Node* nodes, int id) {
  * Function Returns:            -1 - no LFG found
  *                              ID - node broadcasting LFG with <ID>
 **/
-int mcu_function_scan_lfg(struct Node* nodes, int id) {
+int mcu_function_scan_lfg(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 1;
 
     if (nodes[id].return_stack->returning_from == 7) {
         // Returning from receive function
         // Return value is sending node ID
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value == -1) {
             // collision detected try again 
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            mcu_call(sim, id, own_function_number, 1, 7);
             return 0;
         }
         if (return_value == -2) {
-            // Nothing heard try again
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            // Nothing heard try again, once something transmits
+            mcu_call_listening(sim, id, own_function_number, 1, 7, nodes[id].active_channel, ULONG_MAX);
             return 0;
         }
         else {
@@ -256,19 +272,9 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
             nodes[id].tmp_scanned_chans[nodes[id].active_channel] = 1;
 
             // Check for LFG
-            char* token;
-            char incoming_buffer[256];
-
-            strncpy(incoming_buffer, nodes[return_value].send_packet, 256);
-
-            token = strtok(incoming_buffer, " ");
-            if (token != NULL) {
-                token = strtok(NULL, " ");
-            }
-            if (token != NULL) {
-                token = strtok(NULL, " ");
-            }
-            if (strcmp(token, "LFG") == 0) {
+            struct Packet packet;
+            peer_packet(sim, return_value, &packet, 0);
+            if (packet.type == PACKET_TYPE_LFG) {
                 // Found LFG packet, add to LFG tmp array
                 // Put sending node id into correct channel slot of array
                 nodes[id].tmp_lfg_chans[nodes[id].active_channel] = return_value;
@@ -277,7 +283,7 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
             // Keep scanning if not at last channel
             // See how many unscanned channels are left
             int unscanned_channel_count = 0;
-            for (int i = 0; i < settings.channels; i++) {
+            for (int i = 0; i < sim->settings.channels; i++) {
                 if (nodes[id].tmp_scanned_chans[i] == 0) {
                     unscanned_channel_count++;
                 }
@@ -285,13 +291,13 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
             if (unscanned_channel_count == 0) {
                 // If all channels scanned, clear array and scan again 
                 // Initialize tmp_scanned_chans array
-                for (int i = 0; i < settings.channels; i++) {
+                for (int i = 0; i < sim->settings.channels; i++) {
                     nodes[id].tmp_scanned_chans[i] = 0;
                 }
                 // Pick random start channel
-                nodes[id].active_channel = rand() % settings.channels;
+                set_active_channel(sim, id, node_rand(sim, id, RNG_PURPOSE_CHANNEL) % sim->settings.channels);
                 // Check if first channel is busy
-                mcu_call(nodes, id, own_function_number, 0, 4); 
+                mcu_call(sim, id, own_function_number, 0, 4); 
                 return 0;
             }
             else {
@@ -306,8 +312,8 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
                     channel++;
                 }
                 // Pick an unscanned channel at random to try next
-                nodes[id].active_channel = unscanned_chans[rand() % unscanned_channel_count];
-                mcu_call(nodes, id, own_function_number, 0, 4);
+                set_active_channel(sim, id, unscanned_chans[node_rand(sim, id, RNG_PURPOSE_CHANNEL) % unscanned_channel_count]);
+                mcu_call(sim, id, own_function_number, 0, 4);
                 return 0;
             }
         }
@@ -315,28 +321,30 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
     else if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
 
         // Check cycle timer
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
-            mcu_return(nodes, id, own_function_number, 0);
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
+            mcu_return(sim, id, own_function_number, 0);
             return 0;
         }
     
         // Mark channel as scanned
         if (return_value == 1) {
             // Activity on channel, get packet
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            mcu_call(sim, id, own_function_number, 1, 7);
             return 0;
         }
         else {
             // Mark channel as scanned
             nodes[id].tmp_scanned_chans[nodes[id].active_channel] = 1;
 
-            // Didn't hear anything, go to next channel
+            // Didn't hear anything, go to next channel. While no channel
+            // has a transmitter the next check waits for one to start
+            unsigned long scan_end = cycle_timer_expiry(nodes[id].timers, own_function_number, 0);
             // See how many unscanned channels are left
             int unscanned_channel_count = 0;
-            for (int i = 0; i < settings.channels; i++) {
+            for (int i = 0; i < sim->settings.channels; i++) {
                 if (nodes[id].tmp_scanned_chans[i] == 0) {
                     unscanned_channel_count++;
                 }
@@ -344,13 +352,13 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
             if (unscanned_channel_count == 0) {
                 // If all channels scanned, clear array and scan again 
                 // Initialize tmp_scanned_chans array
-                for (int i = 0; i < settings.channels; i++) {
+                for (int i = 0; i < sim->settings.channels; i++) {
                     nodes[id].tmp_scanned_chans[i] = 0;
                 }
                 // Pick random start channel
-                nodes[id].active_channel = rand() % settings.channels;
+                set_active_channel(sim, id, node_rand(sim, id, RNG_PURPOSE_CHANNEL) % sim->settings.channels);
                 // Check if first channel is busy
-                mcu_call(nodes, id, own_function_number, 0, 4); 
+                mcu_call_listening(sim, id, own_function_number, 0, 4, CHANNEL_WAIT_ANY, scan_end);
                 return 0;
             }
             else {
@@ -366,8 +374,8 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
                 }
 
                 // Pick an unscanned channel at random to try next
-                nodes[id].active_channel = unscanned_chans[rand() % unscanned_channel_count];
-                mcu_call(nodes, id, own_function_number, 0, 4);
+                set_active_channel(sim, id, unscanned_chans[node_rand(sim, id, RNG_PURPOSE_CHANNEL) % unscanned_channel_count]);
+                mcu_call_listening(sim, id, own_function_number, 0, 4, CHANNEL_WAIT_ANY, scan_end);
                 return 0;
             }
         }
@@ -375,24 +383,23 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
     else {
         // First time entering function
         // Create cycle timer
-        if (settings.debug) {
-            printf("Node %d created cycle timer for function %d\n", id, own_function_number);
+        if (sim->settings.debug) {
+            printf("Node %d created cycle timer for function %s\n", id, mcu_function_table[own_function_number].name);
         }
-        nodes[id].timers = 
-            cycle_timer_create(nodes[id].timers, own_function_number, 0, state.current_cycle, 1000);
+        cycle_timer_arm(nodes[id].timers, own_function_number, 0, sim->state.current_cycle, 1000);
 
         // Initialize LFG tmp array before scanning
-        for (int i = 0; i < settings.channels; i++) {
+        for (int i = 0; i < sim->settings.channels; i++) {
             nodes[id].tmp_lfg_chans[i] = -1;
         }
         // Initialize tmp_scanned_chans array
-        for (int i = 0; i < settings.channels; i++) {
+        for (int i = 0; i < sim->settings.channels; i++) {
             nodes[id].tmp_scanned_chans[i] = 0;
         }
         // Pick random start channel
-        nodes[id].active_channel = rand() % settings.channels;
+        set_active_channel(sim, id, node_rand(sim, id, RNG_PURPOSE_CHANNEL) % sim->settings.channels);
         // Check if first channel is busy
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;
 }
@@ -423,69 +430,70 @@ int mcu_function_scan_lfg(struct Node* nodes, int id) {
  * Function Returns:            -1 - no clear channels
  *                              channel - sent LFG on <channel>
 **/
-int mcu_function_broadcast_lfg(struct Node* nodes, int id) {
+int mcu_function_broadcast_lfg(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 2;
 
     if (nodes[id].return_stack->returning_from == 11) {
         // Returned from random wait
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 0, 3);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 0, 3);
         return 0;
     }                            
     else if (nodes[id].return_stack->returning_from == 3) {
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value >= 0) {
             // If clear channel was found, broadcast LFG on it
-            snprintf(nodes[id].send_packet, 256, "N-ALL N-%d LFG", id);
-        if (settings.debug) {
+            struct Packet packet = {.dest = PACKET_ADDR_ALL, .type = PACKET_TYPE_LFG};
+            node_send_packet(sim, id, &packet, PACKET_NONE);
+        if (sim->settings.debug) {
             printf("Node %d broadcasting LFG on channel %d\n", id, nodes[id].active_channel);
         }
-            mcu_call(nodes, id, own_function_number, 1, 5);
+            mcu_call(sim, id, own_function_number, 1, 5);
             return 0;
         }
         else {
             // No clear channel was found, notify caller
-            mcu_return(nodes, id, own_function_number, -1);
+            mcu_return(sim, id, own_function_number, -1);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 5) {
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // Check cycle timer
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
             // time expired, stop transmitting
-            mcu_call(nodes, id, own_function_number, 4, 6);
+            mcu_call(sim, id, own_function_number, 4, 6);
             return 0;
         }
         else {
             // No error checking for now, just transmit until timer expired
-            mcu_call(nodes, id, own_function_number, 4, 5);
+            mcu_call(sim, id, own_function_number, 4, 5);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 6) {
         // Returning from transmit_message_complete
-        if (settings.debug) {
+        if (sim->settings.debug) {
             printf("Node %d stopped broadcasting LFG\n", id);
         }
         // No error checking for now
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // Return to main
-        mcu_return(nodes, id, own_function_number, nodes[id].active_channel);
+        mcu_return(sim, id, own_function_number, nodes[id].active_channel);
 
         return 0;
     }
     else {  
         // Not returning from a call
         // Create cycle timer
-        if (settings.debug) {
-            printf("Node %d created cycle timer for function %d\n", id, own_function_number);
+        if (sim->settings.debug) {
+            printf("Node %d created cycle timer for function %s\n", id, mcu_function_table[own_function_number].name);
         }
-        nodes[id].timers = 
-            cycle_timer_create(nodes[id].timers, own_function_number, 0, state.current_cycle, 1000);  
+        cycle_timer_arm(nodes[id].timers, own_function_number, 0, sim->state.current_cycle, 1000);  
         
-        mcu_call(nodes, id, own_function_number, 3, 11);
+        mcu_call(sim, id, own_function_number, 3, 11);
     }
     return 0;
 }
@@ -504,14 +512,15 @@ int mcu_function_broadcast_lfg(struct Node* nodes, int id) {
  * Function Returns:            -1 - no clear channels
  *                              channel - first available free channel
 **/
-int mcu_function_find_clear_channel(struct Node* nodes, int id) {
+int mcu_function_find_clear_channel(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 3;
 
     // check for return
     if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // Mark channel as scanned
         nodes[id].tmp_scanned_chans[nodes[id].active_channel] = 1;
 
@@ -520,14 +529,14 @@ int mcu_function_find_clear_channel(struct Node* nodes, int id) {
             // Channel was busy, find another unless all are busy
             // First, see how many channels haven't been checked
             int unscanned_channel_count = 0;
-            for (int i = 0; i < settings.channels; i++) {
+            for (int i = 0; i < sim->settings.channels; i++) {
                 if (nodes[id].tmp_scanned_chans[i] == 0) {
                     unscanned_channel_count++;
                 }
             }
             if (unscanned_channel_count == 0) {
                 // All channels have been scanned
-                mcu_return(nodes, id, own_function_number, -1);
+                mcu_return(sim, id, own_function_number, -1);
                 return 0;
             }
             else {
@@ -542,25 +551,25 @@ int mcu_function_find_clear_channel(struct Node* nodes, int id) {
                     channel++;
                 }
                 // Pick an unscanned channel at random to try next
-                nodes[id].active_channel = unscanned_chans[rand() % unscanned_channel_count];
-                mcu_call(nodes, id, own_function_number, 0, 4);
+                set_active_channel(sim, id, unscanned_chans[node_rand(sim, id, RNG_PURPOSE_CHANNEL) % unscanned_channel_count]);
+                mcu_call(sim, id, own_function_number, 0, 4);
                 return 0;
             }
         }
         else {
             // Channel was free, return to caller
-            mcu_return(nodes, id, own_function_number, nodes[id].active_channel);
+            mcu_return(sim, id, own_function_number, nodes[id].active_channel);
             return 0;
         }
     }
     else {
         // Not returning from a call (first entry)
         // Initialize tmp_scanned_chans array
-        for (int i = 0; i < settings.channels; i++) {
+        for (int i = 0; i < sim->settings.channels; i++) {
             nodes[id].tmp_scanned_chans[i] = 0;
         }
-        nodes[id].active_channel = rand() % settings.channels;
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        set_active_channel(sim, id, node_rand(sim, id, RNG_PURPOSE_CHANNEL) % sim->settings.channels);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;
 }
@@ -576,18 +585,18 @@ int mcu_function_find_clear_channel(struct Node* nodes, int id) {
  * Function Returns:            0 - channel free
  *                              1 - channel busy
 **/
-int mcu_function_check_channel_busy(struct Node* nodes, int id) {
+int mcu_function_check_channel_busy(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 4;
     
-    for (int i = 0; i < settings.node_count; i++) {
-        if (i != id) {                  // don't check own id
-            if (nodes[id].active_channel == nodes[i].active_channel && nodes[i].transmit_active == 1) {
-                mcu_return(nodes, id, own_function_number, 1);
-                return 0;
-            }
-        }
+    // don't count own transmission, or any out of radio range
+    int busy = sim->grid.enabled ? channel_audible_transmitters(sim, nodes[id].active_channel, id, NULL, NULL)
+                                 : channel_transmitters(sim, nodes[id].active_channel, id);
+    if (busy > 0) {
+        mcu_return(sim, id, own_function_number, 1);
+        return 0;
     }
-    mcu_return(nodes, id, own_function_number, 0);
+    mcu_return(sim, id, own_function_number, 0);
     return 0;    
 }
 
@@ -601,12 +610,13 @@ int mcu_function_check_channel_busy(struct Node* nodes, int id) {
  * Function Returns:            0 - transmit error
  *                              1 - transmit successful
 **/
-int mcu_function_transmit_message_begin(struct Node* nodes, int id) {
+int mcu_function_transmit_message_begin(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 5;
     if (nodes[id].transmit_active == 0) {
-        nodes[id].transmit_active = 1;
+        set_transmit_active(sim, id, 1);
     }
-    mcu_return(nodes, id, own_function_number, 1);
+    mcu_return(sim, id, own_function_number, 1);
     return 0;    
 }
 
@@ -620,18 +630,18 @@ int mcu_function_transmit_message_begin(struct Node* nodes, int id) {
  * Function Returns:            0 - transmit error
  *                              1 - transmit successful
 **/
-int mcu_function_transmit_message_complete(struct Node* nodes, int id) {
+int mcu_function_transmit_message_complete(struct Simulation* sim, int id) {
     int own_function_number = 6;
     
     // Turn off transmit
-    nodes[id].transmit_active = 0;
+    set_transmit_active(sim, id, 0);
 
     // Erase send packet
     //for (int i = 0; i < sizeof(nodes[id].send_packet); i++) {
     //    nodes[id].send_packet[i] = '\0';
     //}
 
-    mcu_return(nodes, id, own_function_number, 1);
+    mcu_return(sim, id, own_function_number, 1);
     return 0;    
 }
 
@@ -645,36 +655,72 @@ int mcu_function_transmit_message_complete(struct Node* nodes, int id) {
  * Function Returns:           -2 - nothing received 
  *                             -1 - collision
  *                             ID - received data from node <id>
+ *
+ * With sinr set the strongest transmitter is received if its SINR clears
+ * capture_threshold, however many others are heard
 **/
-int mcu_function_receive(struct Node* nodes, int id) {
+int mcu_function_receive(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 7;
     int signals_detected = 0;
     int transmitting_node = -1;
+    struct Signal_Peak peak = {-1, 0};
 
-    for (int i = 0; i < settings.node_count; i++) {
-        if (i != id) {          // Don't check own ID
-            if (nodes[i].transmit_active && nodes[id].active_channel == nodes[i].active_channel) {
-                update_signal(nodes, id, i);
+    if (sim->grid.enabled) {
+        // Only transmitters within radio range are heard at all
+        signals_detected = channel_audible_transmitters(sim, nodes[id].active_channel, id, &peak,
+                                                        &transmitting_node);
+    }
+    else {
+        struct Channel_Occupancy* occupancy = &sim->channel_index[nodes[id].active_channel];
+        int heard[PATH_LOSS_BATCH];
+        int heard_count = 0;
+        for (int j = 0; j < occupancy->transmitter_count; j++) {
+            int i = occupancy->transmitters[j];
+            if (i != id) {          // Don't check own ID
+                heard[heard_count++] = i;
                 signals_detected++;
-                if (signals_detected > 1) {
+                // Same node a scan in id order would end on
+                if (i > transmitting_node) {
+                    transmitting_node = i;
                 }
-                transmitting_node = i;
             }
+            if (heard_count == PATH_LOSS_BATCH) {
+                update_signals(sim, id, nodes[id].active_channel, heard, heard_count, &peak);
+                heard_count = 0;
+            }
+        }
+        if (heard_count > 0) {
+            update_signals(sim, id, nodes[id].active_channel, heard, heard_count, &peak);
+        }
+    }
+    if (sim->interference.enabled && signals_detected > 0) {
+        int decoded = interference_decode(sim, id, nodes[id].active_channel, peak.id, peak.signal);
+        if (decoded == 1) {
+            if (signals_detected > 1) {
+                __atomic_fetch_add(&sim->state.sinr_captures, 1, __ATOMIC_RELAXED);
+            }
+            signals_detected = 1;
+            transmitting_node = peak.id;
+        }
+        else {
+            // Drowned out by other transmitters is a collision, by noise is nothing
+            signals_detected = decoded == -1 ? 2 : 0;
         }
     }
     if (signals_detected > 1) {
-        if (settings.debug) {
+        if (sim->settings.debug) {
             printf("Node %d detected collision\n", id);
         }
-        state.collisions++;
-        mcu_return(nodes, id, own_function_number, -1);
+        __atomic_fetch_add(&sim->state.collisions, 1, __ATOMIC_RELAXED);
+        mcu_return(sim, id, own_function_number, -1);
         return 0;
     }
     else if (signals_detected == 0) {
-        mcu_return(nodes, id, own_function_number, -2);
+        mcu_return(sim, id, own_function_number, -2);
         return 0;
     }
-    mcu_return(nodes, id, own_function_number, transmitting_node);
+    mcu_return(sim, id, own_function_number, transmitting_node);
     return 0;    
 }
 
@@ -687,9 +733,9 @@ int mcu_function_receive(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_sleep(struct Node* nodes, int id) {
+int mcu_function_sleep(struct Simulation* sim, int id) {
     int own_function_number = 8;
-    mcu_return(nodes, id, own_function_number, 0);
+    mcu_return(sim, id, own_function_number, 0);
     return 0;    
 }
 
@@ -719,90 +765,91 @@ int mcu_function_sleep(struct Node* nodes, int id) {
  * Function Returns:            -1 - no clear channels
  *                              channel - sent LFG on <channel>
 **/
-int mcu_function_respond_lfg(struct Node* nodes, int id) {
+int mcu_function_respond_lfg(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 9;
 
     if (nodes[id].return_stack->returning_from == 13) {
         // See if ACK was received
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
 
         // Check cycle timer
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
-            mcu_return(nodes, id, own_function_number, 0);
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
+            mcu_return(sim, id, own_function_number, 0);
             return 0;
         }
 
         if (return_value == 1) {
             // ACK was received, return to caller
-            mcu_return(nodes, id, own_function_number, nodes[id].active_channel);
+            mcu_return(sim, id, own_function_number, nodes[id].active_channel);
             return 0;
         }
         else {
             // ACK not received try again
             // later, check to see if group was full or other error
-            mcu_call(nodes, id, own_function_number, 4, 11);
+            mcu_call(sim, id, own_function_number, 4, 11);
             return 0; 
         }
     }
     else if (nodes[id].return_stack->returning_from == 11) {
         // Random wait is over
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // call transmit function
-        mcu_call(nodes, id, own_function_number, 1, 5);
+        mcu_call(sim, id, own_function_number, 1, 5);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
     
         // Check cycle timer
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
-            mcu_return(nodes, id, own_function_number, 0);
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
+            mcu_return(sim, id, own_function_number, 0);
             return 0;
         }
     
         if (return_value == 1) {
             // channel was busy, try again
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
         else if (return_value == 0) {
-            snprintf(nodes[id].send_packet, sizeof(nodes[id].send_packet), "N-%d N-%d LFG-R", 
-                     nodes[id].dest_node, id);
+            struct Packet packet = {.dest = nodes[id].dest_node, .type = PACKET_TYPE_LFG_R};
+            node_send_packet(sim, id, &packet, PACKET_NONE);
             // add random wait value before transmitting to minimize collisions
-            mcu_call(nodes, id, own_function_number, 3, 11);
+            mcu_call(sim, id, own_function_number, 3, 11);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 5) {
         // Returning from transmit_message_begin
         // No error checking for now
-        if (settings.debug) {
+        if (sim->settings.debug) {
+            char text[PACKET_TEXT_SIZE];
             printf("Node %d sent \"%s\" on channel %d\n", id, 
-                   nodes[id].send_packet, nodes[id].active_channel);
+                   send_packet_text(sim, id, text, sizeof(text)), nodes[id].active_channel);
         }
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 2, 6);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 2, 6);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 6) {
         // Returning from transmit_message_complete
         // No error checking for now, just check for ACK
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // Check for ACK
-        mcu_call(nodes, id, own_function_number, 4, 13);
+        mcu_call(sim, id, own_function_number, 4, 13);
         return 0;
     }
     else {
         // Not returning from a call (first entry)
         // Create cycle timer
-        nodes[id].timers = 
-            cycle_timer_create(nodes[id].timers, own_function_number, 0, state.current_cycle, 1000);
+        cycle_timer_arm(nodes[id].timers, own_function_number, 0, sim->state.current_cycle, 1000);
 
         // Check for activity on channel    
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;   
 }
@@ -816,15 +863,16 @@ int mcu_function_respond_lfg(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
+int mcu_function_scan_lfg_responses(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
     int own_function_number = 10;
 
     if (nodes[id].return_stack->returning_from == 12) {
         // Returning from ACK transmit
         // No return checking for now
         // Just keep scanning
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 0, 4);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 7) {
@@ -832,38 +880,27 @@ int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
         // Returning from receive function
         // Return value is sending node ID
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value == -1) {
             // collision detected try again 
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            mcu_call(sim, id, own_function_number, 1, 4);
             return 0;
         }
         if (return_value == -2) {
-            // Nothing heard try again
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            // Nothing heard try again, once something transmits
+            mcu_call_listening(sim, id, own_function_number, 1, 4, nodes[id].active_channel, 
+                               cycle_timer_expiry(nodes[id].timers, own_function_number, 0));
             return 0;
         }
         else {
             // Check for LFG-R
-            char* token;
-            char incoming_buffer[256];
-
-            strncpy(incoming_buffer, nodes[return_value].send_packet, 256);
-
-            token = strtok(incoming_buffer, " ");
-            char my_id[6];
-            char sender_id[6];
-            snprintf(my_id, 6, "N-%d", id);
+            struct Packet packet;
+            peer_packet(sim, return_value, &packet, 0);
             
-            // Extract dest and src node IDs from packet
-            if (strcmp(token, my_id) == 0) {
-                token = strtok(NULL, " ");
-                strncpy(sender_id, token, 6);
-
-                // Check if third token is "LFG-R"
-                token = strtok(NULL, " ");
-                if (strcmp(token, "LFG-R") == 0) {
-                    if (settings.debug) {
+            // Check packet is for this node
+            if (packet.dest == id) {
+                if (packet.type == PACKET_TYPE_LFG_R) {
+                    if (sim->settings.debug) {
                         printf("Node %d heard 'LFG-R' from node %d\n", id, return_value);
                     }
                     // Found LFG-R packet, add node to group
@@ -873,7 +910,7 @@ int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
                         if (nodes[id].group_list[i] == return_value) {
                             // already in group, re-send ACK
                             nodes[id].dest_node = return_value;
-                            mcu_call(nodes, id, own_function_number, 0, 12);
+                            mcu_call(sim, id, own_function_number, 0, 12);
                             return 0; 
                         }
                         if (nodes[id].group_list[i] == -1) {
@@ -881,30 +918,31 @@ int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
                         }
                         i++;
                     }
-                    while (i < settings.group_max - 1 && available_slot == -1);
+                    while (i < sim->settings.group_max - 1 && available_slot == -1);
     
                     if (available_slot == -1) {
                         // group is full (TO-DO, respond to this)
                         // for now, return to main
                         nodes[id].tmp_start_time = FLT_MAX;
-                        mcu_return(nodes, id, own_function_number, 0);
+                        mcu_return(sim, id, own_function_number, 0);
                         return 0;
                     }
                     else {
                         // add node to group list
-                        if (settings.debug) {
+                        if (sim->settings.debug) {
                             printf("node %d added node %d to group\n", id, return_value);
                         }
                         nodes[id].group_list[available_slot] = return_value;
+                        __atomic_fetch_add(&sim->state.group_joins, 1, __ATOMIC_RELAXED);
                         // send ACK
                         nodes[id].dest_node = return_value;
-                        mcu_call(nodes, id, own_function_number, 0, 12);
+                        mcu_call(sim, id, own_function_number, 0, 12);
                         return 0;                    
                     }
                 }
                 else {
                     // Not LFG-R packet, keep listening
-                    mcu_call(nodes, id, own_function_number, 0, 4);
+                    mcu_call(sim, id, own_function_number, 0, 4);
                     return 0;
                 }
             }
@@ -913,42 +951,42 @@ int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
     else if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // check time
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
             // time expired stop listening for replies, return to main
-            if (settings.debug) {
+            if (sim->settings.debug) {
                 printf("Node %d stopped listening for LFG-R\n", id);
             }
-            mcu_return(nodes, id, own_function_number, 0);
+            mcu_return(sim, id, own_function_number, 0);
             return 0;  
         }
         // time not expired, continue
         if (return_value == 1) {
             // Activity on channel, get packet
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            mcu_call(sim, id, own_function_number, 1, 7);
             return 0;
         }
         else {
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call_listening(sim, id, own_function_number, 0, 4, nodes[id].active_channel, 
+                               cycle_timer_expiry(nodes[id].timers, own_function_number, 0));
             return 0;            
         }
     }
     else {
         // Not returning from a call (first entry)
         // set start_time and check for activity on active channel
-        if (settings.debug) {
+        if (sim->settings.debug) {
             printf("Node %d listening for LFG-R packets on channel %d\n", id, nodes[id].active_channel);
         }
 
         // Create cycle timer
-        if (settings.debug) {
-            printf("Node %d created cycle timer for function %d\n", id, own_function_number);
+        if (sim->settings.debug) {
+            printf("Node %d created cycle timer for function %s\n", id, mcu_function_table[own_function_number].name);
         }
-        nodes[id].timers = 
-            cycle_timer_create(nodes[id].timers, own_function_number, 0, state.current_cycle, 1000);  
+        cycle_timer_arm(nodes[id].timers, own_function_number, 0, sim->state.current_cycle, 1000);  
 
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;    
 }
@@ -962,10 +1000,10 @@ int mcu_function_scan_lfg_responses(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_random_wait(struct Node* nodes, int id) {    
+int mcu_function_random_wait(struct Simulation* sim, int id) {    
     int own_function_number = 11;
     // for now this does nothing, busy_time is set in mcu_run_function()
-    mcu_return(nodes, id, own_function_number, 0);
+    mcu_return(sim, id, own_function_number, 0);
 
     return 0;    
 }
@@ -989,50 +1027,61 @@ int mcu_function_random_wait(struct Node* nodes, int id) {
 
  * Function Returns:            0 (update later)
 **/
-int mcu_function_lfgr_send_ack(struct Node* nodes, int id) {    
+int mcu_function_lfgr_send_ack(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 12;
 
     if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value == 1) {
             // channel was busy, try again
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
         else if (return_value == 0) {
-            snprintf(nodes[id].send_packet, sizeof(nodes[id].send_packet), 
-                     "N-%d N-%d ACK LFG-R", nodes[id].dest_node, id);
-            mcu_call(nodes, id, own_function_number, 1, 5);
+            struct Packet packet = {.dest = nodes[id].dest_node, .type = PACKET_TYPE_ACK_LFG_R};
+            node_send_packet(sim, id, &packet, PACKET_NONE);
+            mcu_call(sim, id, own_function_number, 1, 5);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 5) {
         // Returning from transmit_message_begin
         // No error checking for now
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 2, 6);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 2, 6);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 6) {
         // Returning from transmit_message_complete
         // No error checking for now, just return channel number
-        if (settings.debug) {
+        if (sim->settings.debug) {
+            char text[PACKET_TEXT_SIZE];
             printf("Node %d sent \"%s\" on channel %d\n", id, 
-                   nodes[id].send_packet, nodes[id].active_channel);
+                   send_packet_text(sim, id, text, sizeof(text)), nodes[id].active_channel);
         }
-        rs_pop(&nodes[id].return_stack);
-        mcu_return(nodes, id, own_function_number, nodes[id].active_channel);
+        rs_pop(&nodes[id]);
+        mcu_return(sim, id, own_function_number, nodes[id].active_channel);
         return 0;
     }
     else {
         // Not returning from a call (first entry)
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;   
 }
 
+// Cycle the ACK listening time runs out, it's kept in seconds
+static unsigned long ack_wait_end(struct Simulation* sim, int id) {
+    double remaining = sim->nodes[id].tmp_start_time + 0.05 - sim->state.current_time;
+    if (remaining <= 0) {
+        return 0;
+    }
+    return sim->state.current_cycle + (unsigned long)(remaining / sim->settings.time_resolution) + 1;
+}
+
 /**
  * Function Number:             13
  * Function Name:               lfgr_get_ack
@@ -1043,90 +1092,73 @@ int mcu_function_lfgr_send_ack(struct Node* nodes, int id) {
  * Function Returns:            1 - ACK received
  *                              0 - Nothing heard
 **/
-int mcu_function_lfgr_get_ack(struct Node* nodes, int id) {    
+int mcu_function_lfgr_get_ack(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 13;
 
     if (nodes[id].return_stack->returning_from == 7) {
         // Returning from receive function
         // Return value is sending node ID
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value == -1) {
             // collision detected try again 
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            mcu_call(sim, id, own_function_number, 1, 4);
             return 0;
         }
         if (return_value == -2) {
-            // Nothing heard try again
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            // Nothing heard try again, once something transmits
+            mcu_call_listening(sim, id, own_function_number, 1, 4, nodes[id].active_channel, 
+                               ack_wait_end(sim, id));
             return 0;
         }
         else {
-            // Check for LFG-R
-            char* token;
-            char incoming_buffer[256];
-
-            strncpy(incoming_buffer, nodes[return_value].send_packet, 256);
-
-            token = strtok(incoming_buffer, " ");
-            char my_id[6];
-            char sender_id[6];
-            snprintf(my_id, 6, "N-%d", id);
+            // Check for LFG-R ACK
+            struct Packet packet;
+            peer_packet(sim, return_value, &packet, 0);
             
-            // Extract dest and src node IDs from packet
-            if (strcmp(token, my_id) == 0) {
-                // First token is own id, message is for this node
-                token = strtok(NULL, " ");
-                // Second token is sender id
-                strncpy(sender_id, token, 6);
-
-                // Check if third token is "ACK"
-                token = strtok(NULL, " ");
-                if (strcmp(token, "ACK") == 0) {
-                    // Check if fourth token is "LFG-R"
-                    token = strtok(NULL, " ");
-                    if (strcmp(token, "LFG-R") == 0) {    
-                        if (settings.debug) {
-                            printf("Node %d received ACK\n", id);
-                        }
-                        mcu_return(nodes, id, own_function_number, 1);
-                        return 0;
-                    }
+            // Check packet is for this node
+            if (packet.dest == id && packet.type == PACKET_TYPE_ACK_LFG_R) {
+                if (sim->settings.debug) {
+                    printf("Node %d received ACK\n", id);
                 }
+                mcu_return(sim, id, own_function_number, 1);
+                return 0;
             }
             // Not LFG-R ACK packet, keep listening
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         // check time
-        if (nodes[id].tmp_start_time + 0.05 < state.current_time) {
+        if (nodes[id].tmp_start_time + 0.05 < sim->state.current_time) {
             // time expired stop listening for replies, return to main
             nodes[id].tmp_start_time = FLT_MAX;
-            mcu_return(nodes, id, own_function_number, 0);
+            mcu_return(sim, id, own_function_number, 0);
             return 0;  
         }
         // Time not expired, continue
         if (return_value == 1) {
             // Activity on channel, get packet
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            mcu_call(sim, id, own_function_number, 1, 7);
             return 0;
         }
         else {
             // Nothing heard, try again
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call_listening(sim, id, own_function_number, 0, 4, nodes[id].active_channel, 
+                               ack_wait_end(sim, id));
             return 0;            
         }
     }
     else {
         // Not returning from a call (first entry)
         // set start_time and check for activity on active channel
-        nodes[id].tmp_start_time = state.current_time;
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        nodes[id].tmp_start_time = sim->state.current_time;
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;    
 }
@@ -1140,28 +1172,29 @@ int mcu_function_lfgr_get_ack(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_group_cycle_start(struct Node* nodes, int id) {    
+int mcu_function_group_cycle_start(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 14;
 
     // Reset timer
-    nodes[id].group_cycle_start = state.current_cycle;
+    nodes[id].group_cycle_start = sim->state.current_cycle;
 
     // If broadcaster, clear group list
     if (nodes[id].broadcaster == 1) {
-        for (int i = 0; i < settings.group_max; i++) {
+        for (int i = 0; i < sim->settings.group_max; i++) {
             nodes[id].group_list[i] = -1;
         }
     }
 
     // Use broadcast_percentage to decide next role
-    if (rand() % 100 < settings.broadcast_percentage) {
+    if (node_rand(sim, id, RNG_PURPOSE_ROLE) % 100 < sim->settings.broadcast_percentage) {
         nodes[id].broadcaster = 1;
     }
     else {
         nodes[id].broadcaster = 0;
     }
     
-    mcu_return(nodes, id, own_function_number, 0);
+    mcu_return(sim, id, own_function_number, 0);
     return 0;    
 }
 
@@ -1174,69 +1207,64 @@ int mcu_function_group_cycle_start(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_sensor_data_send(struct Node* nodes, int id) {    
+int mcu_function_sensor_data_send(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 15;
 
     if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
     
         if (return_value == 1) {
             // channel was busy, try again
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
         else if (return_value == 0) {
             // Send packet
-            mcu_call(nodes, id, own_function_number, 1, 5);
+            mcu_call(sim, id, own_function_number, 1, 5);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 5) {
         // Returning from transmit_message_begin
         // No error checking for now
-        if (settings.debug) {
+        if (sim->settings.debug) {
+            char text[PACKET_TEXT_SIZE];
             printf("Node %d sent \"%s\" on channel %d at tick %lu\n", id, 
-                   nodes[id].send_packet, nodes[id].active_channel, state.current_cycle);
+                   send_packet_text(sim, id, text, sizeof(text)), nodes[id].active_channel, 
+                   sim->state.current_cycle);
         }
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 2, 6);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 2, 6);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 6) {
         // Returning from transmit_message_complete
-        state.sent_messages++;
-        rs_pop(&nodes[id].return_stack);
-        mcu_return(nodes, id, own_function_number, 0);
+        __atomic_fetch_add(&sim->state.sent_messages, 1, __ATOMIC_RELAXED);
+        rs_pop(&nodes[id]);
+        mcu_return(sim, id, own_function_number, 0);
         return 0;
     }
     else {
         // Update sensor data
-        for (int i = 0; i < settings.sensor_count; i++) {
-            update_sensor(nodes, id, i);
+        for (int i = 0; i < sim->settings.sensor_count; i++) {
+            update_sensor(sim, id, i);
         }
     
         // Generate message to send
-        char sensor_id[2];
-        char message_time[10];
-
-        snprintf(nodes[id].send_packet, sizeof(nodes[id].send_packet), "N-%d N-%d DATA ", 
-                nodes[id].dest_node, id);
-        for (int i = 0; i < settings.sensor_count; i++) {
-            snprintf(sensor_id, 2, "%d", i);
-            strncat(nodes[id].send_packet, "S", 2);
-            strncat(nodes[id].send_packet, sensor_id, 3);
-            strncat(nodes[id].send_packet, ": ", 3);
-            strncat(nodes[id].send_packet, nodes[id].sensors[i].reading, READING_BUFFER_SIZE);
-            strncat(nodes[id].send_packet, " ", 2);
-        }
-        snprintf(message_time, 10, "%f", state.current_time);
-        strncat(nodes[id].send_packet, "TIME ", 6);
-        strncat(nodes[id].send_packet, message_time, 11);
+        struct Packet packet = {.dest = nodes[id].dest_node, .type = PACKET_TYPE_DATA};
+        packet.payload.origin = id;
+        packet.payload.time = sim->state.current_time;
+        packet.payload.reading_count = 0;
+        for (int i = 0; i < sim->settings.sensor_count && i < PACKET_MAX_SENSORS; i++) {
+            packet.payload.readings[packet.payload.reading_count++] = nodes[id].sensors[i];
+        }
+        node_send_packet(sim, id, &packet, PACKET_NONE);
         
         // Check for activity on channel    
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
 
     return 0;    
@@ -1251,98 +1279,84 @@ int mcu_function_sensor_data_send(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_sensor_data_recv(struct Node* nodes, int id) {    
+int mcu_function_sensor_data_recv(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 16;
     
     if (nodes[id].return_stack->returning_from == 7) {
         // Returning from receive function
         // Return value is sending node ID
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
         if (return_value == -1) {
             // collision detected try again 
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            mcu_call(sim, id, own_function_number, 1, 4);
             return 0;
         }
         if (return_value == -2) {
-            // Nothing heard try again
-            mcu_call(nodes, id, own_function_number, 1, 4);
+            // Nothing heard try again, once something transmits
+            mcu_call_listening(sim, id, own_function_number, 1, 4, nodes[id].active_channel, 
+                               cycle_timer_expiry(nodes[id].timers, own_function_number, 0));
             return 0;
         }
         else {
             // Check for DATA message
-            char* token;
-            char incoming_buffer[256];
-            char message[256];
-
-            // Zero out message string to eliminate proceeded garbage data
-            bzero(message, 256);
-
-            strncpy(incoming_buffer, nodes[return_value].send_packet, 256);
-
-            token = strtok(incoming_buffer, " ");
-            char my_id[6];
-            char sender_id[6];
-            snprintf(my_id, 6, "N-%d", id);
+            struct Packet packet;
+            peer_packet(sim, return_value, &packet, 0);
             
-            // Extract dest and src node IDs from message
-            if (strcmp(token, my_id) == 0) {
-                token = strtok(NULL, " ");
-                strncpy(sender_id, token, 6);
-
-                // Check if third token is "DATA"
-                token = strtok(NULL, " ");
-                if (strcmp(token, "DATA") == 0) {
-                    if (settings.debug) {
-                        printf("Node %d heard DATA message from node %d at %lu\n", id, return_value, state.current_cycle);
+            if (packet.dest == id && packet.type == PACKET_TYPE_DATA) {
+                if (sim->settings.debug) {
+                    printf("Node %d heard DATA message from node %d at %lu\n", id, return_value, sim->state.current_cycle);
+                }
+                // Add message to relay queue, holding the sender's packet
+                // rather than a copy of it
+                int handle = peer_send_packet(sim, return_value);
+                struct stored_message dropped;
+                packet_ref(&sim->packets, handle);
+                if (relay_queue_push(&nodes[id].relay_queue, sim->settings.relay_overflow, 
+                                     return_value, handle, &dropped)) {
+                    if (sim->settings.debug) {
+                        printf("Node %d relay queue full, dropped message from %d\n", id, dropped.sender);
                     }
-                    // Process remaining tokens
-                    token = strtok(NULL, " ");
-                    do {
-                        strncat(message, token, strlen(token));
-                        strncat(message, " ", 2);
-                        token = strtok(NULL, " ");
-                    } while (token != 0);
-
-                    // Add message to relay queue
-                    nodes[id].stored_messages = stored_message_create(nodes[id].stored_messages, return_value, message);
+                    packet_unref(&sim->packets, dropped.packet);
+                    __atomic_fetch_add(&sim->state.relay_drops, 1, __ATOMIC_RELAXED);
                 }
             }
         }
         // Keep listening
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        mcu_call(sim, id, own_function_number, 0, 4);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
     
         // Check cycle timer
-        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0)) {
-            mcu_return(nodes, id, own_function_number, 0);
+        if (cycle_timer_check_expired(nodes[id].timers, own_function_number, 0, sim->state.current_cycle)) {
+            mcu_return(sim, id, own_function_number, 0);
             return 0;
         }
         // time not expired, continue
         if (return_value == 1) {
             // Activity on channel, get packet
-            mcu_call(nodes, id, own_function_number, 1, 7);
+            mcu_call(sim, id, own_function_number, 1, 7);
             return 0;
         }
         else {
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call_listening(sim, id, own_function_number, 0, 4, nodes[id].active_channel, 
+                               cycle_timer_expiry(nodes[id].timers, own_function_number, 0));
             return 0;            
         }
     }
     else {
         // Not returning from a call (first entry)
         // set start_time and check for activity on active channel
-        if (settings.debug) {
+        if (sim->settings.debug) {
             printf("Node %d listening for DATA packets on channel %d\n", id, nodes[id].active_channel);
         }
-        nodes[id].timers = 
-            cycle_timer_create(nodes[id].timers, own_function_number, 0, state.current_cycle, 1000);
-        mcu_call(nodes, id, own_function_number, 0, 4);
+        cycle_timer_arm(nodes[id].timers, own_function_number, 0, sim->state.current_cycle, 1000);
+        mcu_call(sim, id, own_function_number, 0, 4);
     }
     return 0;    
 }
@@ -1356,55 +1370,61 @@ int mcu_function_sensor_data_recv(struct Node* nodes, int id) {
 
  * Function Returns:            0 - void
 **/
-int mcu_function_sensor_data_relay(struct Node* nodes, int id) {    
+int mcu_function_sensor_data_relay(struct Simulation* sim, int id) {    
+    struct Node* nodes = sim->nodes;
     int own_function_number = 17;
+    struct stored_message* message;
     if (nodes[id].return_stack->returning_from == 4) {
         // Returning from check_channel_busy function
         int return_value = nodes[id].return_stack->return_value;
-        rs_pop(&nodes[id].return_stack);
+        rs_pop(&nodes[id]);
     
         if (return_value == 1) {
             // channel was busy, try again
-            mcu_call(nodes, id, own_function_number, 0, 4);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
         else if (return_value == 0) {
             // Send packet
-            mcu_call(nodes, id, own_function_number, 1, 5);
+            mcu_call(sim, id, own_function_number, 1, 5);
             return 0;
         }
     }
     else if (nodes[id].return_stack->returning_from == 5) {
         // Returning from transmit_message_begin
         // No error checking for now
-        rs_pop(&nodes[id].return_stack);
-        mcu_call(nodes, id, own_function_number, 2, 6);
+        rs_pop(&nodes[id]);
+        mcu_call(sim, id, own_function_number, 2, 6);
         return 0;
     }
     else if (nodes[id].return_stack->returning_from == 6) {
         // Returning from transmit_message_complete
-        rs_pop(&nodes[id].return_stack);
-        if (settings.debug) {
-            printf("Node %d relayed message from %d\n", id, nodes[id].stored_messages->sender);
+        rs_pop(&nodes[id]);
+        struct stored_message relayed;
+        relay_queue_pop(&nodes[id].relay_queue, &relayed);
+        if (sim->settings.debug) {
+            printf("Node %d relayed message from %d\n", id, relayed.sender);
         }
-        nodes[id].stored_messages = stored_message_remove(nodes[id].stored_messages, nodes[id].stored_messages);
+        packet_unref(&sim->packets, relayed.packet);
         // Check for more messages to relay
-        if (nodes[id].stored_messages->sender != -1) {
-            snprintf(nodes[id].send_packet, sizeof(nodes[id].send_packet), "GROUND N-%d RELAY N-%d %s", 
-                     id, nodes[id].stored_messages->sender, nodes[id].stored_messages->message);
-            mcu_call(nodes, id, own_function_number, 0, 4);
+        message = relay_queue_front(&nodes[id].relay_queue);
+        if (message != NULL) {
+            struct Packet packet = {.dest = PACKET_ADDR_GROUND, .type = PACKET_TYPE_RELAY};
+            node_send_packet(sim, id, &packet, message->packet);
+            mcu_call(sim, id, own_function_number, 0, 4);
             return 0;
         }
     }
-    // For now just empty out the queue
-    if (nodes[id].stored_messages->sender != -1) {
-        snprintf(nodes[id].send_packet, sizeof(nodes[id].send_packet), "GROUND N-%d RELAY N-%d %s", 
-                 id, nodes[id].stored_messages->sender, nodes[id].stored_messages->message);
-        mcu_call(nodes, id, own_function_number, 0, 4);
+    // For now just empty out the queue, oldest message first
+    message = relay_queue_front(&nodes[id].relay_queue);
+    if (message != NULL) {
+        struct Packet packet = {.dest = PACKET_ADDR_GROUND, .type = PACKET_TYPE_RELAY};
+        node_send_packet(sim, id, &packet, message->packet);
+        mcu_call(sim, id, own_function_number, 0, 4);
         return 0;
     }
     else {
-        mcu_return(nodes, id, own_function_number, 0);
+        mcu_return(sim, id, own_function_number, 0);
     }
     return 0;
 }
\ No newline at end of file
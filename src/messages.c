@@ -7,36 +7,71 @@
 **/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "messages.h"
-#include "settings.h"
-#include "state.h"
-
-extern struct State state;
-
-struct stored_message* stored_message_create(struct stored_message* head, 
-                                             int sender, 
-                                             char* message) {
-    // Allocate memory for new message node
-    struct stored_message* new_message = malloc(sizeof(struct stored_message));
-    if (new_message == NULL) {
-        printf("message memory allocation error\n");
-        exit(0);
+
+void relay_queue_init(struct Relay_Queue* queue, struct stored_message* slots, int capacity) {
+    queue->slots = slots;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->dropped = 0;
+}
+
+/**
+ * Relay queue push
+ * Desc: Adds a message at the back of the queue. When the queue is full the
+ *       overflow policy picks the message that doesn't make it: the oldest
+ *       one queued, the newest one queued (replaced by this one), or this
+ *       one. A queue with no capacity rejects everything.
+ *
+ * Returns: 1 with the dropped message copied to dropped, 0 if none was
+**/
+int relay_queue_push(struct Relay_Queue* queue, int policy, int sender, int packet,
+                     struct stored_message* dropped) {
+    struct stored_message message = {sender, packet};
+
+    if (queue->count < queue->capacity) {
+        queue->slots[(queue->head + queue->count) % queue->capacity] = message;
+        queue->count++;
+        return 0;
     }
 
-    // Assign parameters to new message node
-    new_message->sender = sender;
-    new_message->next = head;
-    strncpy(new_message->message, message, STORED_MESSAGE_SIZE);
+    queue->dropped++;
+    if (queue->capacity == 0 || policy == RELAY_OVERFLOW_REJECT) {
+        *dropped = message;
+    }
+    else if (policy == RELAY_OVERFLOW_DROP_NEWEST) {
+        int tail = (queue->head + queue->count - 1) % queue->capacity;
+        *dropped = queue->slots[tail];
+        queue->slots[tail] = message;
+    }
+    else {
+        *dropped = queue->slots[queue->head];
+        queue->slots[queue->head] = message;
+        queue->head = (queue->head + 1) % queue->capacity;
+    }
+    return 1;
+}
 
-    return new_message;
+// Oldest message, NULL if the queue is empty
+struct stored_message* relay_queue_front(struct Relay_Queue* queue) {
+    return queue->count > 0 ? &queue->slots[queue->head] : NULL;
 }
 
-struct stored_message* stored_message_remove(struct stored_message* head, struct stored_message* nd) {
-    struct stored_message* front = head;
-    head = head->next;
-    front->next = NULL;
-    free(front);
+// Message index places behind the front
+struct stored_message* relay_queue_at(struct Relay_Queue* queue, int index) {
+    return &queue->slots[(queue->head + index) % queue->capacity];
+}
 
-    return head;
-}
\ No newline at end of file
+// Takes the oldest message off the queue, returns 1 if the queue was empty
+int relay_queue_pop(struct Relay_Queue* queue, struct stored_message* message) {
+    if (queue->count == 0) {
+        return 1;
+    }
+    *message = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    return 0;
+}
@@ -6,18 +6,36 @@
  * @date    2/28/2021
 **/
 
+#include "packet_slab.h"
+
 #ifndef messages_H
 #define messages_H
 
-#define STORED_MESSAGE_SIZE         256
+// What a full relay queue does with one more message
+#define RELAY_OVERFLOW_DROP_OLDEST  0
+#define RELAY_OVERFLOW_DROP_NEWEST  1
+#define RELAY_OVERFLOW_REJECT       2
 
 struct stored_message {
     int sender;
-    char message[STORED_MESSAGE_SIZE];
-    struct stored_message* next;
+    int packet;                     // DATA packet, reference owned by the queue
+};
+
+// Fixed capacity FIFO of messages waiting to be relayed, slots belong to
+// the caller
+struct Relay_Queue {
+    struct stored_message* slots;
+    int capacity;
+    int head;
+    int count;
+    unsigned long dropped;
 };
 
-struct stored_message* stored_message_create(struct stored_message* head, int sender, char* message);
-struct stored_message* stored_message_remove(struct stored_message* head, struct stored_message* nd);   
+void relay_queue_init(struct Relay_Queue* queue, struct stored_message* slots, int capacity);
+int relay_queue_push(struct Relay_Queue* queue, int policy, int sender, int packet,
+                     struct stored_message* dropped);
+struct stored_message* relay_queue_front(struct Relay_Queue* queue);
+struct stored_message* relay_queue_at(struct Relay_Queue* queue, int index);
+int relay_queue_pop(struct Relay_Queue* queue, struct stored_message* message);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,198 @@
+/**
+ * @file    neighbors.c
+ * @brief   Verlet neighbor lists of the peers each node could hear
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <string.h>
+#include "neighbors.h"
+#include "simulation.h"
+
+#define NEIGHBOR_INITIAL_CAPACITY 1024
+
+// Node whose list is being built
+struct Neighbor_Build {
+    struct Neighbor_Lists* lists;
+    int id;
+    double x;
+    double y;
+    double z;
+};
+
+static void neighbor_add(struct Simulation* sim, int peer, void* context) {
+    struct Neighbor_Build* build = context;
+    struct Neighbor_Lists* lists = build->lists;
+    if (peer == build->id) {
+        return;
+    }
+    double dx = NODE_KIN(sim, peer, x_pos) - build->x;
+    double dy = NODE_KIN(sim, peer, y_pos) - build->y;
+    double dz = NODE_KIN(sim, peer, z_pos) - build->z;
+    if (dx * dx + dy * dy + dz * dz > lists->cutoff_squared) {
+        return;
+    }
+    int count = lists->start[build->id + 1];
+    if (count == lists->capacity) {
+        lists->capacity *= 2;
+        lists->peers = realloc(lists->peers, sizeof(int) * lists->capacity);
+        if (lists->peers == NULL) {
+            printf("Neighbor list memory allocation error\n");
+            exit(0);
+        }
+    }
+    lists->peers[count] = peer;
+    lists->start[build->id + 1]++;
+}
+
+// Every list from current positions, through the spatial grid unless the
+// cutoff covers too many of its cells
+static void build_neighbor_lists(struct Simulation* sim) {
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    double cutoff = sim->grid.range + lists->skin;
+    int n = sim->settings.node_count;
+
+    lists->start[0] = 0;
+    for (int i = 0; i < n; i++) {
+        struct Neighbor_Build build = {lists, i, NODE_KIN(sim, i, x_pos), NODE_KIN(sim, i, y_pos),
+                                       NODE_KIN(sim, i, z_pos)};
+        lists->start[i + 1] = lists->start[i];
+        if (spatial_grid_visit(sim, build.x, build.y, build.z, cutoff, neighbor_add, &build) != 0) {
+            for (int j = 0; j < n; j++) {
+                neighbor_add(sim, j, &build);
+            }
+        }
+        lists->anchor[3 * i] = build.x;
+        lists->anchor[3 * i + 1] = build.y;
+        lists->anchor[3 * i + 2] = build.z;
+    }
+    lists->builds++;
+}
+
+// Nodes within range plus skin of the ground station
+static void build_ground_neighbors(struct Simulation* sim) {
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    struct Ground_Station* ground = &sim->ground;
+
+    lists->ground_count = 0;
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        double x = NODE_KIN(sim, i, x_pos);
+        double y = NODE_KIN(sim, i, y_pos);
+        double z = NODE_KIN(sim, i, z_pos);
+        double dx = x - ground->x_pos;
+        double dy = y - ground->y_pos;
+        double dz = z - ground->z_pos;
+        if (dx * dx + dy * dy + dz * dz <= lists->cutoff_squared) {
+            lists->ground_peers[lists->ground_count++] = i;
+        }
+        lists->ground_anchor[3 * i] = x;
+        lists->ground_anchor[3 * i + 1] = y;
+        lists->ground_anchor[3 * i + 2] = z;
+    }
+}
+
+/**
+ * Initialize neighbor lists
+ * Desc: Builds the lists when neighbor_skin is above 0 and there's a
+ *       spatial grid (a receiver_sensitivity cutoff) to build them from
+**/
+int initialize_neighbor_lists(struct Simulation* sim) {
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    int n = sim->settings.node_count;
+    memset(lists, 0, sizeof(*lists));
+    if (!sim->grid.enabled || !(sim->settings.neighbor_skin > 0)) {
+        return 0;
+    }
+
+    lists->skin = sim->settings.neighbor_skin;
+    lists->cutoff_squared = (sim->grid.range + lists->skin) * (sim->grid.range + lists->skin);
+    lists->capacity = NEIGHBOR_INITIAL_CAPACITY;
+    lists->start = malloc(sizeof(int) * (n + 1));
+    lists->peers = malloc(sizeof(int) * lists->capacity);
+    lists->anchor = malloc(sizeof(double) * 3 * n);
+    lists->ground_peers = malloc(sizeof(int) * (n > 0 ? n : 1));
+    lists->ground_anchor = malloc(sizeof(double) * 3 * n);
+    if (lists->start == NULL || lists->peers == NULL || lists->anchor == NULL ||
+        lists->ground_peers == NULL || lists->ground_anchor == NULL) {
+        printf("Neighbor list memory allocation error\n");
+        exit(0);
+    }
+    build_neighbor_lists(sim);
+    build_ground_neighbors(sim);
+    lists->ground_checked = sim->state.current_cycle;
+    lists->enabled = 1;
+    return 0;
+}
+
+/**
+ * Update neighbor lists
+ * Desc: Rebuilds the lists once some node has moved more than half the skin
+ *       since the last build, not counting how far the drop as a whole (the
+ *       mean of every node's displacement) has moved. Two nodes can only
+ *       have closed the skin between them after one of them has. Needs the
+ *       spatial grid updated first.
+ *
+ *       The same pass checks the ground station's list, which is rebuilt
+ *       once some node has moved the skin itself since the list was built,
+ *       the ground never moves. The ground only uses the list on ticks it
+ *       was checked.
+**/
+int update_neighbor_lists(struct Simulation* sim) {
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    int n = sim->settings.node_count;
+    if (!lists->enabled) {
+        return 0;
+    }
+
+    double mean[3] = {0, 0, 0};
+    for (int i = 0; i < n; i++) {
+        mean[0] += NODE_KIN(sim, i, x_pos) - lists->anchor[3 * i];
+        mean[1] += NODE_KIN(sim, i, y_pos) - lists->anchor[3 * i + 1];
+        mean[2] += NODE_KIN(sim, i, z_pos) - lists->anchor[3 * i + 2];
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        mean[axis] /= n;
+    }
+
+    double limit = lists->skin * lists->skin / 4;
+    double ground_limit = lists->skin * lists->skin;
+    int rebuild = 0;
+    int ground_rebuild = 0;
+    for (int i = 0; i < n && !(rebuild && ground_rebuild); i++) {
+        double x = NODE_KIN(sim, i, x_pos);
+        double y = NODE_KIN(sim, i, y_pos);
+        double z = NODE_KIN(sim, i, z_pos);
+        double dx = x - lists->anchor[3 * i] - mean[0];
+        double dy = y - lists->anchor[3 * i + 1] - mean[1];
+        double dz = z - lists->anchor[3 * i + 2] - mean[2];
+        if (dx * dx + dy * dy + dz * dz > limit) {
+            rebuild = 1;
+        }
+        dx = x - lists->ground_anchor[3 * i];
+        dy = y - lists->ground_anchor[3 * i + 1];
+        dz = z - lists->ground_anchor[3 * i + 2];
+        if (dx * dx + dy * dy + dz * dz > ground_limit) {
+            ground_rebuild = 1;
+        }
+    }
+    if (rebuild) {
+        build_neighbor_lists(sim);
+    }
+    if (ground_rebuild) {
+        build_ground_neighbors(sim);
+    }
+    lists->ground_checked = sim->state.current_cycle;
+    return 0;
+}
+
+int free_neighbor_lists(struct Simulation* sim) {
+    struct Neighbor_Lists* lists = &sim->neighbors;
+    free(lists->start);
+    free(lists->peers);
+    free(lists->anchor);
+    free(lists->ground_peers);
+    free(lists->ground_anchor);
+    memset(lists, 0, sizeof(*lists));
+    return 0;
+}
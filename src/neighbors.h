@@ -0,0 +1,46 @@
+/**
+ * @file    neighbors.h
+ * @brief   Verlet neighbor lists of the peers each node could hear
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifndef neighbors_H
+#define neighbors_H
+
+struct Simulation;
+
+/**
+ * Every node's peers within radio range plus skin when the lists were built,
+ * kept in one array with node i's peers from start[i] up to start[i + 1].
+ * The lists stay complete until two nodes could have closed the skin on
+ * each other, which is checked against displacement relative to the whole
+ * drop. Nodes all falling at about terminal velocity barely move relative
+ * to each other, so the lists last far longer than positions do.
+ *
+ * The ground station gets a list of its own. It doesn't fall with the
+ * nodes, so that one lasts until some node has moved the skin. It's only
+ * known to be complete on ticks the lists were checked, the event engine
+ * skips the check on ticks it skips.
+**/
+struct Neighbor_Lists {
+    int enabled;
+    double skin;
+    double cutoff_squared;          // (range + skin)^2
+    int* start;
+    int* peers;
+    long capacity;
+    double* anchor;                 // x, y, z of each node at the last build
+    unsigned long builds;
+    int* ground_peers;
+    int ground_count;
+    double* ground_anchor;          // x, y, z of each node at the last ground build
+    unsigned long ground_checked;   // cycle the ground list was last checked
+};
+
+int initialize_neighbor_lists(struct Simulation* sim);
+int update_neighbor_lists(struct Simulation* sim);
+int free_neighbor_lists(struct Simulation* sim);
+
+#endif
@@ -7,256 +7,558 @@
 **/
 
 #include "node.h"
+#include "channels.h"
+#include "file_output.h"
 #include "mcu_emulation.h"
+#include "rng.h"
 #include "settings.h"
+#include "simulation.h"
 #include "state.h"
 #include "timers.h"
 #include <string.h>
 
-extern struct Settings settings;
-extern struct State state;
-
-int initialize_nodes(struct Node* nodes) {
-    char file_path[100];
-
-    if (settings.debug) {
-        printf("Setting inital node coordinates to %f %f %f\n", settings.start_x,
-                settings.start_y, settings.start_z);
-    }
-
-    for (int i = 0; i < settings.node_count; i++) {
-        nodes[i].terminal_velocity = 
-            settings.terminal_velocity + 
-           (settings.terminal_velocity * DRAGVARIANCE * (rand() % 201 - 100.0) / 100);
-        nodes[i].x_pos = settings.start_x;
-        nodes[i].y_pos = settings.start_y;
-        nodes[i].z_pos = settings.start_z;
-        nodes[i].x_velocity = 0;
-        nodes[i].y_velocity = 0;
-        nodes[i].z_velocity = 0;
-        nodes[i].x_acceleration = 0;
-        nodes[i].y_acceleration = 0;
-        nodes[i].z_acceleration = settings.gravity;
-        nodes[i].power_output = settings.default_power_output;
+int initialize_nodes(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
+
+    if (sim->settings.debug) {
+        printf("Setting inital node coordinates to %f %f %f\n", sim->settings.start_x,
+                sim->settings.start_y, sim->settings.start_z);
+    }
+
+#ifdef KINEMATICS_SOA
+    initialize_kinematics(&sim->kinematics, sim->settings.node_count);
+#endif
+
+    // Call/return stacks for every node come out of one allocation
+    size_t stack_elements = (size_t)sim->settings.node_count * MCU_STACK_DEPTH;
+    sim->stacks.function_stacks = malloc(stack_elements * 
+        (sizeof(struct FS_Element) + sizeof(struct RS_Element)));
+    if (sim->stacks.function_stacks == NULL) {
+        printf("Node memory allocation error\n");
+        exit(0);
+    }
+    sim->stacks.return_stacks = (struct RS_Element*)(sim->stacks.function_stacks + stack_elements);
+
+    // Every node's cycle timer slots, all disarmed
+    sim->timer_table = calloc((size_t)sim->settings.node_count * CYCLE_TIMER_SLOTS, sizeof(struct cycle_timer));
+    if (sim->timer_table == NULL) {
+        printf("Node memory allocation error\n");
+        exit(0);
+    }
+
+    // Every node's relay queue slots, at least one so a zero size queue
+    // still gets a valid pointer
+    size_t relay_slots = (size_t)sim->settings.node_count * sim->settings.relay_queue_size;
+    sim->relay_table = malloc(sizeof(struct stored_message) * (relay_slots > 0 ? relay_slots : 1));
+    if (sim->relay_table == NULL) {
+        printf("Node memory allocation error\n");
+        exit(0);
+    }
+
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        NODE_KIN(sim, i, terminal_velocity) = 
+            sim->settings.terminal_velocity + 
+           (sim->settings.terminal_velocity * DRAGVARIANCE * ((int)(node_rand(sim, i, RNG_PURPOSE_DRAG) % 201) - 100.0) / 100);
+        NODE_KIN(sim, i, x_pos) = sim->settings.start_x;
+        NODE_KIN(sim, i, y_pos) = sim->settings.start_y;
+        NODE_KIN(sim, i, z_pos) = sim->settings.start_z;
+        NODE_KIN(sim, i, x_velocity) = 0;
+        NODE_KIN(sim, i, y_velocity) = 0;
+        NODE_KIN(sim, i, z_velocity) = 0;
+        NODE_KIN(sim, i, x_acceleration) = 0;
+        NODE_KIN(sim, i, y_acceleration) = 0;
+        NODE_KIN(sim, i, z_acceleration) = sim->settings.gravity;
+        nodes[i].power_output = sim->settings.default_power_output;
         nodes[i].transmit_active = 0;
         nodes[i].active_channel = 0;
         nodes[i].current_function = 0;
-        nodes[i].busy_remaining = -1;
-        nodes[i].received_signals = malloc(sizeof(double) * settings.node_count);
-        nodes[i].group_list = malloc(sizeof(int) * settings.group_max);
-        nodes[i].function_stack = malloc(sizeof(struct FS_Element));
-        nodes[i].return_stack = malloc(sizeof(struct RS_Element));
-        nodes[i].tmp_lfg_chans = malloc(sizeof(int) * settings.channels);
-        nodes[i].tmp_scanned_chans = malloc(sizeof(int) * settings.channels);
+        nodes[i].busy_pending = 1;
+        nodes[i].wake_cycle = 0;
+        nodes[i].wait_channel = CHANNEL_WAIT_NONE;
+        nodes[i].group_list = malloc(sizeof(int) * sim->settings.group_max);
+        nodes[i].function_stack_base = sim->stacks.function_stacks + (size_t)i * MCU_STACK_DEPTH;
+        nodes[i].return_stack_base = sim->stacks.return_stacks + (size_t)i * MCU_STACK_DEPTH;
+        nodes[i].function_stack = nodes[i].function_stack_base;
+        nodes[i].return_stack = nodes[i].return_stack_base;
+        nodes[i].tmp_lfg_chans = malloc(sizeof(int) * sim->settings.channels);
+        nodes[i].tmp_scanned_chans = malloc(sizeof(int) * sim->settings.channels);
         nodes[i].tmp_start_time = FLT_MAX;
         nodes[i].broadcaster = 0;
         nodes[i].group_cycle_start = 0;
-        nodes[i].timers = malloc(sizeof(struct cycle_timer));
-        nodes[i].sensors = malloc(sizeof(struct sensor) * settings.sensor_count);
-        nodes[i].stored_messages = malloc(sizeof(struct stored_message));
+        nodes[i].timers = sim->timer_table + (size_t)i * CYCLE_TIMER_SLOTS;
+        nodes[i].send_packet = PACKET_NONE;
+        nodes[i].packet_seq = 0;
+        nodes[i].sensors = malloc(sizeof(struct Sensor_Reading) * sim->settings.sensor_count);
+        relay_queue_init(&nodes[i].relay_queue, 
+                         sim->relay_table + (size_t)i * sim->settings.relay_queue_size, 
+                         sim->settings.relay_queue_size);
 
-
-        // Set all received signals to 0 initially
-        for (int j = 0; j < settings.node_count; j++) {
-            nodes[i].received_signals[j] = 0;
-        }
-        
         // Set up array for group members, use -1 for no node
-        for (int j = 0; j < settings.group_max; j++) {
+        for (int j = 0; j < sim->settings.group_max; j++) {
             nodes[i].group_list[j] = -1;
         }
 
         // Set sensor types
-        for (int j = 0; j < settings.sensor_count; j++) {
-            nodes[i].sensors[j].type = settings.sensor_types[j];
+        for (int j = 0; j < sim->settings.sensor_count; j++) {
+            nodes[i].sensors[j].type = sim->settings.sensor_types[j];
+            nodes[i].sensors[j].value_count = 0;
         }
 
-        // Initialize timer head node
-        nodes[i].timers->function = -1;
-        nodes[i].timers->label = -1;
-        nodes[i].timers->next = NULL;
+        // Stack bottoms
+        nodes[i].function_stack->caller = -1;
+        nodes[i].function_stack->return_to_label = -1;
+        nodes[i].return_stack->returning_from = -1;
+        nodes[i].return_stack->return_to_label = -1;
+        nodes[i].return_stack->return_value = 0;
+    }
+    return 0;
+}
 
-        // Initialize stored message head node
-        nodes[i].stored_messages->sender = -1;
-        nodes[i].stored_messages->next = NULL;
+// Release everything initialize_nodes() and the MCU functions allocated
+int free_nodes(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
 
-        if (settings.output) {
-            sprintf(file_path, "%s/node-%d%s", settings.output_dir, i, ".txt");
-            if (settings.debug) {
-                printf("Creating output file \"%s\"\n", file_path);
-            }
-            FILE *fp;
-            fp  = fopen (file_path, "w");
-            write_node_data(nodes, i, fp);
-            fclose(fp);
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        struct stored_message message;
+        while (relay_queue_pop(&nodes[i].relay_queue, &message) == 0) {
+            packet_unref(&sim->packets, message.packet);
         }
+        packet_unref(&sim->packets, nodes[i].send_packet);
+        free(nodes[i].group_list);
+        free(nodes[i].tmp_lfg_chans);
+        free(nodes[i].tmp_scanned_chans);
+        free(nodes[i].sensors);
     }
+    free(sim->stacks.function_stacks);
+    free(sim->timer_table);
+    free(sim->relay_table);
+#ifdef KINEMATICS_SOA
+    free_kinematics(&sim->kinematics);
+#endif
     return 0;
 }
 
-int update_acceleration(struct Node* nodes) {
-    for (int i = 0; i < settings.node_count; i++) {
-        // update x/y acceleration
-        // use spread_factor as percentage likelyhood that there is some change to acceleration
-        if (rand() % 100 < settings.spread_factor) {
-            // change x and y by random percentage of max allowed change per second
-            double x_accel_change = (rand() % 201 - 100) / 100.0 
-                                    * settings.time_resolution * XYACCELDELTAMAX;
-            double y_accel_change = (rand() % 201 - 100) / 100.0 
-                                    * settings.time_resolution * XYACCELDELTAMAX;
-            if (settings.debug >= 3) {
-                printf("Changing x/y accel for node %d by %f,%f\n", i, x_accel_change, y_accel_change);
+int update_acceleration(struct Simulation* sim) {
+    return update_acceleration_range(sim, 0, sim->settings.node_count);
+}
+
+#define ACCELERATION_BATCH 256
+
+int update_acceleration_range(struct Simulation* sim, int start, int end) {
+    struct RNG_Block draws[ACCELERATION_BATCH];
+
+    for (int batch = start; batch < end; batch += ACCELERATION_BATCH) {
+        int count = end - batch < ACCELERATION_BATCH ? end - batch : ACCELERATION_BATCH;
+        rng_block_batch(&sim->rng, draws, batch, count, sim->state.current_cycle, RNG_PURPOSE_ACCELERATION);
+
+        for (int j = 0; j < count; j++) {
+            int i = batch + j;
+            // update x/y acceleration
+            // use spread_factor as percentage likelyhood that there is some change to acceleration
+            if (draws[j].v[0] % 100 < sim->settings.spread_factor) {
+                // change x and y by random percentage of max allowed change per second
+                double x_accel_change = ((int)(draws[j].v[1] % 201) - 100) / 100.0 
+                                        * sim->settings.time_resolution * XYACCELDELTAMAX;
+                double y_accel_change = ((int)(draws[j].v[2] % 201) - 100) / 100.0 
+                                        * sim->settings.time_resolution * XYACCELDELTAMAX;
+                if (sim->settings.debug >= 3) {
+                    printf("Changing x/y accel for node %d by %f,%f\n", i, x_accel_change, y_accel_change);
+                }
+                NODE_KIN(sim, i, x_acceleration) += x_accel_change;
+                NODE_KIN(sim, i, y_acceleration) += y_accel_change;
             }
-            nodes[i].x_acceleration += x_accel_change;
-            nodes[i].y_acceleration += y_accel_change;
+            // update z acceleration 
+            // for our purposes z always equals gravity so not update needed (just a placeholder)
         }
-        // update z acceleration 
-        // for our purposes z always equals gravity so not update needed (just a placeholder)
     }
     return 0;
 }
 
-int update_velocity(struct Node* nodes) {
-    for (int i = 0; i < settings.node_count; i++) {
+int update_velocity(struct Simulation* sim) {
+    return update_velocity_range(sim, 0, sim->settings.node_count);
+}
+
+int update_velocity_range(struct Simulation* sim, int start, int end) {
+#ifdef KINEMATICS_SOA
+    // vector kernel unless per node debug output is wanted
+    if (sim->settings.debug < 2) {
+        return kinematics_update_velocity(&sim->kinematics, sim->settings.time_resolution, start, end);
+    }
+#endif
+    for (int i = start; i < end; i++) {
         // update z velocity
-        if (nodes[i].z_pos > 0) { 
-            if (nodes[i].z_velocity < nodes[i].terminal_velocity) {
-                if (nodes[i].z_velocity + (nodes[i].z_acceleration * 
-                    settings.time_resolution) < nodes[i].terminal_velocity) {
-                    nodes[i].z_velocity += (nodes[i].z_acceleration *
-                                           settings.time_resolution);
+        if (NODE_KIN(sim, i, z_pos) > 0) { 
+            if (NODE_KIN(sim, i, z_velocity) < NODE_KIN(sim, i, terminal_velocity)) {
+                if (NODE_KIN(sim, i, z_velocity) + (NODE_KIN(sim, i, z_acceleration) * 
+                    sim->settings.time_resolution) < NODE_KIN(sim, i, terminal_velocity)) {
+                    NODE_KIN(sim, i, z_velocity) += (NODE_KIN(sim, i, z_acceleration) *
+                                           sim->settings.time_resolution);
                 }
                 else {
-                    nodes[i].z_velocity = nodes[i].terminal_velocity;
-                    if (settings.debug >=2) {
-                        printf("Node %d reached terminal velocity of %f m/s\n", i, nodes[i].terminal_velocity);
+                    NODE_KIN(sim, i, z_velocity) = NODE_KIN(sim, i, terminal_velocity);
+                    if (sim->settings.debug >=2) {
+                        printf("Node %d reached terminal velocity of %f m/s\n", i, NODE_KIN(sim, i, terminal_velocity));
                     }
                 }
             }
         }
         // update x/y velocity
-        nodes[i].x_velocity += (nodes[i].x_acceleration * settings.time_resolution);
-        nodes[i].y_velocity += (nodes[i].y_acceleration * settings.time_resolution);
+        NODE_KIN(sim, i, x_velocity) += (NODE_KIN(sim, i, x_acceleration) * sim->settings.time_resolution);
+        NODE_KIN(sim, i, y_velocity) += (NODE_KIN(sim, i, y_acceleration) * sim->settings.time_resolution);
     }     
     return 0;
 }
 
-int update_position(struct Node* nodes) {
-    for (int i = 0; i < settings.node_count; i++) {
+int update_position(struct Simulation* sim) {
+    return update_position_range(sim, 0, sim->settings.node_count);
+}
+
+int update_position_range(struct Simulation* sim, int start, int end) {
+#ifdef KINEMATICS_SOA
+    return kinematics_update_position(&sim->kinematics, sim->settings.time_resolution, start, end);
+#else
+    for (int i = start; i < end; i++) {
         // Update z position
-        if (nodes[i].z_pos > 0) { 
-            if (nodes[i].z_pos - (nodes[i].z_velocity * settings.time_resolution) > 0) { 
-                nodes[i].z_pos -= (nodes[i].z_velocity * settings.time_resolution);
+        if (NODE_KIN(sim, i, z_pos) > 0) { 
+            if (NODE_KIN(sim, i, z_pos) - (NODE_KIN(sim, i, z_velocity) * sim->settings.time_resolution) > 0) { 
+                NODE_KIN(sim, i, z_pos) -= (NODE_KIN(sim, i, z_velocity) * sim->settings.time_resolution);
             }
             else {
-                nodes[i].z_pos = 0;
+                NODE_KIN(sim, i, z_pos) = 0;
             }
         }
         // Update x/y position
-        nodes[i].x_pos += (nodes[i].x_velocity * settings.time_resolution);
-        nodes[i].y_pos += (nodes[i].y_velocity * settings.time_resolution);
+        NODE_KIN(sim, i, x_pos) += (NODE_KIN(sim, i, x_velocity) * sim->settings.time_resolution);
+        NODE_KIN(sim, i, y_pos) += (NODE_KIN(sim, i, y_velocity) * sim->settings.time_resolution);
 
     }
     return 0;
+#endif
 }
 
-int update_signal(struct Node* nodes, int id, int target) {
+/**
+ * Update kinematics span
+ * Desc: Same as ticks rounds of update_acceleration(), update_velocity() and
+ *       update_position() from cycle first_cycle on, one node at a time so
+ *       its state stays in locals for the whole span. Z motion has no random
+ *       part, it goes first so the span can stop on the tick the last
+ *       falling node lands. X/y still take every tick's acceleration draw.
+ *
+ * Returns: ticks integrated, fewer than ticks when every node has landed
+**/
+unsigned long update_kinematics_span(struct Simulation* sim, unsigned long first_cycle, unsigned long ticks) {
+    double res = sim->settings.time_resolution;
+    unsigned long last_landing = 0;
+    int falling = 0;
+
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        double z = NODE_KIN(sim, i, z_pos);
+        double zv = NODE_KIN(sim, i, z_velocity);
+        double za = NODE_KIN(sim, i, z_acceleration);
+        double tv = NODE_KIN(sim, i, terminal_velocity);
+        unsigned long tick = 0;
+        while (z > 0 && tick < ticks) {
+            tick++;
+            if (zv < tv) {
+                if (zv + (za * res) < tv) {
+                    zv += (za * res);
+                }
+                else {
+                    zv = tv;
+                }
+            }
+            if (z - (zv * res) > 0) {
+                z -= (zv * res);
+            }
+            else {
+                z = 0;
+            }
+        }
+        if (z > 0) {
+            falling = 1;
+        }
+        else if (tick > last_landing) {
+            last_landing = tick;
+        }
+        NODE_KIN(sim, i, z_pos) = z;
+        NODE_KIN(sim, i, z_velocity) = zv;
+    }
+    // At least one tick, like clock_advance() would have done
+    if (!falling && last_landing < ticks) {
+        ticks = last_landing > 0 ? last_landing : 1;
+    }
+
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        double xa = NODE_KIN(sim, i, x_acceleration);
+        double ya = NODE_KIN(sim, i, y_acceleration);
+        double xv = NODE_KIN(sim, i, x_velocity);
+        double yv = NODE_KIN(sim, i, y_velocity);
+        double x = NODE_KIN(sim, i, x_pos);
+        double y = NODE_KIN(sim, i, y_pos);
+        for (unsigned long tick = 0; tick < ticks; tick++) {
+            struct RNG_Block draw;
+            rng_block(&sim->rng, &draw, i, first_cycle + tick, RNG_PURPOSE_ACCELERATION);
+            if (draw.v[0] % 100 < sim->settings.spread_factor) {
+                xa += ((int)(draw.v[1] % 201) - 100) / 100.0 * res * XYACCELDELTAMAX;
+                ya += ((int)(draw.v[2] % 201) - 100) / 100.0 * res * XYACCELDELTAMAX;
+            }
+            xv += (xa * res);
+            yv += (ya * res);
+            x += (xv * res);
+            y += (yv * res);
+        }
+        NODE_KIN(sim, i, x_acceleration) = xa;
+        NODE_KIN(sim, i, y_acceleration) = ya;
+        NODE_KIN(sim, i, x_velocity) = xv;
+        NODE_KIN(sim, i, y_velocity) = yv;
+        NODE_KIN(sim, i, x_pos) = x;
+        NODE_KIN(sim, i, y_pos) = y;
+    }
+    return ticks;
+}
+
+static double signal_from(struct Simulation* sim, int id, int target) {
     // Not taking noise floor into account currently
     // Check distance to other target node and calculate free space loss
     // to get received signal 
     double distance = sqrt(
-        pow((nodes[id].x_pos - nodes[target].x_pos),2) +
-        pow((nodes[id].y_pos - nodes[target].y_pos),2) +
-        pow((nodes[id].z_pos - nodes[target].z_pos),2) 
+        pow((NODE_KIN(sim, id, x_pos) - NODE_KIN(sim, target, x_pos)),2) +
+        pow((NODE_KIN(sim, id, y_pos) - NODE_KIN(sim, target, y_pos)),2) +
+        pow((NODE_KIN(sim, id, z_pos) - NODE_KIN(sim, target, z_pos)),2) 
     );
-    nodes[id].received_signals[target] = nodes[target].power_output -
-        (20 * log(distance) + 20 * log(2400) + 32.44);
+    return sim->nodes[target].power_output - path_loss_exact(distance);
+}
+
+// Ties go to the higher id so it doesn't matter what order targets come in
+static void signal_peak(struct Signal_Peak* peak, int target, double signal) {
+    if (peak != NULL && (peak->id == -1 || signal > peak->signal || (signal == peak->signal && target > peak->id))) {
+        peak->id = target;
+        peak->signal = signal;
+    }
+}
+
+int update_signal(struct Simulation* sim, int id, int target) {
+    set_signal(sim, id, target, signal_from(sim, id, target));
+    return 0;
+}
+
+/**
+ * Update signals
+ * Desc: update_signal() for count transmitters on channel, through the
+ *       batched fast kernel when fast_path_loss is set. The strongest one
+ *       goes in peak unless it's NULL.
+**/
+int update_signals(struct Simulation* sim, int id, int channel, const int* targets, int count,
+                   struct Signal_Peak* peak) {
+    if (!sim->settings.fast_path_loss) {
+        for (int i = 0; i < count; i++) {
+            double signal = signal_from(sim, id, targets[i]);
+            set_signal(sim, id, targets[i], signal);
+            signal_peak(peak, targets[i], signal);
+        }
+        return 0;
+    }
+    double signals[PATH_LOSS_BATCH];
+    for (int start = 0; start < count; start += PATH_LOSS_BATCH) {
+        int chunk = count - start < PATH_LOSS_BATCH ? count - start : PATH_LOSS_BATCH;
+        signal_batch_to(sim, id, channel, targets + start, chunk, signals);
+        for (int i = 0; i < chunk; i++) {
+            set_signal(sim, id, targets[start + i], signals[i]);
+            signal_peak(peak, targets[start + i], signals[i]);
+        }
+    }
+    return 0;
+}
+
+// Distance at which a transmitter of power dBm fades to receiver_sensitivity
+// under update_signal()'s path loss, infinite without a sensitivity
+double signal_range(struct Simulation* sim, double power) {
+    return exp((power - sim->settings.receiver_sensitivity - (20 * log(PATH_LOSS_FREQUENCY) + 32.44)) / 20);
+}
+
+// Copy fields read by other MCUs into the previous tick view
+int update_node_view(struct Simulation* sim, int id) {
+    struct Node* nodes = sim->nodes;
+    sim->node_views[id].transmit_active = nodes[id].transmit_active;
+    sim->node_views[id].active_channel = nodes[id].active_channel;
+    // Only packets on air can be received, keep the last one otherwise
+    if (nodes[id].transmit_active) {
+        if (sim->node_views[id].send_packet != nodes[id].send_packet) {
+            packet_ref(&sim->packets, nodes[id].send_packet);
+            packet_unref(&sim->packets, sim->node_views[id].send_packet);
+            sim->node_views[id].send_packet = nodes[id].send_packet;
+        }
+    }
+    return 0;
+}
+
+// Change node channel, moving it in the channel index and interference
+// sums if transmitting
+int set_active_channel(struct Simulation* sim, int id, int channel) {
+    struct Node* nodes = sim->nodes;
+
+    // Worker threads rebuild the index once per tick instead
+    if (nodes[id].transmit_active == 1 && sim->node_views == NULL && 
+        nodes[id].active_channel != channel) {
+        channel_index_remove(sim, nodes[id].active_channel, id);
+        channel_index_add(sim, channel, id);
+        interference_start(sim, id, channel);
+    }
+    nodes[id].active_channel = channel;
     return 0;
 }
 
-int write_node_data(struct Node* nodes, int id, FILE *fp) {
-    char buffer[100 + settings.node_count * 15];
-    sprintf(buffer, "%f\t%i\t%i\t%f\t%f\t%f ", state.current_time, 
-                                          nodes[id].active_channel,
-                                          nodes[id].current_function, 
-                                          nodes[id].x_pos, 
-                                          nodes[id].y_pos, 
-                                          nodes[id].z_pos);
-    fputs(buffer, fp);
-    for (int i = 0; i < settings.node_count; i++) {
-        if (i < settings.node_count - 1) {
-            sprintf(buffer, "%f\t", nodes[id].received_signals[i]);
+// Turn node transmitter on or off, keeping the channel index and
+// interference sums up to date
+int set_transmit_active(struct Simulation* sim, int id, int transmit_active) {
+    struct Node* nodes = sim->nodes;
+    if (nodes[id].transmit_active != transmit_active && sim->node_views == NULL) {
+        if (transmit_active == 1) {
+            channel_index_add(sim, nodes[id].active_channel, id);
+            interference_start(sim, id, nodes[id].active_channel);
         }
         else {
-            sprintf(buffer, "%f", nodes[id].received_signals[i]);
+            channel_index_remove(sim, nodes[id].active_channel, id);
+            interference_stop(sim, id);
         }
-        fputs(buffer, fp);
     }
-    sprintf(buffer,"\n");
-    fputs(buffer, fp);
+    nodes[id].transmit_active = transmit_active;
+    return 0;
+}
+
+int count_moving_nodes(struct Simulation* sim) {
+    int moving_nodes = 0;
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        if (NODE_KIN(sim, i, z_pos) > 0) {
+            moving_nodes++;
+        }
+    }
+    return moving_nodes;
+}
+
+// Appends one line of node data to the node's output file
+int write_node_data(struct Simulation* sim, const struct Output_Sample* sample, int id) {
+    int node_count = sim->settings.node_count;
+    int file = OUTPUT_NODE_FILE(id);
+    const double* signals = sample->signals + (size_t)id * node_count;
+    output_printf(&sim->output, file, "%f\t%i\t%i\t%f\t%f\t%f ", sample->time, 
+                                          sample->channel[id],
+                                          sample->function[id], 
+                                          sample->x[id], 
+                                          sample->y[id], 
+                                          sample->z[id]);
+    for (int i = 0; i < node_count; i++) {
+        if (i < node_count - 1) {
+            output_printf(&sim->output, file, "%f\t", signals[i]);
+        }
+        else {
+            output_printf(&sim->output, file, "%f", signals[i]);
+        }
+    }
+    output_write(&sim->output, file, "\n", 1);
 
     return 0;
 }
 
-void fs_push(int caller, int return_to_label, struct FS_Element** stack){
-    struct FS_Element* element = (struct FS_Element*)malloc(sizeof(struct FS_Element)); 
-    element -> caller = caller; 
-    element -> return_to_label = return_to_label;
-    element -> next = *stack;  
-    (*stack) = element;  
+// Stacks grow up from their bottom element inside the node's arena slice,
+// running out of room is a protocol bug so it stops the simulation
+void fs_push(struct Node* node, int caller, int return_to_label){
+    if (node->function_stack - node->function_stack_base >= MCU_STACK_DEPTH - 1) {
+        printf("MCU function stack overflow (depth %d)\n", MCU_STACK_DEPTH);
+        exit(0);
+    }
+    node->function_stack++;
+    node->function_stack->caller = caller; 
+    node->function_stack->return_to_label = return_to_label;
 }
 
-void fs_pop(struct FS_Element** stack){
-    if(*stack != NULL){
-        struct FS_Element* tempPtr = *stack;
-        *stack = (*stack) -> next;
-        free(tempPtr);
+void fs_pop(struct Node* node){
+    if (node->function_stack > node->function_stack_base) {
+        node->function_stack--;
     }
     else{
         printf("The stack is empty.\n");
     }
 }
 
-void rs_push(int returning_from, int return_to_label, int return_value, struct RS_Element** stack){
-    struct RS_Element* element = (struct RS_Element*)malloc(sizeof(struct RS_Element)); 
-    element -> returning_from = returning_from; 
-    element -> return_to_label = return_to_label;
-    element -> return_value = return_value;
-    element -> next = *stack;  
-    (*stack) = element;  
+void rs_push(struct Node* node, int returning_from, int return_to_label, int return_value){
+    if (node->return_stack - node->return_stack_base >= MCU_STACK_DEPTH - 1) {
+        printf("MCU return stack overflow (depth %d)\n", MCU_STACK_DEPTH);
+        exit(0);
+    }
+    node->return_stack++;
+    node->return_stack->returning_from = returning_from; 
+    node->return_stack->return_to_label = return_to_label;
+    node->return_stack->return_value = return_value;
 }
 
-void rs_pop(struct RS_Element** stack){
-    if(*stack != NULL){
-        struct RS_Element* tempPtr = *stack;
-        *stack = (*stack) -> next;
-        free(tempPtr);
+void rs_pop(struct Node* node){
+    if (node->return_stack > node->return_stack_base) {
+        node->return_stack--;
     }
     else{
         printf("The stack is empty.\n");
     }
 }
 
-int update_sensor(struct Node* nodes, int id, int sensor_number) {
+int update_sensor(struct Simulation* sim, int id, int sensor_number) {
+    struct Sensor_Reading* sensor = &sim->nodes[id].sensors[sensor_number];
+
     // Update sensor based on sensor type
-    if (nodes[id].sensors[sensor_number].type == SENSOR_TYPE_TEMP) {
+    if (sensor->type == SENSOR_TYPE_TEMP) {
         // not yet implemented, use generic value for now
-        snprintf(nodes[id].sensors[sensor_number].reading, READING_BUFFER_SIZE, "%f", 20.0);
+        sensor->value_count = 1;
+        sensor->values[0] = 20.0;
+    }
+    else if (sensor->type == SENSOR_TYPE_ACCELEROMETER) { 
+        sensor->value_count = 3;
+        sensor->values[0] = NODE_KIN(sim, id, x_acceleration);
+        sensor->values[1] = NODE_KIN(sim, id, y_acceleration);
+        sensor->values[2] = NODE_KIN(sim, id, z_acceleration);
+    }
+    else if (sensor->type == SENSOR_TYPE_ALTIMETER) {
+        sensor->value_count = 1;
+        sensor->values[0] = NODE_KIN(sim, id, z_pos);
     }
-    else if (nodes[id].sensors[sensor_number].type == SENSOR_TYPE_ACCELEROMETER) { 
-        snprintf(nodes[id].sensors[sensor_number].reading, READING_BUFFER_SIZE, "%f %f %f",
-                 nodes[id].x_acceleration,
-                 nodes[id].y_acceleration,
-                 nodes[id].z_acceleration);
+    else if (sensor->type == SENSOR_TYPE_GPS) { 
+        sensor->value_count = 3;
+        sensor->values[0] = NODE_KIN(sim, id, x_pos);
+        sensor->values[1] = NODE_KIN(sim, id, y_pos);
+        sensor->values[2] = NODE_KIN(sim, id, z_pos);
+    }
+    return 0;
+}
+
+/**
+ * Node send packet
+ * Desc: Stamps packet with the node id, its next sequence number and the
+ *       current time, then publishes it in the packet slab as the node's
+ *       send_packet for transmit_message_begin to put on air. When
+ *       payload_from isn't PACKET_NONE the sensor payload is copied as
+ *       encoded bytes from that packet instead of taken from packet.
+**/
+int node_send_packet(struct Simulation* sim, int id, struct Packet* packet, int payload_from) {
+    struct Node* node = &sim->nodes[id];
+    packet->src = id;
+    packet->seq = node->packet_seq++ & 0xffff;
+    packet->timestamp = sim->state.current_time;
+
+    int handle = packet_slab_alloc(&sim->packets);
+    struct Packet_Slot* slot = packet_slot(&sim->packets, handle);
+    if (payload_from != PACKET_NONE) {
+        struct Packet_Slot* source = packet_slot(&sim->packets, payload_from);
+        slot->length = packet_reframe(packet, source->frame, source->length, slot->frame, sizeof(slot->frame));
     }
-    else if (nodes[id].sensors[sensor_number].type == SENSOR_TYPE_ALTIMETER) {
-        snprintf(nodes[id].sensors[sensor_number].reading, READING_BUFFER_SIZE, "%f", nodes[id].z_pos);
+    else {
+        slot->length = packet_encode(packet, slot->frame, sizeof(slot->frame));
     }
-    else if (nodes[id].sensors[sensor_number].type == SENSOR_TYPE_GPS) { 
-        snprintf(nodes[id].sensors[sensor_number].reading, READING_BUFFER_SIZE, "%f %f %f",
-                 nodes[id].x_pos,
-                 nodes[id].y_pos,
-                 nodes[id].z_pos);
+    if (slot->length < 0) {
+        printf("Packet too large for send buffer\n");
+        exit(0);
     }
+
+    // Receivers still holding the old packet keep it alive
+    packet_unref(&sim->packets, node->send_packet);
+    node->send_packet = handle;
     return 0;
-}
\ No newline at end of file
+}
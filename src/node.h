@@ -10,7 +10,11 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "kinematics.h"
 #include "messages.h"
+#include "packet.h"
+#include "packet_slab.h"
+#include "path_loss.h"
 #include "settings.h"
 #include "timers.h"
 
@@ -25,18 +29,13 @@
 #define SENSOR_TYPE_ALTIMETER       2
 #define SENSOR_TYPE_GPS             3
 
-#define READING_BUFFER_SIZE         64
-
-struct sensor {
-    int type;
-    char reading[READING_BUFFER_SIZE];
-};
+// Deepest either MCU stack can get, counting its bottom element
+#define MCU_STACK_DEPTH             16
 
 // Function stack element for mcu function emulation
 struct FS_Element{ 
     int caller;
     int return_to_label;                                           
-    struct FS_Element* next; 
 };
 
 // Function stack element for mcu function emulation
@@ -44,10 +43,18 @@ struct RS_Element{
     int returning_from;
     int return_to_label;
     int return_value;
-    struct RS_Element* next;
 };
 
+// Fixed depth call/return stacks of every node, node i owns elements
+// i * MCU_STACK_DEPTH up to the next node's
+struct Stack_Arena {
+    struct FS_Element* function_stacks;
+    struct RS_Element* return_stacks;
+};
+
+// Access kinematic fields with NODE_KIN(), see kinematics.h
 struct Node {
+#ifndef KINEMATICS_SOA
     double terminal_velocity;
     double x_pos;
     double y_pos;
@@ -58,37 +65,72 @@ struct Node {
     double x_acceleration;
     double y_acceleration;
     double z_acceleration;
+#endif
     double power_output;
     int transmit_active;
     int active_channel;
     int current_function;
-    double busy_remaining;
-    double* received_signals;
+    int busy_pending;
+    unsigned long wake_cycle;
+    int wait_channel;                           // see channel_wait()
+    int wait_slot;                              // place in the channel's waiter list
     int* group_list;
-    struct FS_Element* function_stack;
-    struct RS_Element* return_stack;
-    char send_packet[256];
+    struct FS_Element* function_stack;          // top of stack
+    struct RS_Element* return_stack;            // top of stack
+    struct FS_Element* function_stack_base;
+    struct RS_Element* return_stack_base;
+    int send_packet;                            // packet slab handle
+    int packet_seq;
     int* tmp_lfg_chans;
     int* tmp_scanned_chans;
     double tmp_start_time;
     int dest_node;
     int broadcaster;
     unsigned long group_cycle_start;
-    struct cycle_timer* timers;
-    struct sensor* sensors;
-    struct stored_message* stored_messages;
+    struct cycle_timer* timers;                 // CYCLE_TIMER_SLOTS slots
+    struct Sensor_Reading* sensors;
+    struct Relay_Queue relay_queue;
+};
+
+// Previous tick view of the node fields other MCUs read, used when nodes
+// run on worker threads so results don't depend on thread count
+struct Node_View {
+    int transmit_active;
+    int active_channel;
+    int send_packet;                            // holds a reference
+};
+
+struct Simulation;
+struct Output_Sample;
+
+// Strongest signal over update_signals() calls, id -1 until there is one
+struct Signal_Peak {
+    int id;
+    double signal;
 };
 
-int initialize_nodes(struct Node*); 
-int update_acceleration(struct Node*);
-int update_velocity(struct Node*);
-int update_position(struct Node*);
-int update_signal(struct Node*, int, int);
-int write_node_data(struct Node*, int, FILE*);
-void fs_push(int, int, struct FS_Element**);
-void fs_pop(struct FS_Element**);
-void rs_push(int, int, int, struct RS_Element**);
-void rs_pop(struct RS_Element**);
-int update_sensor(struct Node*, int, int);
+int initialize_nodes(struct Simulation*); 
+int free_nodes(struct Simulation*);
+int update_acceleration(struct Simulation*);
+int update_velocity(struct Simulation*);
+int update_position(struct Simulation*);
+int update_acceleration_range(struct Simulation*, int, int);
+int update_velocity_range(struct Simulation*, int, int);
+int update_position_range(struct Simulation*, int, int);
+unsigned long update_kinematics_span(struct Simulation*, unsigned long, unsigned long);
+int update_node_view(struct Simulation*, int);
+int set_active_channel(struct Simulation*, int, int);
+int set_transmit_active(struct Simulation*, int, int);
+int update_signal(struct Simulation*, int, int);
+int update_signals(struct Simulation*, int, int, const int*, int, struct Signal_Peak*);
+double signal_range(struct Simulation*, double);
+int count_moving_nodes(struct Simulation*);
+int write_node_data(struct Simulation*, const struct Output_Sample*, int);
+void fs_push(struct Node*, int, int);
+void fs_pop(struct Node*);
+void rs_push(struct Node*, int, int, int);
+void rs_pop(struct Node*);
+int update_sensor(struct Simulation*, int, int);
+int node_send_packet(struct Simulation*, int, struct Packet*, int);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,197 @@
+/**
+ * @file    output_queue.c
+ * @brief   Single producer/single consumer record ring feeding a writer thread
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "output_queue.h"
+
+#define ROUND8(x)   (((x) + 7) & ~(size_t)7)
+
+static void put_header(unsigned char* at, uint32_t type, uint32_t length) {
+    memcpy(at, &type, 4);
+    memcpy(at + 4, &length, 4);
+}
+
+static double monotonic_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Output queue init
+ * Desc: Sets up a ring of at least capacity bytes for records up to
+ *       max_record bytes. The ring is made big enough for two of the
+ *       largest record, so one always fits after any filler at the end.
+**/
+int output_queue_init(struct Output_Queue* queue, size_t capacity, size_t max_record,
+                      Output_Record_Handler handler, void* context) {
+    memset(queue, 0, sizeof(*queue));
+    queue->max_record = ROUND8(max_record);
+    size_t largest = OUTPUT_RECORD_HEADER_SIZE + queue->max_record;
+    queue->capacity = ROUND8(capacity) > 2 * largest ? ROUND8(capacity) : 2 * largest;
+    queue->scratch = malloc(queue->max_record > 0 ? queue->max_record : 8);
+    if (queue->scratch == NULL) {
+        printf("Output queue memory allocation error\n");
+        exit(0);
+    }
+    queue->handler = handler;
+    queue->context = context;
+    return 0;
+}
+
+static void* writer_thread(void* arg) {
+    struct Output_Queue* queue = arg;
+    uint64_t tail = queue->tail;
+
+    while (1) {
+        uint64_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            if (__atomic_load_n(&queue->stopping, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            // Recheck under the lock after saying we're asleep, commit
+            // checks consumer_waiting after moving head
+            pthread_mutex_lock(&queue->lock);
+            __atomic_store_n(&queue->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&queue->head, __ATOMIC_SEQ_CST) == tail &&
+                !__atomic_load_n(&queue->stopping, __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&queue->not_empty, &queue->lock);
+            }
+            __atomic_store_n(&queue->consumer_waiting, 0, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&queue->lock);
+            continue;
+        }
+
+        unsigned char* at = queue->ring + tail % queue->capacity;
+        uint32_t type;
+        uint32_t length;
+        memcpy(&type, at, 4);
+        memcpy(&length, at + 4, 4);
+        if (type != OUTPUT_RECORD_PAD) {
+            queue->handler(queue->context, type, at + OUTPUT_RECORD_HEADER_SIZE, length);
+        }
+        tail += OUTPUT_RECORD_HEADER_SIZE + ROUND8(length);
+        __atomic_store_n(&queue->tail, tail, __ATOMIC_SEQ_CST);
+
+        // A stalled producer is woken once half the ring is free (or it's
+        // empty) rather than for every record, so the two threads don't
+        // trade places on each one
+        if (__atomic_load_n(&queue->producer_waiting, __ATOMIC_SEQ_CST) &&
+            (head - tail <= queue->capacity / 2 || head == tail)) {
+            pthread_mutex_lock(&queue->lock);
+            pthread_cond_signal(&queue->not_full);
+            pthread_mutex_unlock(&queue->lock);
+        }
+    }
+    return NULL;
+}
+
+// Hands records to a writer thread from now on
+int output_queue_start(struct Output_Queue* queue) {
+    queue->ring = malloc(queue->capacity);
+    if (queue->ring == NULL) {
+        printf("Output queue memory allocation error\n");
+        exit(0);
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    queue->threaded = 1;
+    if (pthread_create(&queue->thread, NULL, writer_thread, queue) != 0) {
+        printf("Output writer thread creation error\n");
+        exit(0);
+    }
+    return 0;
+}
+
+/**
+ * Output queue reserve
+ * Desc: Space for a record of length bytes (at most max_record), waiting
+ *       for the writer if the ring is full. Nothing is visible to the
+ *       writer until output_queue_commit().
+ *
+ * Returns: where to put the record
+**/
+void* output_queue_reserve(struct Output_Queue* queue, size_t length) {
+    queue->reserved = length;
+    if (!queue->threaded) {
+        return queue->scratch;
+    }
+
+    size_t size = OUTPUT_RECORD_HEADER_SIZE + ROUND8(length);
+    size_t pos = queue->head % queue->capacity;
+    queue->pad = pos + size > queue->capacity ? queue->capacity - pos : 0;
+
+    uint64_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (queue->head + queue->pad + size - tail > queue->capacity) {
+        double start = monotonic_seconds();
+        queue->stalls++;
+        pthread_mutex_lock(&queue->lock);
+        __atomic_store_n(&queue->producer_waiting, 1, __ATOMIC_SEQ_CST);
+        while (queue->head + queue->pad + size - __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) >
+               queue->capacity) {
+            pthread_cond_wait(&queue->not_full, &queue->lock);
+        }
+        __atomic_store_n(&queue->producer_waiting, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&queue->lock);
+        queue->stall_time += monotonic_seconds() - start;
+    }
+
+    return queue->ring + (pos + queue->pad) % queue->capacity + OUTPUT_RECORD_HEADER_SIZE;
+}
+
+// Publishes the reserved record to the writer, or handles it right here
+// without a writer thread
+void output_queue_commit(struct Output_Queue* queue, int type) {
+    queue->records++;
+    if (!queue->threaded) {
+        queue->handler(queue->context, type, queue->scratch, queue->reserved);
+        return;
+    }
+
+    size_t pos = queue->head % queue->capacity;
+    if (queue->pad > 0) {
+        put_header(queue->ring + pos, OUTPUT_RECORD_PAD, queue->pad - OUTPUT_RECORD_HEADER_SIZE);
+    }
+    put_header(queue->ring + (pos + queue->pad) % queue->capacity, type, queue->reserved);
+
+    uint64_t head = queue->head + queue->pad + OUTPUT_RECORD_HEADER_SIZE + ROUND8(queue->reserved);
+    __atomic_store_n(&queue->head, head, __ATOMIC_SEQ_CST);
+    size_t used = head - __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    if (used > queue->peak_used) {
+        queue->peak_used = used;
+    }
+
+    if (__atomic_load_n(&queue->consumer_waiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+// Lets the writer finish everything queued, then stops it
+void output_queue_close(struct Output_Queue* queue) {
+    if (queue->threaded) {
+        pthread_mutex_lock(&queue->lock);
+        __atomic_store_n(&queue->stopping, 1, __ATOMIC_SEQ_CST);
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+        pthread_join(queue->thread, NULL);
+        pthread_mutex_destroy(&queue->lock);
+        pthread_cond_destroy(&queue->not_full);
+        pthread_cond_destroy(&queue->not_empty);
+        queue->threaded = 0;
+    }
+    free(queue->ring);
+    free(queue->scratch);
+    queue->ring = NULL;
+    queue->scratch = NULL;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file    output_queue.h
+ * @brief   Single producer/single consumer record ring feeding a writer thread
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef output_queue_H
+#define output_queue_H
+
+#define OUTPUT_RECORD_PAD           0   // filler up to the end of the ring
+#define OUTPUT_RECORD_HEADER_SIZE   8   // type u32, length u32
+
+// Called on the writer thread for each record, in the order they went in
+typedef int (*Output_Record_Handler)(void* context, int type, const unsigned char* data, size_t length);
+
+/**
+ * Records are written straight into the ring by the simulation thread
+ * (reserve, fill, commit) and handed to the handler by the writer thread.
+ * head and tail are byte counts that only grow, each owned by one side.
+ * Either side only takes the lock to sleep or to wake the other, so the
+ * simulation never waits on the writer unless the ring is full.
+ *
+ * Until output_queue_start() (or with no thread at all) commit calls the
+ * handler right away on the caller's thread.
+**/
+struct Output_Queue {
+    unsigned char* ring;
+    size_t capacity;
+    size_t max_record;
+    unsigned char* scratch;         // record space while there's no thread
+    uint64_t head;
+    uint64_t tail;
+    size_t pad;                     // filler in front of the reserved record
+    size_t reserved;
+    int threaded;
+    int stopping;
+    int producer_waiting;
+    int consumer_waiting;
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+    pthread_t thread;
+    Output_Record_Handler handler;
+    void* context;
+    // Backpressure, counted on the simulation thread
+    unsigned long records;
+    unsigned long stalls;
+    double stall_time;
+    size_t peak_used;
+};
+
+int output_queue_init(struct Output_Queue* queue, size_t capacity, size_t max_record,
+                      Output_Record_Handler handler, void* context);
+int output_queue_start(struct Output_Queue* queue);
+void* output_queue_reserve(struct Output_Queue* queue, size_t length);
+void output_queue_commit(struct Output_Queue* queue, int type);
+void output_queue_close(struct Output_Queue* queue);
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ * @file    output_writer.c
+ * @brief   Buffered output files kept open across a whole run
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output_writer.h"
+
+int output_writer_init(struct Output_Writer* writer, int file_count, size_t buffer_size, int max_open) {
+    writer->files = calloc(file_count, sizeof(struct Output_File));
+    if (writer->files == NULL) {
+        printf("Output memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < file_count; i++) {
+        writer->files[i].fd = -1;
+        writer->files[i].newer = -1;
+        writer->files[i].older = -1;
+    }
+    writer->file_count = file_count;
+    writer->open_count = 0;
+    writer->max_open = max_open > 0 ? max_open : 1;
+    writer->buffer_size = buffer_size > 0 ? buffer_size : 1;
+    writer->newest = -1;
+    writer->oldest = -1;
+    return 0;
+}
+
+static void write_all(struct Output_File* file, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(file->fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Unable to write output file \"%s\": %s\n", file->path, strerror(errno));
+            exit(1);
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+static void cache_unlink(struct Output_Writer* writer, struct Output_File* file) {
+    if (file->newer >= 0) {
+        writer->files[file->newer].older = file->older;
+    } else {
+        writer->newest = file->older;
+    }
+    if (file->older >= 0) {
+        writer->files[file->older].newer = file->newer;
+    } else {
+        writer->oldest = file->newer;
+    }
+    file->newer = -1;
+    file->older = -1;
+}
+
+static void cache_push(struct Output_Writer* writer, struct Output_File* file) {
+    int index = file - writer->files;
+    file->newer = -1;
+    file->older = writer->newest;
+    if (writer->newest >= 0) {
+        writer->files[writer->newest].newer = index;
+    } else {
+        writer->oldest = index;
+    }
+    writer->newest = index;
+}
+
+/**
+ * Output file open
+ * Desc: Makes sure file is in the cache with a descriptor and a buffer.
+ *       When the cache is full the least recently used file is flushed and
+ *       closed, and its buffer passed on to file.
+**/
+static void output_file_open(struct Output_Writer* writer, struct Output_File* file) {
+    int index = file - writer->files;
+    if (writer->newest == index) {
+        return;
+    }
+    if (file->fd >= 0) {
+        cache_unlink(writer, file);
+        cache_push(writer, file);
+        return;
+    }
+
+    if (writer->open_count >= writer->max_open) {
+        struct Output_File* oldest = &writer->files[writer->oldest];
+        if (oldest->used > 0) {
+            write_all(oldest, oldest->buffer, oldest->used);
+        }
+        close(oldest->fd);
+        cache_unlink(writer, oldest);
+        oldest->fd = -1;
+        file->buffer = oldest->buffer;
+        oldest->buffer = NULL;
+        oldest->used = 0;
+        writer->open_count--;
+    } else {
+        file->buffer = malloc(writer->buffer_size);
+        if (file->buffer == NULL) {
+            printf("Output memory allocation error\n");
+            exit(0);
+        }
+    }
+    file->used = 0;
+
+    int flags = O_WRONLY | O_CREAT | (file->created ? O_APPEND : O_TRUNC);
+    file->fd = open(file->path, flags, 0666);
+    if (file->fd < 0) {
+        fprintf(stderr, "Unable to open output file \"%s\": %s\n", file->path, strerror(errno));
+        exit(1);
+    }
+    file->created = 1;
+    cache_push(writer, file);
+    writer->open_count++;
+}
+
+// Registers file under path and creates it empty
+int output_file_create(struct Output_Writer* writer, int file, const char* path) {
+    struct Output_File* f = &writer->files[file];
+    f->path = strdup(path);
+    if (f->path == NULL) {
+        printf("Output memory allocation error\n");
+        exit(0);
+    }
+    f->created = 0;
+    output_file_open(writer, f);
+    return 0;
+}
+
+// Only files in the cache have anything buffered
+int output_flush(struct Output_Writer* writer, int file) {
+    struct Output_File* f = &writer->files[file];
+    if (f->used > 0) {
+        write_all(f, f->buffer, f->used);
+        f->used = 0;
+    }
+    return 0;
+}
+
+// Data too big for the buffer goes straight to the file after what's queued
+int output_write(struct Output_Writer* writer, int file, const char* data, size_t length) {
+    struct Output_File* f = &writer->files[file];
+    output_file_open(writer, f);
+    if (f->used + length > writer->buffer_size) {
+        output_flush(writer, file);
+    }
+    if (length > writer->buffer_size) {
+        write_all(f, data, length);
+        return 0;
+    }
+    memcpy(f->buffer + f->used, data, length);
+    f->used += length;
+    return 0;
+}
+
+// Formats straight into the file's buffer when it fits
+int output_printf(struct Output_Writer* writer, int file, const char* format, ...) {
+    struct Output_File* f = &writer->files[file];
+    char line[256];
+    va_list args;
+
+    output_file_open(writer, f);
+    size_t space = writer->buffer_size - f->used;
+    va_start(args, format);
+    int length = vsnprintf(f->buffer + f->used, space, format, args);
+    va_end(args);
+    if (length >= 0 && (size_t)length < space) {
+        f->used += length;
+        return length;
+    }
+
+    va_start(args, format);
+    length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0) {
+        return length;
+    }
+    if ((size_t)length < sizeof(line)) {
+        output_write(writer, file, line, length);
+        return length;
+    }
+
+    char* text = malloc(length + 1);
+    if (text == NULL) {
+        printf("Output memory allocation error\n");
+        exit(0);
+    }
+    va_start(args, format);
+    vsnprintf(text, length + 1, format, args);
+    va_end(args);
+    output_write(writer, file, text, length);
+    free(text);
+    return length;
+}
+
+int output_flush_all(struct Output_Writer* writer) {
+    for (int i = writer->newest; i >= 0; i = writer->files[i].older) {
+        output_flush(writer, i);
+    }
+    return 0;
+}
+
+// Flushes every file and releases the writer
+void output_writer_close(struct Output_Writer* writer) {
+    output_flush_all(writer);
+    for (int i = 0; i < writer->file_count; i++) {
+        if (writer->files[i].fd >= 0) {
+            close(writer->files[i].fd);
+        }
+        free(writer->files[i].buffer);
+        free(writer->files[i].path);
+    }
+    free(writer->files);
+    writer->files = NULL;
+    writer->file_count = 0;
+    writer->open_count = 0;
+}
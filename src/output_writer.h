@@ -0,0 +1,47 @@
+/**
+ * @file    output_writer.h
+ * @brief   Buffered output files kept open across a whole run
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stddef.h>
+
+#ifndef output_writer_H
+#define output_writer_H
+
+// One output file, holds a descriptor and a buffer only while it is in
+// the writer's open file cache
+struct Output_File {
+    char* path;
+    int fd;                         // -1 while not in the cache
+    int created;                    // truncated on first open, appended after
+    char* buffer;                   // NULL while not in the cache
+    size_t used;
+    int newer;                      // cache neighbors, -1 at either end
+    int older;
+};
+
+// Set of output files sharing a bounded LRU cache of open descriptors and
+// buffers, so buffer memory is at most max_open * buffer_size
+struct Output_Writer {
+    struct Output_File* files;
+    int file_count;
+    int open_count;
+    int max_open;
+    size_t buffer_size;
+    int newest;                     // most recently used open file, -1 if none
+    int oldest;                     // next file to evict
+};
+
+int output_writer_init(struct Output_Writer* writer, int file_count, size_t buffer_size, int max_open);
+int output_file_create(struct Output_Writer* writer, int file, const char* path);
+int output_write(struct Output_Writer* writer, int file, const char* data, size_t length);
+int output_printf(struct Output_Writer* writer, int file, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+int output_flush(struct Output_Writer* writer, int file);
+int output_flush_all(struct Output_Writer* writer);
+void output_writer_close(struct Output_Writer* writer);
+
+#endif
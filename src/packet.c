@@ -0,0 +1,258 @@
+/**
+ * @file    packet.c
+ * @brief   Binary packet frames sent between nodes and to ground
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "packet.h"
+
+// Frame writer/reader, pos runs past size instead of overflowing so a
+// single check at the end catches short buffers
+struct Frame_Cursor {
+    unsigned char* data;
+    const unsigned char* in;
+    int size;
+    int pos;
+};
+
+static void put_bytes(struct Frame_Cursor* c, uint64_t value, int bytes) {
+    if (c->pos + bytes <= c->size) {
+        for (int i = 0; i < bytes; i++) {
+            c->data[c->pos + i] = (value >> (8 * i)) & 0xff;
+        }
+    }
+    c->pos += bytes;
+}
+
+static uint64_t get_bytes(struct Frame_Cursor* c, int bytes) {
+    uint64_t value = 0;
+    if (c->pos + bytes <= c->size) {
+        for (int i = 0; i < bytes; i++) {
+            value |= (uint64_t)c->in[c->pos + i] << (8 * i);
+        }
+    }
+    c->pos += bytes;
+    return value;
+}
+
+static void put_double(struct Frame_Cursor* c, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_bytes(c, bits, 8);
+}
+
+static double get_double(struct Frame_Cursor* c) {
+    uint64_t bits = get_bytes(c, 8);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int has_payload(int type) {
+    return type == PACKET_TYPE_DATA || type == PACKET_TYPE_RELAY;
+}
+
+static void put_header(struct Frame_Cursor* c, const struct Packet* packet, int reading_count) {
+    put_bytes(c, packet->type, 1);
+    put_bytes(c, reading_count, 1);
+    put_bytes(c, (uint16_t)packet->seq, 2);
+    put_bytes(c, (uint32_t)packet->dest, 4);
+    put_bytes(c, (uint32_t)packet->src, 4);
+    put_double(c, packet->timestamp);
+}
+
+/**
+ * Packet encode
+ * Desc: Writes packet into frame, the sensor payload only goes out with
+ *       DATA and RELAY packets and readings past PACKET_MAX_SENSORS are
+ *       dropped
+ *
+ * Returns: frame length, or -1 if it doesn't fit in size bytes
+**/
+int packet_encode(const struct Packet* packet, unsigned char* frame, int size) {
+    struct Frame_Cursor c = {frame, NULL, size, 0};
+    const struct Sensor_Payload* payload = &packet->payload;
+    int reading_count = 0;
+    if (has_payload(packet->type)) {
+        reading_count = payload->reading_count;
+        if (reading_count > PACKET_MAX_SENSORS) {
+            reading_count = PACKET_MAX_SENSORS;
+        }
+    }
+
+    put_header(&c, packet, reading_count);
+
+    if (has_payload(packet->type)) {
+        put_bytes(&c, (uint32_t)payload->origin, 4);
+        put_double(&c, payload->time);
+        for (int i = 0; i < reading_count; i++) {
+            const struct Sensor_Reading* reading = &payload->readings[i];
+            put_bytes(&c, reading->type, 1);
+            put_bytes(&c, reading->value_count, 1);
+            for (int j = 0; j < reading->value_count; j++) {
+                put_double(&c, reading->values[j]);
+            }
+        }
+    }
+
+    return c.pos <= size ? c.pos : -1;
+}
+
+/**
+ * Packet reframe
+ * Desc: Writes packet's header in front of the sensor payload of the
+ *       encoded frame source, so a payload can be sent on as DATA or RELAY
+ *       without decoding it. The payload in packet is ignored.
+ *
+ * Returns: frame length, or -1 if source has no payload or it doesn't fit
+**/
+int packet_reframe(const struct Packet* packet, const unsigned char* source, int source_length, 
+                   unsigned char* frame, int size) {
+    if (source_length < PACKET_HEADER_SIZE || !has_payload(source[0]) || !has_payload(packet->type)) {
+        return -1;
+    }
+    int payload_length = source_length - PACKET_HEADER_SIZE;
+    if (PACKET_HEADER_SIZE + payload_length > size) {
+        return -1;
+    }
+    struct Frame_Cursor c = {frame, NULL, size, 0};
+    put_header(&c, packet, source[1]);
+    memcpy(frame + PACKET_HEADER_SIZE, source + PACKET_HEADER_SIZE, payload_length);
+    return PACKET_HEADER_SIZE + payload_length;
+}
+
+// Header fields only, enough for a receiver to tell if the packet is for it.
+// Returns 0, or -1 on a short frame
+int packet_decode_header(const unsigned char* frame, int length, struct Packet* packet) {
+    struct Frame_Cursor c = {NULL, frame, length, 0};
+
+    packet->type = get_bytes(&c, 1);
+    packet->payload.reading_count = get_bytes(&c, 1);
+    packet->seq = get_bytes(&c, 2);
+    packet->dest = (int32_t)get_bytes(&c, 4);
+    packet->src = (int32_t)get_bytes(&c, 4);
+    packet->timestamp = get_double(&c);
+
+    if (c.pos > length) {
+        packet->type = PACKET_TYPE_NONE;
+        return -1;
+    }
+    return 0;
+}
+
+// Whole packet including the sensor payload. Returns 0, or -1 on a short
+// or malformed frame
+int packet_decode(const unsigned char* frame, int length, struct Packet* packet) {
+    if (packet_decode_header(frame, length, packet) != 0) {
+        return -1;
+    }
+    if (!has_payload(packet->type)) {
+        return 0;
+    }
+
+    struct Frame_Cursor c = {NULL, frame, length, PACKET_HEADER_SIZE};
+    struct Sensor_Payload* payload = &packet->payload;
+    if (payload->reading_count > PACKET_MAX_SENSORS) {
+        return -1;
+    }
+    payload->origin = (int32_t)get_bytes(&c, 4);
+    payload->time = get_double(&c);
+    for (int i = 0; i < payload->reading_count; i++) {
+        struct Sensor_Reading* reading = &payload->readings[i];
+        reading->type = get_bytes(&c, 1);
+        reading->value_count = get_bytes(&c, 1);
+        if (reading->value_count > SENSOR_MAX_VALUES) {
+            return -1;
+        }
+        for (int j = 0; j < reading->value_count; j++) {
+            reading->values[j] = get_double(&c);
+        }
+    }
+
+    return c.pos <= length ? 0 : -1;
+}
+
+static int format_address(int address, char* text, int size) {
+    if (address == PACKET_ADDR_ALL) {
+        return snprintf(text, size, "N-ALL");
+    }
+    if (address == PACKET_ADDR_GROUND) {
+        return snprintf(text, size, "GROUND");
+    }
+    return snprintf(text, size, "N-%d", address);
+}
+
+/**
+ * Payload format
+ * Desc: Readings as text, "S0: <values> S1: <values> ... TIME <time>", the
+ *       same text nodes used to send before packets went binary. TIME keeps
+ *       its old 9 character width.
+ *
+ * Returns: length of text
+**/
+int payload_format(const struct Sensor_Payload* payload, char* text, int size) {
+    int length = 0;
+    text[0] = '\0';
+    for (int i = 0; i < payload->reading_count && length < size; i++) {
+        length += snprintf(text + length, size - length, "S%d: ", i);
+        for (int j = 0; j < payload->readings[i].value_count && length < size; j++) {
+            length += snprintf(text + length, size - length, j == 0 ? "%f" : " %f",
+                               payload->readings[i].values[j]);
+        }
+        if (length < size) {
+            length += snprintf(text + length, size - length, " ");
+        }
+    }
+    char time_text[10];
+    snprintf(time_text, sizeof(time_text), "%f", payload->time);
+    if (length < size) {
+        length += snprintf(text + length, size - length, "TIME %s", time_text);
+    }
+    return length < size ? length : size - 1;
+}
+
+/**
+ * Packet format
+ * Desc: Debug text for a packet, matching the old text packets
+ *       ("N-<dest> N-<src> DATA S0: ... TIME ...") so logs read the same
+ *
+ * Returns: length of text
+**/
+int packet_format(const struct Packet* packet, char* text, int size) {
+    char dest[16];
+    char src[16];
+    char readings[PACKET_TEXT_SIZE];
+    format_address(packet->dest, dest, sizeof(dest));
+    format_address(packet->src, src, sizeof(src));
+
+    int length = 0;
+    switch (packet->type) {
+    case PACKET_TYPE_LFG:
+        length = snprintf(text, size, "%s %s LFG", dest, src);
+        break;
+    case PACKET_TYPE_LFG_R:
+        length = snprintf(text, size, "%s %s LFG-R", dest, src);
+        break;
+    case PACKET_TYPE_ACK_LFG_R:
+        length = snprintf(text, size, "%s %s ACK LFG-R", dest, src);
+        break;
+    case PACKET_TYPE_DATA:
+        payload_format(&packet->payload, readings, sizeof(readings));
+        length = snprintf(text, size, "%s %s DATA %s", dest, src, readings);
+        break;
+    case PACKET_TYPE_RELAY:
+        payload_format(&packet->payload, readings, sizeof(readings));
+        length = snprintf(text, size, "%s %s RELAY N-%d %s ", dest, src,
+                          packet->payload.origin, readings);
+        break;
+    default:
+        length = snprintf(text, size, "%s %s UNKNOWN %d", dest, src, packet->type);
+        break;
+    }
+    return length < size ? length : size - 1;
+}
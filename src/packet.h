@@ -0,0 +1,68 @@
+/**
+ * @file    packet.h
+ * @brief   Binary packet frames sent between nodes and to ground
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifndef packet_H
+#define packet_H
+
+// Destinations that aren't node ids
+#define PACKET_ADDR_ALL             -1
+#define PACKET_ADDR_GROUND          -2
+
+#define PACKET_TYPE_NONE            0
+#define PACKET_TYPE_LFG             1
+#define PACKET_TYPE_LFG_R           2
+#define PACKET_TYPE_ACK_LFG_R       3
+#define PACKET_TYPE_DATA            4
+#define PACKET_TYPE_RELAY           5
+
+/**
+ * Frame layout, multi-byte fields little endian
+ *  header:  type u8, reading count u8, seq u16, dest i32, src i32,
+ *           timestamp f64
+ *  payload: DATA and RELAY only, origin i32, time f64, then per reading
+ *           sensor type u8, value count u8, values f64 each
+**/
+#define PACKET_HEADER_SIZE          20
+#define PACKET_MAX_SENSORS          8
+#define SENSOR_MAX_VALUES           3
+#define PACKET_MAX_SIZE             256
+#define PACKET_TEXT_SIZE            256
+
+// One sampled sensor, type is one of SENSOR_TYPE_* from node.h
+struct Sensor_Reading {
+    int type;
+    int value_count;
+    double values[SENSOR_MAX_VALUES];
+};
+
+// Readings taken by one node, relayed to ground unchanged
+struct Sensor_Payload {
+    int origin;
+    double time;
+    int reading_count;
+    struct Sensor_Reading readings[PACKET_MAX_SENSORS];
+};
+
+struct Packet {
+    int dest;
+    int src;
+    int type;
+    int seq;
+    double timestamp;
+    struct Sensor_Payload payload;
+};
+
+int packet_encode(const struct Packet* packet, unsigned char* frame, int size);
+int packet_reframe(const struct Packet* packet, const unsigned char* source, int source_length, 
+                   unsigned char* frame, int size);
+int packet_decode_header(const unsigned char* frame, int length, struct Packet* packet);
+int packet_decode(const unsigned char* frame, int length, struct Packet* packet);
+int packet_format(const struct Packet* packet, char* text, int size);
+int payload_format(const struct Sensor_Payload* payload, char* text, int size);
+
+#endif
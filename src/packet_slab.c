@@ -0,0 +1,117 @@
+/**
+ * @file    packet_slab.c
+ * @brief   Reference counted storage for encoded packet frames
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "packet_slab.h"
+
+int packet_slab_init(struct Packet_Slab* slab) {
+    slab->chunks = calloc(PACKET_SLAB_MAX_CHUNKS, sizeof(struct Packet_Slot*));
+    if (slab->chunks == NULL) {
+        printf("Packet slab memory allocation error\n");
+        exit(0);
+    }
+    slab->chunk_count = 0;
+    slab->free_head = PACKET_NONE;
+    slab->live = 0;
+    pthread_mutex_init(&slab->lock, NULL);
+    return 0;
+}
+
+void packet_slab_free(struct Packet_Slab* slab) {
+    for (int i = 0; i < slab->chunk_count; i++) {
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    slab->chunks = NULL;
+    slab->chunk_count = 0;
+    pthread_mutex_destroy(&slab->lock);
+}
+
+/**
+ * Packet slab alloc
+ * Desc: Takes a free slot, adding a chunk if there are none. The slot comes
+ *       back empty with one reference held by the caller, who fills in the
+ *       frame before handing the handle to anyone else.
+ *
+ * Returns: handle of the slot
+**/
+int packet_slab_alloc(struct Packet_Slab* slab) {
+    pthread_mutex_lock(&slab->lock);
+    if (slab->free_head == PACKET_NONE) {
+        if (slab->chunk_count == PACKET_SLAB_MAX_CHUNKS) {
+            printf("Packet slab full, %d packets held\n", slab->live);
+            exit(0);
+        }
+        struct Packet_Slot* chunk = malloc(sizeof(struct Packet_Slot) * PACKET_SLAB_CHUNK);
+        if (chunk == NULL) {
+            printf("Packet slab memory allocation error\n");
+            exit(0);
+        }
+        // Thread the new slots onto the free list in handle order
+        int first = slab->chunk_count * PACKET_SLAB_CHUNK;
+        for (int i = 0; i < PACKET_SLAB_CHUNK; i++) {
+            chunk[i].refs = 0;
+            chunk[i].next_free = i + 1 < PACKET_SLAB_CHUNK ? first + i + 1 : PACKET_NONE;
+        }
+        slab->chunks[slab->chunk_count++] = chunk;
+        slab->free_head = first;
+    }
+    int handle = slab->free_head;
+    struct Packet_Slot* slot = packet_slot(slab, handle);
+    slab->free_head = slot->next_free;
+    slab->live++;
+    pthread_mutex_unlock(&slab->lock);
+
+    slot->refs = 1;
+    slot->length = 0;
+    return handle;
+}
+
+// Copies an already encoded frame into a new slot, returns its handle
+int packet_slab_store(struct Packet_Slab* slab, const unsigned char* frame, int length) {
+    int handle = packet_slab_alloc(slab);
+    struct Packet_Slot* slot = packet_slot(slab, handle);
+    memcpy(slot->frame, frame, length);
+    slot->length = length;
+    return handle;
+}
+
+void packet_ref(struct Packet_Slab* slab, int handle) {
+    if (handle != PACKET_NONE) {
+        __atomic_fetch_add(&packet_slot(slab, handle)->refs, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Drops a reference, the slot goes back on the free list with the last one
+void packet_unref(struct Packet_Slab* slab, int handle) {
+    if (handle == PACKET_NONE) {
+        return;
+    }
+    struct Packet_Slot* slot = packet_slot(slab, handle);
+    if (__atomic_sub_fetch(&slot->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&slab->lock);
+        slot->next_free = slab->free_head;
+        slab->free_head = handle;
+        slab->live--;
+        pthread_mutex_unlock(&slab->lock);
+    }
+}
+
+// Decodes the frame in place, only the header unless full is set. Returns
+// -1 for PACKET_NONE or a bad frame
+int packet_read(struct Packet_Slab* slab, int handle, struct Packet* packet, int full) {
+    if (handle == PACKET_NONE) {
+        packet->type = PACKET_TYPE_NONE;
+        return -1;
+    }
+    struct Packet_Slot* slot = packet_slot(slab, handle);
+    return full ? packet_decode(slot->frame, slot->length, packet)
+                : packet_decode_header(slot->frame, slot->length, packet);
+}
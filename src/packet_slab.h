@@ -0,0 +1,49 @@
+/**
+ * @file    packet_slab.h
+ * @brief   Reference counted storage for encoded packet frames
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <pthread.h>
+#include "packet.h"
+
+#ifndef packet_slab_H
+#define packet_slab_H
+
+// Slots come in fixed chunks that never move, so a handle stays valid while
+// other threads grow the slab
+#define PACKET_SLAB_CHUNK           256
+#define PACKET_SLAB_MAX_CHUNKS      4096
+#define PACKET_NONE                 -1
+
+// One published frame, never written again until its last reference goes
+struct Packet_Slot {
+    int refs;
+    int length;
+    int next_free;
+    unsigned char frame[PACKET_MAX_SIZE];
+};
+
+struct Packet_Slab {
+    struct Packet_Slot** chunks;
+    int chunk_count;
+    int free_head;
+    int live;
+    pthread_mutex_t lock;
+};
+
+static inline struct Packet_Slot* packet_slot(struct Packet_Slab* slab, int handle) {
+    return &slab->chunks[handle / PACKET_SLAB_CHUNK][handle % PACKET_SLAB_CHUNK];
+}
+
+int packet_slab_init(struct Packet_Slab* slab);
+void packet_slab_free(struct Packet_Slab* slab);
+int packet_slab_alloc(struct Packet_Slab* slab);
+int packet_slab_store(struct Packet_Slab* slab, const unsigned char* frame, int length);
+void packet_ref(struct Packet_Slab* slab, int handle);
+void packet_unref(struct Packet_Slab* slab, int handle);
+int packet_read(struct Packet_Slab* slab, int handle, struct Packet* packet, int full);
+
+#endif
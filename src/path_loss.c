@@ -0,0 +1,161 @@
+/**
+ * @file    path_loss.c
+ * @brief   Batched free space path loss with a fast log kernel
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "path_loss.h"
+#include "simulation.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define LN2         0.69314718055994530942
+#define SQRT2       1.41421356237309504880
+
+int initialize_path_loss(struct Simulation* sim) {
+    sim->path_loss.constant = malloc(sizeof(double) * sim->settings.channels);
+    if (sim->path_loss.constant == NULL) {
+        printf("Path loss memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < sim->settings.channels; i++) {
+        sim->path_loss.constant[i] = 20 * log(PATH_LOSS_FREQUENCY) + 32.44;
+    }
+    return 0;
+}
+
+int free_path_loss(struct Simulation* sim) {
+    free(sim->path_loss.constant);
+    sim->path_loss.constant = NULL;
+    return 0;
+}
+
+// Reference loss in dB at distance, what update_signal() has always used
+double path_loss_exact(double distance) {
+    return 20 * log(distance) + 20 * log(PATH_LOSS_FREQUENCY) + 32.44;
+}
+
+/**
+ * Fast log
+ * Desc: x = 2^e * m with m in [sqrt(1/2), sqrt(2)), then log(m) from the
+ *       series 2 * atanh(s), s = (m - 1) / (m + 1), up to s^9. |s| < 0.172
+ *       so the rest of the series is under 7e-10. Only for positive normal
+ *       x, which squared distances between nodes that aren't on top of each
+ *       other always are.
+**/
+static inline double fast_log(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    double e = (double)((int)((bits >> 52) & 0x7ff) - 1023);
+    bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > SQRT2) {
+        m *= 0.5;
+        e += 1;
+    }
+    double s = (m - 1) / (m + 1);
+    double s2 = s * s;
+    return e * LN2 + 2 * s * (1 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 + s2 * (1.0 / 9)))));
+}
+
+/**
+ * Path loss fast
+ * Desc: loss[i] = 20 * log(distance) + constant for count squared
+ *       distances, as 10 * log(distance^2) so there's no square root. Within
+ *       PATH_LOSS_MAX_ERROR dB of the exact loss, nodes at the same point
+ *       get -inf like log(0) gives.
+**/
+void path_loss_fast(const double* distance_squared, double* loss, int count, double constant) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i v_mantissa = _mm256_set1_epi64x(0x000fffffffffffffll);
+    const __m256i v_one_bits = _mm256_set1_epi64x(0x3ff0000000000000ll);
+    // Exponent field as the low bits of 2^52, so it converts without cvtepi64
+    const __m256i v_magic_bits = _mm256_set1_epi64x(0x4330000000000000ll);
+    const __m256d v_magic = _mm256_set1_pd(4503599627370496.0 + 1023);
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_half = _mm256_set1_pd(0.5);
+    const __m256d v_sqrt2 = _mm256_set1_pd(SQRT2);
+    const __m256d v_ln2 = _mm256_set1_pd(LN2);
+    const __m256d v_ten = _mm256_set1_pd(10.0);
+    const __m256d v_constant = _mm256_set1_pd(constant);
+    const __m256d v_zero = _mm256_setzero_pd();
+    const __m256d v_minus_inf = _mm256_set1_pd(-INFINITY);
+    for (; i + 4 <= count; i += 4) {
+        __m256d v_x = _mm256_loadu_pd(distance_squared + i);
+        __m256i v_bits = _mm256_castpd_si256(v_x);
+        __m256d v_e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(v_bits, 52),
+                                                                         v_magic_bits)), v_magic);
+        __m256d v_m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(v_bits, v_mantissa), v_one_bits));
+        __m256d v_big = _mm256_cmp_pd(v_m, v_sqrt2, _CMP_GT_OQ);
+        v_m = _mm256_blendv_pd(v_m, _mm256_mul_pd(v_m, v_half), v_big);
+        v_e = _mm256_add_pd(v_e, _mm256_and_pd(v_big, v_one));
+
+        __m256d v_s = _mm256_div_pd(_mm256_sub_pd(v_m, v_one), _mm256_add_pd(v_m, v_one));
+        __m256d v_s2 = _mm256_mul_pd(v_s, v_s);
+        __m256d v_poly = _mm256_add_pd(_mm256_set1_pd(1.0 / 7), _mm256_mul_pd(v_s2, _mm256_set1_pd(1.0 / 9)));
+        v_poly = _mm256_add_pd(_mm256_set1_pd(1.0 / 5), _mm256_mul_pd(v_s2, v_poly));
+        v_poly = _mm256_add_pd(_mm256_set1_pd(1.0 / 3), _mm256_mul_pd(v_s2, v_poly));
+        v_poly = _mm256_add_pd(v_one, _mm256_mul_pd(v_s2, v_poly));
+        __m256d v_log = _mm256_add_pd(_mm256_mul_pd(v_e, v_ln2),
+                                      _mm256_mul_pd(_mm256_add_pd(v_s, v_s), v_poly));
+
+        v_log = _mm256_blendv_pd(v_log, v_minus_inf, _mm256_cmp_pd(v_x, v_zero, _CMP_EQ_OQ));
+        _mm256_storeu_pd(loss + i, _mm256_add_pd(_mm256_mul_pd(v_ten, v_log), v_constant));
+    }
+#endif
+    for (; i < count; i++) {
+        double log_x = distance_squared[i] == 0 ? -INFINITY : fast_log(distance_squared[i]);
+        loss[i] = 10 * log_x + constant;
+    }
+}
+
+static inline double distance_squared(struct Simulation* sim, int a, int b) {
+    double dx = NODE_KIN(sim, a, x_pos) - NODE_KIN(sim, b, x_pos);
+    double dy = NODE_KIN(sim, a, y_pos) - NODE_KIN(sim, b, y_pos);
+    double dz = NODE_KIN(sim, a, z_pos) - NODE_KIN(sim, b, z_pos);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Received power at receiver from each of count transmitters on channel
+void signal_batch_to(struct Simulation* sim, int receiver, int channel, const int* transmitters, int count,
+                     double* signals) {
+    double distances[PATH_LOSS_BATCH];
+    double loss[PATH_LOSS_BATCH];
+    for (int start = 0; start < count; start += PATH_LOSS_BATCH) {
+        int chunk = count - start < PATH_LOSS_BATCH ? count - start : PATH_LOSS_BATCH;
+        for (int i = 0; i < chunk; i++) {
+            distances[i] = distance_squared(sim, receiver, transmitters[start + i]);
+        }
+        path_loss_fast(distances, loss, chunk, sim->path_loss.constant[channel]);
+        for (int i = 0; i < chunk; i++) {
+            signals[start + i] = sim->nodes[transmitters[start + i]].power_output - loss[i];
+        }
+    }
+}
+
+// Received power at each of count receivers from one transmitter on channel
+void signal_batch_from(struct Simulation* sim, int transmitter, int channel, const int* receivers, int count,
+                       double* signals) {
+    double distances[PATH_LOSS_BATCH];
+    double loss[PATH_LOSS_BATCH];
+    double power = sim->nodes[transmitter].power_output;
+    for (int start = 0; start < count; start += PATH_LOSS_BATCH) {
+        int chunk = count - start < PATH_LOSS_BATCH ? count - start : PATH_LOSS_BATCH;
+        for (int i = 0; i < chunk; i++) {
+            distances[i] = distance_squared(sim, transmitter, receivers[start + i]);
+        }
+        path_loss_fast(distances, loss, chunk, sim->path_loss.constant[channel]);
+        for (int i = 0; i < chunk; i++) {
+            signals[start + i] = power - loss[i];
+        }
+    }
+}
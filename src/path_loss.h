@@ -0,0 +1,38 @@
+/**
+ * @file    path_loss.h
+ * @brief   Batched free space path loss with a fast log kernel
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#ifndef path_loss_H
+#define path_loss_H
+
+// Nodes handled per kernel call, callers with more go in chunks
+#define PATH_LOSS_BATCH         64
+
+// Every channel is modelled at the same frequency for now
+#define PATH_LOSS_FREQUENCY     2400
+
+// Worst case error of path_loss_fast() against 20 * log(distance), in dB
+#define PATH_LOSS_MAX_ERROR     1e-7
+
+struct Simulation;
+
+// Frequency dependent part of the loss for each channel,
+// 20 * log(frequency) + 32.44
+struct Path_Loss {
+    double* constant;
+};
+
+int initialize_path_loss(struct Simulation* sim);
+int free_path_loss(struct Simulation* sim);
+double path_loss_exact(double distance);
+void path_loss_fast(const double* distance_squared, double* loss, int count, double constant);
+void signal_batch_to(struct Simulation* sim, int receiver, int channel, const int* transmitters, int count,
+                     double* signals);
+void signal_batch_from(struct Simulation* sim, int transmitter, int channel, const int* receivers, int count,
+                       double* signals);
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file    profile.c
+ * @brief   Tick phase and MCU function timers, built in with make PROFILE=1
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <math.h>
+#include <string.h>
+#include "profile.h"
+#include "simulation.h"
+
+#ifdef PROFILE
+static const char* phase_names[PROFILE_PHASES] = {
+    "acceleration", "velocity", "position", "mcu", "channels", "ground", "output", "sync"
+};
+#endif
+
+// Seconds per profile clock tick, measured over the run so far
+static double profile_seconds_per_tick(struct Profile* profile) {
+    struct timespec now;
+    uint64_t ticks = profile_ticks();
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - profile->start_time.tv_sec) +
+                     (now.tv_nsec - profile->start_time.tv_nsec) / 1e9;
+    if (ticks <= profile->start_ticks || elapsed <= 0) {
+        return 1e-9;
+    }
+    return elapsed / (ticks - profile->start_ticks);
+}
+
+/**
+ * Profile init
+ * Desc: Starts the profile clock and opens profile_csv if one is set. The
+ *       CSV gets a row every profile_interval simulated seconds with the
+ *       cycles run and seconds spent in each phase since the last row.
+**/
+int profile_init(struct Simulation* sim) {
+    struct Profile* profile = &sim->profile;
+    memset(profile, 0, sizeof(*profile));
+    clock_gettime(CLOCK_MONOTONIC, &profile->start_time);
+    profile->start_ticks = profile_ticks();
+
+    if (sim->settings.profile_csv == NULL) {
+        return 0;
+    }
+#ifdef PROFILE
+    profile->csv = fopen(sim->settings.profile_csv, "w");
+    if (profile->csv == NULL) {
+        fprintf(stderr, "Unable to open profile CSV \"%s\"\n", sim->settings.profile_csv);
+        return 1;
+    }
+    profile->csv_interval = sim->settings.profile_interval > 0 ? sim->settings.profile_interval : 1.0;
+    profile->next_row = sim->state.current_time + profile->csv_interval;
+    profile->row_cycle = sim->state.current_cycle;
+    fprintf(profile->csv, "time,cycles");
+    for (int i = 0; i < PROFILE_PHASES; i++) {
+        fprintf(profile->csv, ",%s", phase_names[i]);
+    }
+    fprintf(profile->csv, "\n");
+#else
+    fprintf(stderr, "profile_csv needs a build with make PROFILE=1, ignoring it\n");
+#endif
+    return 0;
+}
+
+void profile_step(struct Simulation* sim) {
+    struct Profile* profile = &sim->profile;
+    if (profile->csv == NULL || sim->state.current_time < profile->next_row) {
+        return;
+    }
+
+    double seconds_per_tick = profile_seconds_per_tick(profile);
+    fprintf(profile->csv, "%f,%lu", sim->state.current_time, sim->state.current_cycle - profile->row_cycle);
+    for (int i = 0; i < PROFILE_PHASES; i++) {
+        fprintf(profile->csv, ",%.6f", (profile->phase_ticks[i] - profile->row_ticks[i]) * seconds_per_tick);
+        profile->row_ticks[i] = profile->phase_ticks[i];
+    }
+    fprintf(profile->csv, "\n");
+    profile->row_cycle = sim->state.current_cycle;
+
+    // The event engine can jump past several rows at once
+    profile->next_row = (floor(sim->state.current_time / profile->csv_interval) + 1) * profile->csv_interval;
+}
+
+// Phase and MCU function table, does nothing in builds without PROFILE
+void profile_print(struct Simulation* sim) {
+#ifdef PROFILE
+    struct Profile* profile = &sim->profile;
+    double seconds_per_tick = profile_seconds_per_tick(profile);
+    uint64_t total = 0;
+    for (int i = 0; i < PROFILE_PHASES; i++) {
+        total += profile->phase_ticks[i];
+    }
+
+    printf("Profile\n");
+    printf("%-26s %12s %12s %8s %14s\n", "Phase", "Calls", "Seconds", "Share", "us/call");
+    for (int i = 0; i < PROFILE_PHASES; i++) {
+        if (profile->phase_calls[i] == 0) {
+            continue;
+        }
+        double seconds = profile->phase_ticks[i] * seconds_per_tick;
+        printf("%-26s %12lu %12.6f %7.2f%% %14.3f\n", phase_names[i], profile->phase_calls[i], seconds,
+               total > 0 ? 100.0 * profile->phase_ticks[i] / total : 0,
+               1e6 * seconds / profile->phase_calls[i]);
+    }
+    printf("%-26s %12s %12s %8s %14s\n", "MCU function", "Calls", "Seconds", "Share", "us/call");
+    uint64_t functions = 0;
+    for (int i = 0; i < MCU_FUNCTION_COUNT; i++) {
+        functions += profile->function_ticks[i];
+    }
+    for (int i = 0; i < MCU_FUNCTION_COUNT; i++) {
+        if (profile->function_calls[i] == 0) {
+            continue;
+        }
+        double seconds = profile->function_ticks[i] * seconds_per_tick;
+        printf("%-26s %12lu %12.6f %7.2f%% %14.3f\n", mcu_function_table[i].name, profile->function_calls[i],
+               seconds, functions > 0 ? 100.0 * profile->function_ticks[i] / functions : 0,
+               1e6 * seconds / profile->function_calls[i]);
+    }
+#else
+    (void)sim;
+#endif
+}
+
+void profile_free(struct Simulation* sim) {
+    if (sim->profile.csv != NULL) {
+        fclose(sim->profile.csv);
+        sim->profile.csv = NULL;
+    }
+}
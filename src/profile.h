@@ -0,0 +1,99 @@
+/**
+ * @file    profile.h
+ * @brief   Tick phase and MCU function timers, built in with make PROFILE=1
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "mcu_emulation.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef profile_H
+#define profile_H
+
+// Tick phases, with pthreads the kinematics and MCU phases are worker 0's
+// slice and sync is worker 0 waiting on the others
+#define PROFILE_ACCELERATION    0
+#define PROFILE_VELOCITY        1
+#define PROFILE_POSITION        2
+#define PROFILE_MCU             3
+#define PROFILE_CHANNELS        4
+#define PROFILE_GROUND          5
+#define PROFILE_OUTPUT          6
+#define PROFILE_SYNC            7
+#define PROFILE_PHASES          8
+
+// Accumulated ticks of the profile clock, see profile_seconds()
+struct Profile {
+    uint64_t phase_ticks[PROFILE_PHASES];
+    unsigned long phase_calls[PROFILE_PHASES];
+    uint64_t function_ticks[MCU_FUNCTION_COUNT];
+    unsigned long function_calls[MCU_FUNCTION_COUNT];
+    // Profile clock against the monotonic clock, for converting ticks
+    uint64_t start_ticks;
+    struct timespec start_time;
+    // Per interval CSV
+    FILE* csv;
+    double csv_interval;
+    double next_row;
+    uint64_t row_ticks[PROFILE_PHASES];
+    unsigned long row_cycle;
+};
+
+// Time stamp counter where there is one, nanoseconds otherwise
+static inline uint64_t profile_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+/**
+ * Timer macros, all of them compile to nothing without PROFILE so the hot
+ * path doesn't pay for them in normal builds
+ *  PROFILE_BEGIN(t)                  start a timer named t
+ *  PROFILE_PHASE(sim, phase, t)      add the time since t to a phase
+ *  PROFILE_FUNCTION(sim, number, t)  add the time since t to an MCU function,
+ *                                    safe from worker threads
+ *  PROFILE_STEP(sim)                 end of a step, writes CSV rows
+**/
+#ifdef PROFILE
+#define PROFILE_BEGIN(t)                    uint64_t t = profile_ticks()
+#define PROFILE_PHASE(sim, phase, t)        profile_add_phase(&(sim)->profile, (phase), (t))
+#define PROFILE_FUNCTION(sim, number, t)    profile_add_function(&(sim)->profile, (number), (t))
+#define PROFILE_STEP(sim)                   profile_step(sim)
+
+static inline void profile_add_phase(struct Profile* profile, int phase, uint64_t start) {
+    profile->phase_ticks[phase] += profile_ticks() - start;
+    profile->phase_calls[phase]++;
+}
+
+static inline void profile_add_function(struct Profile* profile, int number, uint64_t start) {
+    __atomic_fetch_add(&profile->function_ticks[number], profile_ticks() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile->function_calls[number], 1, __ATOMIC_RELAXED);
+}
+#else
+#define PROFILE_BEGIN(t)
+#define PROFILE_PHASE(sim, phase, t)
+#define PROFILE_FUNCTION(sim, number, t)
+#define PROFILE_STEP(sim)
+#endif
+
+struct Simulation;
+
+int profile_init(struct Simulation* sim);
+void profile_step(struct Simulation* sim);
+void profile_print(struct Simulation* sim);
+void profile_free(struct Simulation* sim);
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file    rng.c
+ * @brief   Counter-based random number streams (Philox4x32-10)
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "rng.h"
+#include "simulation.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define PHILOX_M0       0xD2511F53u
+#define PHILOX_M1       0xCD9E8D57u
+#define PHILOX_W0       0x9E3779B9u
+#define PHILOX_W1       0xBB67AE85u
+#define PHILOX_ROUNDS   10
+
+int initialize_rng(struct RNG* rng, int seed) {
+    rng->key[0] = (uint32_t)seed;
+    rng->key[1] = 0x5DEECE66u;
+    return 0;
+}
+
+/**
+ * Philox4x32-10
+ * Desc: Every draw is a pure function of (seed, node, tick, purpose), so
+ *       it doesn't matter which order, thread or engine asks for it
+**/
+static inline void philox(const struct RNG* rng, uint32_t ctr[4], uint32_t out[4]) {
+    uint32_t k0 = rng->key[0];
+    uint32_t k1 = rng->key[1];
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    for (int i = 0; i < PHILOX_ROUNDS; i++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void rng_block(const struct RNG* rng, struct RNG_Block* out, int node, unsigned long tick, int purpose) {
+    uint32_t ctr[4] = {(uint32_t)tick, (uint32_t)((uint64_t)tick >> 32), (uint32_t)node, (uint32_t)purpose};
+    philox(rng, ctr, out->v);
+}
+
+#if defined(__AVX2__)
+// 32x32 bit products of eight lanes, split into low and high halves
+static inline void philox_mul(__m256i a, __m256i m, __m256i* lo, __m256i* hi) {
+    __m256i even = _mm256_mul_epu32(a, m);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+#endif
+
+/**
+ * RNG block batch
+ * Desc: Blocks for count consecutive nodes starting at node_start, the same
+ *       draws rng_block() gives. With AVX2 eight nodes go through the
+ *       rounds together, one per 32 bit lane.
+**/
+void rng_block_batch(const struct RNG* rng, struct RNG_Block* out, int node_start, int count, 
+                     unsigned long tick, int purpose) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i v_m0 = _mm256_set1_epi32((int)PHILOX_M0);
+    const __m256i v_m1 = _mm256_set1_epi32((int)PHILOX_M1);
+    const __m256i v_lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (; i + 8 <= count; i += 8) {
+        __m256i c0 = _mm256_set1_epi32((int)(uint32_t)tick);
+        __m256i c1 = _mm256_set1_epi32((int)(uint32_t)((uint64_t)tick >> 32));
+        __m256i c2 = _mm256_add_epi32(_mm256_set1_epi32(node_start + i), v_lanes);
+        __m256i c3 = _mm256_set1_epi32(purpose);
+        uint32_t k0 = rng->key[0];
+        uint32_t k1 = rng->key[1];
+        for (int r = 0; r < PHILOX_ROUNDS; r++) {
+            __m256i lo0, hi0, lo1, hi1;
+            philox_mul(c0, v_m0, &lo0, &hi0);
+            philox_mul(c2, v_m1, &lo1, &hi1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+            c1 = lo1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        uint32_t lanes[4][8];
+        _mm256_storeu_si256((__m256i*)lanes[0], c0);
+        _mm256_storeu_si256((__m256i*)lanes[1], c1);
+        _mm256_storeu_si256((__m256i*)lanes[2], c2);
+        _mm256_storeu_si256((__m256i*)lanes[3], c3);
+        for (int j = 0; j < 8; j++) {
+            out[i + j].v[0] = lanes[0][j];
+            out[i + j].v[1] = lanes[1][j];
+            out[i + j].v[2] = lanes[2][j];
+            out[i + j].v[3] = lanes[3][j];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        rng_block(rng, &out[i], node_start + i, tick, purpose);
+    }
+}
+
+// Single draw for a node on the current cycle
+uint32_t node_rand(struct Simulation* sim, int node, int purpose) {
+    struct RNG_Block block;
+    rng_block(&sim->rng, &block, node, sim->state.current_cycle, purpose);
+    return block.v[0];
+}
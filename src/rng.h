@@ -0,0 +1,39 @@
+/**
+ * @file    rng.h
+ * @brief   Counter-based random number streams (Philox4x32-10)
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+
+#ifndef rng_H
+#define rng_H
+
+// What a draw is used for, each purpose gets its own stream per node per tick
+#define RNG_PURPOSE_DRAG            0
+#define RNG_PURPOSE_ACCELERATION    1
+#define RNG_PURPOSE_CHANNEL         2
+#define RNG_PURPOSE_ROLE            3
+#define RNG_PURPOSE_WAIT            4
+
+// Four independent 32 bit draws
+struct RNG_Block {
+    uint32_t v[4];
+};
+
+// Philox key, derived from the seed
+struct RNG {
+    uint32_t key[2];
+};
+
+struct Simulation;
+
+int initialize_rng(struct RNG* rng, int seed);
+void rng_block(const struct RNG* rng, struct RNG_Block* out, int node, unsigned long tick, int purpose);
+void rng_block_batch(const struct RNG* rng, struct RNG_Block* out, int node_start, int count, 
+                     unsigned long tick, int purpose);
+uint32_t node_rand(struct Simulation* sim, int node, int purpose);
+
+#endif
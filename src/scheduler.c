@@ -0,0 +1,261 @@
+/**
+ * @file    scheduler.c
+ * @brief   Discrete-event scheduler for dynamic wireless network simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <limits.h>
+#include "file_output.h"
+#include "mcu_emulation.h"
+#include "scheduler.h"
+#include "simulation.h"
+#include "state.h"
+
+/**
+ * Scheduler initialization
+ * Desc: Every node MCU is due on the first tick of the simulation, except
+ *       ones restored from a checkpoint part way through a busy time or wait
+**/
+int initialize_scheduler(struct Simulation* sim) {
+    struct Event_Queue* event_queue = &sim->event_queue;
+
+    event_queue->size = 0;
+    event_queue->capacity = sim->settings.node_count;
+    event_queue->cycle = malloc(sizeof(unsigned long) * event_queue->capacity);
+    event_queue->node = malloc(sizeof(int) * event_queue->capacity);
+    event_queue->position = malloc(sizeof(int) * event_queue->capacity);
+    event_queue->ready = malloc(sizeof(int) * event_queue->capacity);
+    event_queue->ready_next = malloc(sizeof(int) * event_queue->capacity);
+    if (event_queue->cycle == NULL || event_queue->node == NULL || event_queue->position == NULL ||
+        event_queue->ready == NULL || event_queue->ready_next == NULL) {
+        printf("Scheduler memory allocation error\n");
+        exit(0);
+    }
+
+    event_queue->ready_count = 0;
+    event_queue->ready_next_count = 0;
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        event_queue->position[i] = -1;
+        if (sim->nodes[i].wake_cycle > sim->state.current_cycle + 1) {
+            event_queue_push(event_queue, sim->nodes[i].wake_cycle, i);
+        }
+        else {
+            event_queue->ready[event_queue->ready_count++] = i;
+        }
+    }
+    return 0;
+}
+
+// Frees the event queue arrays, the queue itself belongs to the simulation
+int free_scheduler(struct Event_Queue* queue) {
+    free(queue->cycle);
+    free(queue->node);
+    free(queue->position);
+    free(queue->ready);
+    free(queue->ready_next);
+    return 0;
+}
+
+/**
+ * Event driven clock tick
+ * Desc: Jumps simulated time to the next cycle where any node MCU is due.
+ *       Node wake-ups are the only events: transmit start/stop and cycle timer
+ *       expirations only ever happen inside a node's own MCU function, so they
+ *       are covered by its wake-up. Skipped ticks still count as cycles and
+ *       every one applies its own random acceleration change, so each node
+ *       still takes one draw per tick. They're integrated as one span per
+ *       node with no MCU or channel scanning, and ground collisions are
+ *       added once for the span. With sinr, a receiver_sensitivity cutoff
+ *       or debug output the ground (or the printing) needs positions every
+ *       tick, so those runs still step the skipped ticks one at a time.
+ *
+ *       Listening nodes don't poll a quiet channel, they wait in the heap
+ *       until their timer runs out and a transmitter starting moves them up
+ *       to the next cycle (see channel_wait()). Between transmissions most
+ *       nodes are waiting, asleep or busy, which is where the spans come from.
+**/
+int event_tick(struct Simulation* sim) {
+    struct Node* nodes = sim->nodes;
+    struct Event_Queue* event_queue = &sim->event_queue;
+    unsigned long next_cycle = ULONG_MAX;
+    if (event_queue->ready_count > 0) {
+        next_cycle = sim->state.current_cycle + 1;
+    }
+    else if (event_queue->size > 0) {
+        next_cycle = event_queue->cycle[0];
+    }
+
+    // No transmitter changes while skipping, so ground only counts collisions
+    // (or decodes each cycle with sinr or a range cutoff)
+    if (sim->state.current_cycle + 1 < next_cycle) {
+        int collision_channels = ground_collision_channels(sim);
+        int per_tick = sim->interference.enabled || sim->grid.enabled || sim->settings.debug > 1;
+        while (sim->state.current_cycle + 1 < next_cycle) {
+            if (per_tick) {
+                clock_advance(sim);
+                if (sim->interference.enabled || sim->grid.enabled) {
+                    // Capture and range at the ground change as nodes move
+                    update_ground(sim);
+                }
+                else {
+                    sim->ground.collisions_detected += collision_channels;
+                }
+            }
+            else {
+                // Up to the tick before next_cycle, stopping where output is written
+                unsigned long ticks = next_cycle - 1 - sim->state.current_cycle;
+                if (sim->settings.output) {
+                    ticks = ticks_to_write_interval(sim, ticks);
+                }
+                ticks = clock_advance_span(sim, ticks);
+                sim->ground.collisions_detected += collision_channels * (int)ticks;
+            }
+            if (sim->settings.output) {
+                PROFILE_BEGIN(output);
+                check_write_interval(sim);
+                PROFILE_PHASE(sim, PROFILE_OUTPUT, output);
+            }
+            sim->state.moving_nodes = count_moving_nodes(sim);
+            if (sim->state.moving_nodes == 0) {
+                return 0;
+            }
+        }
+    }
+
+    // Run every node due this cycle in ascending id order, same as update_mcu,
+    // merging the ready list with heap entries for this cycle
+    clock_advance(sim);
+    PROFILE_BEGIN(mcu);
+    update_spatial_grid(sim);
+    update_neighbor_lists(sim);
+    int ready_index = 0;
+    event_queue->ready_next_count = 0;
+    while (1) {
+        int heap_due = event_queue->size > 0 && event_queue->cycle[0] == sim->state.current_cycle;
+        int id;
+        if (ready_index < event_queue->ready_count &&
+            (!heap_due || event_queue->ready[ready_index] < event_queue->node[0])) {
+            id = event_queue->ready[ready_index++];
+        }
+        else if (heap_due) {
+            id = event_queue_pop(event_queue);
+        }
+        else {
+            break;
+        }
+        mcu_run_function(sim, id);
+
+        if (nodes[id].wake_cycle > sim->state.current_cycle + 1) {
+            event_queue_push(event_queue, nodes[id].wake_cycle, id);
+        }
+        else {
+            event_queue->ready_next[event_queue->ready_next_count++] = id;
+        }
+    }
+
+    // Swap ready lists for the next cycle
+    int* tmp_ready = event_queue->ready;
+    event_queue->ready = event_queue->ready_next;
+    event_queue->ready_next = tmp_ready;
+    event_queue->ready_count = event_queue->ready_next_count;
+    event_queue->ready_next_count = 0;
+    PROFILE_PHASE(sim, PROFILE_MCU, mcu);
+
+    PROFILE_BEGIN(ground);
+    update_ground(sim);
+    PROFILE_PHASE(sim, PROFILE_GROUND, ground);
+
+    if (sim->settings.output) {
+        PROFILE_BEGIN(output);
+        check_write_interval(sim);
+        PROFILE_PHASE(sim, PROFILE_OUTPUT, output);
+    }
+    return 0;
+}
+
+// Compare two heap entries, earlier cycle first then lower node id
+static int event_before(struct Event_Queue* queue, int a, int b) {
+    if (queue->cycle[a] != queue->cycle[b]) {
+        return queue->cycle[a] < queue->cycle[b];
+    }
+    return queue->node[a] < queue->node[b];
+}
+
+static void event_swap(struct Event_Queue* queue, int a, int b) {
+    unsigned long tmp_cycle = queue->cycle[a];
+    int tmp_node = queue->node[a];
+    queue->cycle[a] = queue->cycle[b];
+    queue->node[a] = queue->node[b];
+    queue->cycle[b] = tmp_cycle;
+    queue->node[b] = tmp_node;
+    queue->position[queue->node[a]] = a;
+    queue->position[queue->node[b]] = b;
+}
+
+static void event_sift_up(struct Event_Queue* queue, int i) {
+    while (i > 0 && event_before(queue, i, (i - 1) / 2)) {
+        event_swap(queue, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void event_sift_down(struct Event_Queue* queue, int i) {
+    while (1) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        if (left < queue->size && event_before(queue, left, smallest)) {
+            smallest = left;
+        }
+        if (right < queue->size && event_before(queue, right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        event_swap(queue, i, smallest);
+        i = smallest;
+    }
+}
+
+void event_queue_push(struct Event_Queue* queue, unsigned long cycle, int node) {
+    if (queue->size == queue->capacity) {
+        printf("Event queue overflow\n");
+        exit(0);
+    }
+    int i = queue->size++;
+    queue->cycle[i] = cycle;
+    queue->node[i] = node;
+    queue->position[node] = i;
+    event_sift_up(queue, i);
+}
+
+int event_queue_pop(struct Event_Queue* queue) {
+    int node = queue->node[0];
+    event_queue_remove(queue, node);
+    return node;
+}
+
+// Take node's entry out of the heap wherever it is, used when a waiting node
+// is woken early
+int event_queue_remove(struct Event_Queue* queue, int node) {
+    int i = queue->position[node];
+    if (i < 0) {
+        return -1;
+    }
+    queue->position[node] = -1;
+    queue->size--;
+    if (i == queue->size) {
+        return 0;
+    }
+    // Last entry fills the gap, then moves whichever way it has to
+    int moved = queue->node[queue->size];
+    queue->cycle[i] = queue->cycle[queue->size];
+    queue->node[i] = moved;
+    queue->position[moved] = i;
+    event_sift_up(queue, i);
+    event_sift_down(queue, queue->position[moved]);
+    return 0;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file    scheduler.h
+ * @brief   Discrete-event scheduler for dynamic wireless network simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "node.h"
+#include "ground.h"
+
+#ifndef scheduler_H
+#define scheduler_H
+
+// Min-heap of node wake-up events ordered by (cycle, node id)
+// Nodes due on the very next cycle skip the heap and go in the ready list,
+// which stays in ascending id order since nodes are run in that order
+struct Event_Queue {
+    unsigned long* cycle;
+    int* node;
+    int* position;          // heap index of each node, -1 if not in the heap
+    int size;
+    int capacity;
+    int* ready;
+    int ready_count;
+    int* ready_next;
+    int ready_next_count;
+};
+
+struct Simulation;
+
+int initialize_scheduler(struct Simulation* sim);
+int free_scheduler(struct Event_Queue* queue);
+int event_tick(struct Simulation* sim);
+void event_queue_push(struct Event_Queue* queue, unsigned long cycle, int node);
+int event_queue_pop(struct Event_Queue* queue);
+int event_queue_remove(struct Event_Queue* queue, int node);
+
+#endif
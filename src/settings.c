@@ -8,37 +8,66 @@
 
 #include <ctype.h>
 #include <ini.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include "settings.h"
 
-extern struct Settings settings;
-
-void set_program_defaults() {
-    settings.node_count = 5;
-    settings.gravity = 9.80665;
-    settings.start_x = 0;
-    settings.start_y = 0;
-    settings.start_z = 30000;
-    settings.time_resolution = 0.001;
-    settings.terminal_velocity = 8.0;
-    settings.spread_factor = 20;
-    settings.default_power_output = 20;
-    settings.write_interval = 1.0;
-    settings.group_max = 5;
-    settings.random_seed = -1;
-    settings.debug = 0;
-    settings.verbose = 1;
-    settings.output = 0;
-    settings.channels = 16;
-    settings.broadcast_percentage = 20;
-    settings.output_dir = malloc(sizeof(char) * 50);
-    settings.use_pthreads = 0;
-    settings.use_timeslots = 1;
-    settings.group_cycle_interval = 20000;
-    settings.sensor_count = 0;
+void set_program_defaults(struct Settings* config) {
+    config->node_count = 5;
+    config->gravity = 9.80665;
+    config->start_x = 0;
+    config->start_y = 0;
+    config->start_z = 30000;
+    config->time_resolution = 0.001;
+    config->terminal_velocity = 8.0;
+    config->spread_factor = 20;
+    config->default_power_output = 20;
+    config->receiver_sensitivity = -INFINITY;
+    config->grid_cell_size = 0;
+    config->neighbor_skin = 0;
+    config->fast_path_loss = 0;
+    config->signal_store = 0;
+    config->signal_format = 0;
+    config->signal_peers = 32;
+    config->sinr = 0;
+    config->capture_threshold = 10;
+    config->noise_floor = -INFINITY;
+    config->write_interval = 1.0;
+    config->output_buffer_kb = 64;
+    config->max_open_files = 0;
+    config->output_format = 0;
+    config->trace_signals = 1;
+    config->output_async = 1;
+    config->output_queue_kb = 4096;
+    config->group_max = 5;
+    config->random_seed = -1;
+    config->debug = 0;
+    config->verbose = 1;
+    config->output = 0;
+    config->channels = 16;
+    config->broadcast_percentage = 20;
+    config->output_dir = NULL;
+    config->use_pthreads = 0;
+    config->thread_count = 0;
+    config->use_timeslots = 1;
+    config->engine = ENGINE_TICK;
+    config->sweep_parameters = NULL;
+    config->sweep_parameter_count = 0;
+    config->sweep_repeats = 1;
+    config->sweep_workers = 0;
+    config->sweep_threads = 1;
+    config->checkpoint_time = 0;
+    config->checkpoint_file = NULL;
+    config->restore_file = NULL;
+    config->profile_csv = NULL;
+    config->profile_interval = 1.0;
+    config->group_cycle_interval = 20000;
+    config->sensor_count = 0;
+    config->relay_queue_size = 64;
+    config->relay_overflow = 0;
 }
 
 int inih_handler(void* user, const char* section, const char* name,
@@ -57,14 +86,34 @@ int inih_handler(void* user, const char* section, const char* name,
         pconfig->broadcast_percentage = atoi(value);        
     } else if (MATCH("program", "use_pthreads")) {
         pconfig->use_pthreads = atoi(value);        
+    } else if (MATCH("program", "threads")) {
+        pconfig->thread_count = atoi(value);        
     } else if (MATCH("program", "use_timeslots")) {
         pconfig->use_timeslots = atoi(value);        
+    } else if (MATCH("program", "engine")) {
+        pconfig->engine = atoi(value);        
     } else if (MATCH("program", "seed")) {
         pconfig->random_seed = atoi(value);        
     } else if (MATCH("program", "group_cycle_interval")) {
         pconfig->group_cycle_interval = atoi(value);        
+    } else if (MATCH("program", "profile_csv")) {
+        pconfig->profile_csv = strdup(value);
+    } else if (MATCH("program", "profile_interval")) {
+        pconfig->profile_interval = atof(value);
     } else if (MATCH("file_output", "output")) {
         pconfig->output = atoi(value);        
+    } else if (MATCH("file_output", "buffer_kb")) {
+        pconfig->output_buffer_kb = atoi(value) > 0 ? atoi(value) : 1;
+    } else if (MATCH("file_output", "max_open_files")) {
+        pconfig->max_open_files = atoi(value);
+    } else if (MATCH("file_output", "format")) {
+        pconfig->output_format = atoi(value);
+    } else if (MATCH("file_output", "trace_signals")) {
+        pconfig->trace_signals = atoi(value);
+    } else if (MATCH("file_output", "async")) {
+        pconfig->output_async = atoi(value);
+    } else if (MATCH("file_output", "queue_kb")) {
+        pconfig->output_queue_kb = atoi(value) > 0 ? atoi(value) : 1;
     } else if (MATCH("file_output", "write_interval")) {
         pconfig->write_interval = atof(value);        
     } else if (MATCH("terminal_output", "verbose")) {
@@ -83,13 +132,38 @@ int inih_handler(void* user, const char* section, const char* name,
         pconfig->spread_factor = atof(value);        
     } else if (MATCH("nodes", "power_output")) {
         pconfig->default_power_output = atof(value);        
+    } else if (MATCH("nodes", "receiver_sensitivity")) {
+        pconfig->receiver_sensitivity = atof(value);
+    } else if (MATCH("nodes", "grid_cell_size")) {
+        pconfig->grid_cell_size = atof(value);
+    } else if (MATCH("nodes", "neighbor_skin")) {
+        pconfig->neighbor_skin = atof(value);
+    } else if (MATCH("nodes", "fast_path_loss")) {
+        pconfig->fast_path_loss = atoi(value);
+    } else if (MATCH("nodes", "signal_store")) {
+        pconfig->signal_store = atoi(value);
+    } else if (MATCH("nodes", "signal_format")) {
+        pconfig->signal_format = atoi(value);
+    } else if (MATCH("nodes", "signal_peers")) {
+        pconfig->signal_peers = atoi(value);
+    } else if (MATCH("nodes", "sinr")) {
+        pconfig->sinr = atoi(value);
+    } else if (MATCH("nodes", "capture_threshold")) {
+        pconfig->capture_threshold = atof(value);
+    } else if (MATCH("nodes", "noise_floor")) {
+        pconfig->noise_floor = atof(value);
     } else if (MATCH("nodes", "group_max")) {
         pconfig->group_max = atoi(value);        
     } else if (MATCH("nodes", "channels")) {
         pconfig->channels = atoi(value);   
     } else if (MATCH("nodes", "sensors")) {
         pconfig->sensor_count = atoi(value);  
-        pconfig->sensor_types = malloc(sizeof(int));
+        // Room for every [sensorN] section even if fewer sensors are used
+        pconfig->sensor_types = calloc(pconfig->sensor_count > 4 ? pconfig->sensor_count : 4, sizeof(int));
+    } else if (MATCH("nodes", "relay_queue_size")) {
+        pconfig->relay_queue_size = atoi(value) > 0 ? atoi(value) : 0;
+    } else if (MATCH("nodes", "relay_overflow")) {
+        pconfig->relay_overflow = atoi(value);
     } else if (MATCH("sensor1", "type")) {
         pconfig->sensor_types[0] = atoi(value); 
     } else if (MATCH("sensor2", "type")) {
@@ -98,61 +172,143 @@ int inih_handler(void* user, const char* section, const char* name,
         pconfig->sensor_types[2] = atoi(value);
     } else if (MATCH("sensor4", "type")) {
         pconfig->sensor_types[3] = atoi(value);        
+    } else if (MATCH("sweep", "parameter")) {
+        add_sweep_parameter(pconfig, value);
+    } else if (MATCH("sweep", "repeats")) {
+        pconfig->sweep_repeats = atoi(value);
+    } else if (MATCH("sweep", "workers")) {
+        pconfig->sweep_workers = atoi(value);
+    } else if (MATCH("sweep", "threads")) {
+        pconfig->sweep_threads = atoi(value);
+    } else if (MATCH("checkpoint", "time")) {
+        pconfig->checkpoint_time = atof(value);
+    } else if (MATCH("checkpoint", "save")) {
+        pconfig->checkpoint_file = strdup(value);
+    } else if (MATCH("checkpoint", "restore")) {
+        pconfig->restore_file = strdup(value);
     } else {
         return 0;  /* unknown section/name, error */
     }
     return 1;
 }
 
-void get_switches(int argc, char **argv) {
+/**
+ * Apply setting
+ * Desc: Sets a single field by its ini key, either "section.name" or just
+ *       "name" which is looked up in each settings section
+ *
+ * Return: 1 if the key was found, 0 otherwise
+**/
+int apply_setting(struct Settings* config, const char* name, const char* value) {
+    const char* sections[] = {"program", "file_output", "terminal_output", "nodes"};
+    const char* dot = strchr(name, '.');
+
+    if (dot != NULL) {
+        char section[64];
+        int length = dot - name;
+        if (length >= (int)sizeof(section)) {
+            return 0;
+        }
+        memcpy(section, name, length);
+        section[length] = '\0';
+        return inih_handler(config, section, dot + 1, value);
+    }
+
+    for (int i = 0; i < (int)(sizeof(sections) / sizeof(sections[0])); i++) {
+        if (inih_handler(config, sections[i], name, value)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Sweep parameters are kept as given ("name=start:end[:step]" or
+// "name=a,b,c") and expanded by the sweep runner
+int add_sweep_parameter(struct Settings* config, const char* spec) {
+    config->sweep_parameters = realloc(config->sweep_parameters,
+        sizeof(char*) * (config->sweep_parameter_count + 1));
+    config->sweep_parameters[config->sweep_parameter_count] = strdup(spec);
+    config->sweep_parameter_count++;
+
+    return 0;
+}
+
+void get_switches(struct Settings* config, int argc, char **argv) {
     int c;
-    while ((c = getopt(argc, argv, "d:v:c:g:r:z:t:s:e:p:o:m:b:i:l:")) != -1)
+    while ((c = getopt(argc, argv, "d:v:c:g:r:z:t:j:s:e:p:o:m:b:i:l:x:w:n:k:y:T:S:R:")) != -1)
     switch (c) {
         case 'd':
-            settings.debug = atoi(optarg);
+            config->debug = atoi(optarg);
             break;
         case 'v':
-            settings.verbose = atoi(optarg);
+            config->verbose = atoi(optarg);
             break;
         case 'c':
-            settings.node_count = atoi(optarg);
+            config->node_count = atoi(optarg);
             break;
         case 'g':
-            settings.gravity = atof(optarg);
+            config->gravity = atof(optarg);
             break;
         case 'r':
-            settings.time_resolution = atof(optarg);
+            config->time_resolution = atof(optarg);
             break;
         case 'z':
-            settings.start_z = atof(optarg);
+            config->start_z = atof(optarg);
             break;
         case 't':
-            settings.use_pthreads = atof(optarg);
+            config->use_pthreads = atof(optarg);
+            break;
+        case 'j':
+            config->thread_count = atoi(optarg);
             break;
         case 's': 
-            settings.spread_factor = atof(optarg);
+            config->spread_factor = atof(optarg);
             break;
         case 'e':
-            settings.random_seed = atoi(optarg);
+            config->random_seed = atoi(optarg);
             break;
         case 'p':
-            settings.default_power_output = atof(optarg);
+            config->default_power_output = atof(optarg);
             break;
         case 'o':
-            settings.output = atoi(optarg);
+            config->output = atoi(optarg);
             break;
         case 'm':
-            settings.group_max = atoi(optarg);
+            config->group_max = atoi(optarg);
             break;
         case 'b':
-            settings.broadcast_percentage = atoi(optarg);
+            config->broadcast_percentage = atoi(optarg);
             break;  
         case 'i':
-            settings.group_cycle_interval = atoi(optarg);
+            config->group_cycle_interval = atoi(optarg);
             break;     
         case 'l':
-            settings.use_timeslots = atoi(optarg);
+            config->use_timeslots = atoi(optarg);
             break;    
+        case 'x':
+            config->engine = atoi(optarg);
+            break;
+        case 'w':
+            add_sweep_parameter(config, optarg);
+            break;
+        case 'n':
+            config->sweep_repeats = atoi(optarg);
+            break;
+        case 'k':
+            config->sweep_workers = atoi(optarg);
+            break;
+        case 'y':
+            config->sweep_threads = atoi(optarg);
+            break;
+        case 'T':
+            config->checkpoint_time = atof(optarg);
+            break;
+        case 'S':
+            config->checkpoint_file = strdup(optarg);
+            break;
+        case 'R':
+            config->restore_file = strdup(optarg);
+            break;
         case '?':
             if (optopt == 'c')
                 fprintf (stderr, "Option -%c requires an argument.\n", optopt);
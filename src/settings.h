@@ -9,6 +9,12 @@
 #ifndef settings_H
 #define settings_H
 
+#define ENGINE_TICK     0
+#define ENGINE_EVENT    1
+
+#define OUTPUT_FORMAT_TEXT      0
+#define OUTPUT_FORMAT_TRACE     1
+
 // Struct for storing program settings
 struct Settings {
     int node_count;
@@ -21,7 +27,23 @@ struct Settings {
     double terminal_velocity;
     double spread_factor;
     double default_power_output;
+    double receiver_sensitivity;
+    double grid_cell_size;
+    double neighbor_skin;
+    int fast_path_loss;
+    int signal_store;
+    int signal_format;
+    int signal_peers;
+    int sinr;
+    double capture_threshold;
+    double noise_floor;
     double write_interval;
+    int output_buffer_kb;
+    int max_open_files;
+    int output_format;
+    int trace_signals;
+    int output_async;
+    int output_queue_kb;
     int group_max;
     int debug;
     int verbose;
@@ -30,15 +52,31 @@ struct Settings {
     int broadcast_percentage;
     char* output_dir;
     int use_pthreads;
+    int thread_count;
     int group_cycle_interval;
     int sensor_count;
     int* sensor_types;
+    int relay_queue_size;
+    int relay_overflow;
     int use_timeslots;
+    int engine;
+    char** sweep_parameters;
+    int sweep_parameter_count;
+    int sweep_repeats;
+    int sweep_workers;
+    int sweep_threads;
+    double checkpoint_time;
+    char* checkpoint_file;
+    char* restore_file;
+    char* profile_csv;
+    double profile_interval;
 };
 
-void set_program_defaults();
-void get_switches(int argc, char **argv);
+void set_program_defaults(struct Settings* config);
+void get_switches(struct Settings* config, int argc, char **argv);
 int inih_handler(void* user, const char* section, const char* name,
                    const char* value);
+int apply_setting(struct Settings* config, const char* name, const char* value);
+int add_sweep_parameter(struct Settings* config, const char* spec);
 
 #endif
\ No newline at end of file
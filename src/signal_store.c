@@ -0,0 +1,374 @@
+/**
+ * @file    signal_store.c
+ * @brief   Received signal strength storage with dense, triangular and sparse backends
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <math.h>
+#include <string.h>
+#include "signal_store.h"
+#include "simulation.h"
+
+static size_t format_size(int format) {
+    switch (format) {
+        case SIGNAL_FORMAT_FLOAT:
+            return sizeof(float);
+        case SIGNAL_FORMAT_INT16:
+            return sizeof(int16_t);
+        case SIGNAL_FORMAT_INT8:
+            return sizeof(int8_t);
+        default:
+            return sizeof(double);
+    }
+}
+
+static long quantize(const struct Signal_Store* store, double value, long low, long high) {
+    if (value == 0 || isnan(value)) {
+        return low;
+    }
+    double code = round((value - store->center) / store->step);
+    if (code <= low) {
+        return low + 1;
+    }
+    if (code > high) {
+        return high;
+    }
+    return (long)code;
+}
+
+// Values are read and written atomically, with the triangular layout both
+// ends of a pair can write the same one from different workers
+static void store_value(const struct Signal_Store* store, size_t index, double value) {
+    unsigned char* at = store->values + index * store->value_size;
+    switch (store->format) {
+        case SIGNAL_FORMAT_FLOAT: {
+            float stored = (float)value;
+            __atomic_store((float*)at, &stored, __ATOMIC_RELAXED);
+            break;
+        }
+        case SIGNAL_FORMAT_INT16: {
+            int16_t stored = (int16_t)quantize(store, value, INT16_MIN, INT16_MAX);
+            __atomic_store((int16_t*)at, &stored, __ATOMIC_RELAXED);
+            break;
+        }
+        case SIGNAL_FORMAT_INT8: {
+            // Top code is kept for signals over the LFG threshold
+            int8_t stored = (int8_t)quantize(store, value, INT8_MIN, INT8_MAX - 1);
+            if (stored != INT8_MIN && value > store->threshold) {
+                stored = INT8_MAX;
+            }
+            __atomic_store((int8_t*)at, &stored, __ATOMIC_RELAXED);
+            break;
+        }
+        default:
+            __atomic_store((double*)at, &value, __ATOMIC_RELAXED);
+            break;
+    }
+}
+
+// NAN for nothing stored
+static double load_value(const struct Signal_Store* store, size_t index) {
+    const unsigned char* at = store->values + index * store->value_size;
+    switch (store->format) {
+        case SIGNAL_FORMAT_FLOAT: {
+            float stored;
+            __atomic_load((const float*)at, &stored, __ATOMIC_RELAXED);
+            return stored;
+        }
+        case SIGNAL_FORMAT_INT16: {
+            int16_t stored;
+            __atomic_load((const int16_t*)at, &stored, __ATOMIC_RELAXED);
+            return stored == INT16_MIN ? NAN : store->center + stored * store->step;
+        }
+        case SIGNAL_FORMAT_INT8: {
+            int8_t stored;
+            __atomic_load((const int8_t*)at, &stored, __ATOMIC_RELAXED);
+            if (stored == INT8_MAX) {
+                stored = INT8_MAX - 1;
+            }
+            return stored == INT8_MIN ? NAN : store->center + stored * store->step;
+        }
+        default: {
+            double stored;
+            __atomic_load((const double*)at, &stored, __ATOMIC_RELAXED);
+            return stored;
+        }
+    }
+}
+
+// Packed upper triangle, row a holds pairs (a, b) for every b > a
+static size_t pair_index(int node_count, int a, int b) {
+    if (a > b) {
+        int swap = a;
+        a = b;
+        b = swap;
+    }
+    return (size_t)a * node_count - (size_t)a * (a + 1) / 2 + (b - a - 1);
+}
+
+static int peer_slot_hash(const struct Signal_Store* store, int peer) {
+    uint32_t hash = (uint32_t)peer * 2654435761u;
+    return (int)((hash ^ (hash >> 16)) & (uint32_t)(store->slots - 1));
+}
+
+// Slot peer is in for receiver, or -1
+static int sparse_find(const struct Signal_Store* store, int receiver, int peer) {
+    size_t base = (size_t)receiver * store->slots;
+    int slot = peer_slot_hash(store, peer);
+    while (store->peer[base + slot] != -1) {
+        if (store->peer[base + slot] == peer) {
+            return slot;
+        }
+        slot = (slot + 1) & (store->slots - 1);
+    }
+    return -1;
+}
+
+// Empties a slot, moving later entries of the probe run back into the gap
+static void sparse_remove(struct Signal_Store* store, int receiver, int slot) {
+    size_t base = (size_t)receiver * store->slots;
+    int mask = store->slots - 1;
+    int gap = slot;
+    int next = slot;
+    while (1) {
+        next = (next + 1) & mask;
+        if (store->peer[base + next] == -1) {
+            break;
+        }
+        int home = peer_slot_hash(store, store->peer[base + next]);
+        // Stays put if its home is cyclically after the gap, up to itself
+        int stays = gap <= next ? (home > gap && home <= next) : (home > gap || home <= next);
+        if (!stays) {
+            store->peer[base + gap] = store->peer[base + next];
+            store->heard[base + gap] = store->heard[base + next];
+            memcpy(store->values + (base + gap) * store->value_size,
+                   store->values + (base + next) * store->value_size, store->value_size);
+            gap = next;
+        }
+    }
+    store->peer[base + gap] = -1;
+    store->counts[receiver]--;
+}
+
+static void sparse_set(struct Simulation* sim, int receiver, int transmitter, double value) {
+    struct Signal_Store* store = &sim->signals;
+    size_t base = (size_t)receiver * store->slots;
+    int slot = sparse_find(store, receiver, transmitter);
+
+    if (slot == -1) {
+        if (store->counts[receiver] == store->peers) {
+            int oldest = -1;
+            for (int i = 0; i < store->slots; i++) {
+                if (store->peer[base + i] != -1 &&
+                    (oldest == -1 || store->heard[base + i] < store->heard[base + oldest])) {
+                    oldest = i;
+                }
+            }
+            sparse_remove(store, receiver, oldest);
+        }
+        slot = peer_slot_hash(store, transmitter);
+        while (store->peer[base + slot] != -1) {
+            slot = (slot + 1) & (store->slots - 1);
+        }
+        store->peer[base + slot] = transmitter;
+        store->counts[receiver]++;
+    }
+    store->heard[base + slot] = sim->state.current_cycle;
+    store_value(store, base + slot, value);
+}
+
+/**
+ * Initialize signal store
+ * Desc: Sets up the layout and format from the settings with nothing heard
+ *       yet, which reads as 0 from every pair
+**/
+int initialize_signal_store(struct Simulation* sim) {
+    struct Signal_Store* store = &sim->signals;
+    int n = sim->settings.node_count;
+    size_t count = 0;
+
+    memset(store, 0, sizeof(*store));
+    store->layout = sim->settings.signal_store;
+    store->format = sim->settings.signal_format;
+    store->node_count = n;
+    store->value_size = format_size(store->format);
+    store->center = store->format == SIGNAL_FORMAT_INT8 ? SIGNAL_INT8_CENTER : SIGNAL_INT16_CENTER;
+    store->step = store->format == SIGNAL_FORMAT_INT8 ? SIGNAL_INT8_STEP : SIGNAL_INT16_STEP;
+    store->threshold = SIGNAL_LFG_THRESHOLD;
+
+    switch (store->layout) {
+        case SIGNAL_STORE_TRIANGULAR:
+            count = n > 1 ? (size_t)n * (n - 1) / 2 : 1;
+            store->center -= sim->settings.default_power_output;
+            store->threshold -= sim->settings.default_power_output;
+            break;
+        case SIGNAL_STORE_SPARSE:
+            store->peers = sim->settings.signal_peers > 0 ? sim->settings.signal_peers : 1;
+            store->slots = 2;
+            while (store->slots < 2 * store->peers) {
+                store->slots <<= 1;
+            }
+            count = (size_t)n * store->slots;
+            store->peer = malloc(sizeof(int) * count);
+            store->heard = malloc(sizeof(unsigned long) * count);
+            store->counts = calloc(n > 0 ? n : 1, sizeof(int));
+            if (store->peer == NULL || store->heard == NULL || store->counts == NULL) {
+                printf("Signal store memory allocation error\n");
+                exit(0);
+            }
+            for (size_t i = 0; i < count; i++) {
+                store->peer[i] = -1;
+            }
+            break;
+        default:
+            store->layout = SIGNAL_STORE_DENSE;
+            count = (size_t)n * n;
+            break;
+    }
+
+    store->values = malloc(count > 0 ? count * store->value_size : 1);
+    if (store->values == NULL) {
+        printf("Signal store memory allocation error\n");
+        exit(0);
+    }
+    // Triangle entries can't use 0 for nothing stored, it's a real loss
+    // there, quantized formats store NAN as their nothing heard code. One
+    // value is stored and copied over the rest, doubling each time.
+    store_value(store, 0, store->layout == SIGNAL_STORE_TRIANGULAR ? NAN : 0);
+    size_t bytes = count * store->value_size;
+    for (size_t filled = store->value_size; filled < bytes; filled *= 2) {
+        memcpy(store->values + filled, store->values, filled < bytes - filled ? filled : bytes - filled);
+    }
+
+    if (sim->settings.verbose && (store->layout != SIGNAL_STORE_DENSE || store->format != SIGNAL_FORMAT_DOUBLE)) {
+        printf("Signal store: %f MB\n", signal_store_bytes(store) / 1048576.0);
+    }
+    return 0;
+}
+
+int free_signal_store(struct Simulation* sim) {
+    struct Signal_Store* store = &sim->signals;
+    free(store->values);
+    free(store->peer);
+    free(store->heard);
+    free(store->counts);
+    memset(store, 0, sizeof(*store));
+    return 0;
+}
+
+// Where the value receiver heard from transmitter is, 0 if it has no entry
+static int signal_index(struct Simulation* sim, int receiver, int transmitter, size_t* index) {
+    struct Signal_Store* store = &sim->signals;
+    switch (store->layout) {
+        case SIGNAL_STORE_TRIANGULAR:
+            if (receiver == transmitter) {
+                return 0;
+            }
+            *index = pair_index(store->node_count, receiver, transmitter);
+            return 1;
+        case SIGNAL_STORE_SPARSE: {
+            int slot = sparse_find(store, receiver, transmitter);
+            if (slot == -1) {
+                return 0;
+            }
+            *index = (size_t)receiver * store->slots + slot;
+            return 1;
+        }
+        default:
+            *index = (size_t)receiver * store->node_count + transmitter;
+            return 1;
+    }
+}
+
+// Last signal receiver heard from transmitter in dBm, 0 if none is stored
+double get_signal(struct Simulation* sim, int receiver, int transmitter) {
+    struct Signal_Store* store = &sim->signals;
+    size_t index;
+    if (!signal_index(sim, receiver, transmitter, &index)) {
+        return 0;
+    }
+    double value = load_value(store, index);
+    if (isnan(value)) {
+        return 0;
+    }
+    if (store->layout == SIGNAL_STORE_TRIANGULAR) {
+        return sim->nodes[transmitter].power_output + value;
+    }
+    return value;
+}
+
+// Whether the last signal receiver heard from transmitter beat
+// SIGNAL_LFG_THRESHOLD. Exact for int8 too, which saturates well below it
+int signal_over_threshold(struct Simulation* sim, int receiver, int transmitter) {
+    struct Signal_Store* store = &sim->signals;
+    size_t index;
+    if (store->format != SIGNAL_FORMAT_INT8) {
+        return get_signal(sim, receiver, transmitter) > SIGNAL_LFG_THRESHOLD;
+    }
+    if (!signal_index(sim, receiver, transmitter, &index)) {
+        return 0;
+    }
+    int8_t stored;
+    __atomic_load((const int8_t*)(store->values + index), &stored, __ATOMIC_RELAXED);
+    return stored == INT8_MAX;
+}
+
+void set_signal(struct Simulation* sim, int receiver, int transmitter, double value) {
+    struct Signal_Store* store = &sim->signals;
+    switch (store->layout) {
+        case SIGNAL_STORE_TRIANGULAR:
+            if (receiver != transmitter) {
+                store_value(store, pair_index(store->node_count, receiver, transmitter),
+                            value - sim->nodes[transmitter].power_output);
+            }
+            break;
+        case SIGNAL_STORE_SPARSE:
+            sparse_set(sim, receiver, transmitter, value);
+            break;
+        default:
+            store_value(store, (size_t)receiver * store->node_count + transmitter, value);
+            break;
+    }
+}
+
+// Every signal receiver has stored, node count values, for output
+void signal_row(struct Simulation* sim, int receiver, double* row) {
+    struct Signal_Store* store = &sim->signals;
+    int n = store->node_count;
+
+    if (store->layout == SIGNAL_STORE_DENSE && store->format == SIGNAL_FORMAT_DOUBLE) {
+        memcpy(row, store->values + (size_t)receiver * n * sizeof(double), sizeof(double) * n);
+    }
+    else if (store->layout == SIGNAL_STORE_SPARSE) {
+        size_t base = (size_t)receiver * store->slots;
+        memset(row, 0, sizeof(double) * n);
+        for (int i = 0; i < store->slots; i++) {
+            if (store->peer[base + i] != -1) {
+                double value = load_value(store, base + i);
+                row[store->peer[base + i]] = isnan(value) ? 0 : value;
+            }
+        }
+    }
+    else {
+        for (int i = 0; i < n; i++) {
+            row[i] = get_signal(sim, receiver, i);
+        }
+    }
+}
+
+size_t signal_store_bytes(const struct Signal_Store* store) {
+    size_t count;
+    switch (store->layout) {
+        case SIGNAL_STORE_TRIANGULAR:
+            count = (size_t)store->node_count * (store->node_count - 1) / 2;
+            return count * store->value_size;
+        case SIGNAL_STORE_SPARSE:
+            count = (size_t)store->node_count * store->slots;
+            return count * (store->value_size + sizeof(int) + sizeof(unsigned long)) +
+                   sizeof(int) * store->node_count;
+        default:
+            return (size_t)store->node_count * store->node_count * store->value_size;
+    }
+}
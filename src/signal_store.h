@@ -0,0 +1,82 @@
+/**
+ * @file    signal_store.h
+ * @brief   Received signal strength storage with dense, triangular and sparse backends
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef signal_store_H
+#define signal_store_H
+
+// Layouts, [nodes] signal_store
+#define SIGNAL_STORE_DENSE          0   // node count values per receiver
+#define SIGNAL_STORE_TRIANGULAR     1   // one value per pair, see below
+#define SIGNAL_STORE_SPARSE         2   // the signal_peers most recent per receiver
+
+// Value formats, [nodes] signal_format
+#define SIGNAL_FORMAT_DOUBLE        0
+#define SIGNAL_FORMAT_FLOAT         1
+#define SIGNAL_FORMAT_INT16         2
+#define SIGNAL_FORMAT_INT8          3
+
+// Signal an LFG broadcast has to beat to be answered, dBm
+#define SIGNAL_LFG_THRESHOLD        1.0
+
+// Quantized values are steps from a center dBm, the lowest code means
+// nothing heard (0 like an untouched dense entry) and the rest saturate.
+// int16 covers -357.67 to 297.67 dBm, about everything path loss gives at
+// the default power output. int8 covers -327 to -74 dBm, where nearly all
+// real signals are, so it's lossy for near-field ones: its top code only
+// records that a signal was over SIGNAL_LFG_THRESHOLD, for
+// signal_over_threshold(), and reads as -74 dBm. The triangular layout moves
+// the window (and threshold) down by the power output since it stores losses.
+#define SIGNAL_INT16_STEP           0.01
+#define SIGNAL_INT16_CENTER         -30.0
+#define SIGNAL_INT8_STEP            1.0
+#define SIGNAL_INT8_CENTER          -200.0
+
+/**
+ * Signal received by each node from each other node, last written when the
+ * receiver heard the transmitter.
+ *
+ * The triangular layout keeps one value per pair, the loss between them as
+ * the signal a 0 dBm transmitter would give, so either end hearing the other
+ * updates both directions. Receivers then see the most recent loss between
+ * the two rather than the one from when they last heard it themselves.
+ *
+ * The sparse layout keeps a small open addressing table per receiver,
+ * evicting the peer heard longest ago once it's full. Memory is linear in
+ * node count, anything evicted or never heard reads as 0.
+**/
+struct Signal_Store {
+    int layout;
+    int format;
+    int node_count;
+    size_t value_size;
+    double center;                  // quantized formats, dBm of code 0
+    double step;
+    double threshold;               // SIGNAL_LFG_THRESHOLD as stored
+    unsigned char* values;          // dense rows or packed upper triangle
+    // Sparse tables, slots per receiver starting at receiver * slots
+    int peers;
+    int slots;
+    int* peer;                      // -1 for an empty slot
+    unsigned long* heard;           // cycle last written
+    int* counts;
+};
+
+struct Simulation;
+
+int initialize_signal_store(struct Simulation* sim);
+int free_signal_store(struct Simulation* sim);
+double get_signal(struct Simulation* sim, int receiver, int transmitter);
+int signal_over_threshold(struct Simulation* sim, int receiver, int transmitter);
+void set_signal(struct Simulation* sim, int receiver, int transmitter, double value);
+void signal_row(struct Simulation* sim, int receiver, double* row);
+size_t signal_store_bytes(const struct Signal_Store* store);
+
+#endif
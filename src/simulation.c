@@ -0,0 +1,367 @@
+/**
+ * @file    simulation.c
+ * @brief   Simulation context and single run API
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "checkpoint.h"
+#include "file_output.h"
+#include "simulation.h"
+
+#define OUTPUT_DIR_SIZE 50
+
+// Set by SIGINT/SIGTERM, shared by every simulation in the process
+static volatile sig_atomic_t interrupted = 0;
+
+static void simulation_signal(int signum) {
+    interrupted = 1;
+}
+
+/**
+ * Simulation catch signals
+ * Desc: SIGINT and SIGTERM stop running simulations at their next step so
+ *       they get destroyed normally and buffered output is written out. A
+ *       second signal gets the default handling.
+**/
+void simulation_catch_signals(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = simulation_signal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+int simulation_interrupted(void) {
+    return interrupted;
+}
+
+/**
+ * Simulation setup
+ * Desc: Sets up a new simulation from a copy of settings, seed must already
+ *       be resolved. When checkpoint isn't NULL the nodes, state and ground
+ *       station are then overwritten with it. Nodes, ground station, output
+ *       files and the selected engine are all ready to step when this
+ *       returns.
+ *
+ * Returns: the simulation, or NULL if the checkpoint can't be restored
+**/
+static struct Simulation* simulation_setup(const struct Settings* settings, 
+                                           const struct Checkpoint* checkpoint) {
+    int ret = 0;
+    struct Simulation* sim = calloc(1, sizeof(struct Simulation));
+    if (sim == NULL) {
+        printf("Simulation memory allocation error\n");
+        exit(0);
+    }
+    sim->settings = *settings;
+
+    // Each simulation names its own output directory
+    sim->settings.output_dir = malloc(sizeof(char) * OUTPUT_DIR_SIZE);
+    if (sim->settings.output_dir == NULL) {
+        printf("Simulation memory allocation error\n");
+        exit(0);
+    }
+    sim->settings.output_dir[0] = '\0';
+
+    // state initialization
+    initialize_state(sim);
+    initialize_channel_index(sim);
+    initialize_path_loss(sim);
+    initialize_signal_store(sim);
+    initialize_rng(&sim->rng, sim->settings.random_seed);
+    packet_slab_init(&sim->packets);
+
+    if (sim->settings.output) {
+        // Make log directory if output option is turned on
+        create_log_dir(sim);
+        open_output_files(sim);
+        // create transmit_history file and header
+        create_transmit_history_file(sim);
+        // create log of received messages at ground
+        create_ground_received_file(sim);
+    }
+
+    // Get ground station ready
+    if (sim->settings.verbose) {
+        printf("Initializing ground station: ");
+    }
+    ret = initialize_ground(sim);
+    if (ret == 0) {
+        if (sim->settings.verbose) {
+            printf("OK\n");
+        }
+    }
+
+    // Get nodes ready
+    if (sim->settings.verbose) {
+        printf("Initializing nodes: ");
+    }
+    sim->nodes = malloc(sizeof(struct Node) * sim->settings.node_count);
+    if (sim->nodes == NULL) {
+        printf("Node memory allocation error\n");
+        exit(0);
+    }
+    ret = initialize_nodes(sim);
+    if (ret == 0) {
+        if (sim->settings.verbose) {
+            printf("OK\n");
+        }
+        sim->state.moving_nodes = sim->settings.node_count;
+    }
+    initialize_interference(sim);
+
+    if (checkpoint != NULL) {
+        if (sim->settings.verbose) {
+            printf("Restoring checkpoint: ");
+        }
+        if (checkpoint_apply(sim, checkpoint) != 0) {
+            if (sim->settings.verbose) {
+                printf("Failed\n");
+            }
+            if (sim->settings.output) {
+                close_output_files(sim);
+            }
+            free_interference(sim);
+            free_nodes(sim);
+            free(sim->nodes);
+            free(sim->ground.new_message_available);
+            free_channel_index(sim);
+            free_path_loss(sim);
+            free_signal_store(sim);
+            packet_slab_free(&sim->packets);
+            free(sim->settings.output_dir);
+            free(sim);
+            return NULL;
+        }
+        if (sim->settings.verbose) {
+            printf("OK, cycle %lu\n", sim->state.current_cycle);
+        }
+    }
+
+    if (sim->settings.output) {
+        create_node_files(sim);
+        start_output_writer(sim);
+    }
+
+    // Built from restored positions too
+    initialize_spatial_grid(sim);
+    initialize_neighbor_lists(sim);
+    // Transmitters restored without what they held start from here
+    update_interference(sim);
+
+    // Engines schedule from the current cycle, so these go last
+    if (sim->settings.use_pthreads) {
+        if (sim->settings.engine == ENGINE_EVENT && sim->settings.verbose) {
+            printf("Event engine not available with pthreads, using tick engine\n");
+        }
+        initialize_thread_pool(sim);
+    }
+    else if (sim->settings.engine == ENGINE_EVENT) {
+        initialize_scheduler(sim);
+    }
+    else {
+        initialize_mcu_wheel(sim);
+    }
+    profile_init(sim);
+
+    return sim;
+}
+
+struct Simulation* simulation_create(const struct Settings* settings) {
+    return simulation_setup(settings, NULL);
+}
+
+// New simulation carrying on from checkpoint, settings can differ from the
+// checkpointed run in anything checkpoint_check() allows
+struct Simulation* simulation_restore(const struct Settings* settings, 
+                                      const struct Checkpoint* checkpoint) {
+    if (checkpoint_check(checkpoint, settings) != 0) {
+        return NULL;
+    }
+    return simulation_setup(settings, checkpoint);
+}
+
+/**
+ * Simulation step
+ * Desc: Advances the simulation with the selected engine. The tick engines
+ *       move one tick, the event engine moves to the next cycle any node MCU
+ *       is due (or until every node has landed).
+ *
+ * Returns: number of nodes still falling
+**/
+int simulation_step(struct Simulation* sim) {
+    if (sim->settings.use_pthreads) {
+        clock_tick_threaded(sim);
+    }
+    else if (sim->settings.engine == ENGINE_EVENT) {
+        event_tick(sim);
+    }
+    else {
+        clock_tick(sim);
+    }
+    sim->state.moving_nodes = count_moving_nodes(sim);
+    PROFILE_STEP(sim);
+    return sim->state.moving_nodes;
+}
+
+// Steps until simulated time reaches stop_time or every node has landed
+int simulation_run_until(struct Simulation* sim, double stop_time) {
+    while (sim->state.moving_nodes != 0 && sim->state.current_time < stop_time && !interrupted) {
+        simulation_step(sim);
+    }
+    return sim->state.moving_nodes;
+}
+
+/**
+ * Simulation run
+ * Desc: Steps until all nodes reach z = 0, prints the summary and fills in
+ *       result if it isn't NULL
+**/
+int simulation_run(struct Simulation* sim, struct Sim_Result* result) {
+    if (sim->settings.verbose) {
+        printf("Running simulation\n");
+    }
+
+    while (sim->state.moving_nodes != 0 && !interrupted) {
+        simulation_step(sim);
+    }
+    if (interrupted && sim->settings.verbose) {
+        printf("Interrupted at %f seconds\n", sim->state.current_time);
+    }
+
+    if (result != NULL) {
+        simulation_result(sim, result);
+    }
+
+    // Calculate simulation time
+    double runTime = (double)(clock() - sim->state.start_time) / CLOCKS_PER_SEC;
+
+    // Print summary information
+    if (sim->settings.verbose) {
+        printf("Simulation complete\n");
+        printf("Cycles processed: %lu\n", sim->state.current_cycle);
+        printf("Simulation time: %f seconds\n", sim->state.current_time);
+    }
+
+    if (sim->settings.debug) {
+        for (int i = 0; i < sim->settings.node_count; i++) {
+            printf("Node %d final velocity: %f %f %f m/s, final position: %f %f %f\n",
+                i,
+                NODE_KIN(sim, i, x_velocity),
+                NODE_KIN(sim, i, y_velocity),
+                NODE_KIN(sim, i, z_velocity),
+                NODE_KIN(sim, i, x_pos),
+                NODE_KIN(sim, i, y_pos),
+                NODE_KIN(sim, i, z_pos));
+        }
+    }
+    if (sim->settings.verbose) {
+        printf("Final clock time: %f seconds\n", runTime);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Total collisions detected: %d\n", sim->state.collisions);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Total messages sent: %lu\n", sim->state.sent_messages);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Ground station received %d messages\n", sim->ground.messages_received);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Ground station detected %d collisions\n", sim->ground.collisions_detected);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Relay queue drops: %lu\n", sim->state.relay_drops);
+    }
+
+    if (sim->settings.verbose && sim->settings.output) {
+        struct Output_Queue* queue = &sim->output_queue;
+        printf("Output records: %lu, writer stalls: %lu (%f seconds), peak queue %lu of %lu KB\n",
+               queue->records, queue->stalls, queue->stall_time, 
+               (unsigned long)queue->peak_used / 1024, (unsigned long)queue->capacity / 1024);
+    }
+
+    if (sim->settings.verbose && sim->neighbors.enabled) {
+        printf("Neighbor lists: %lu builds, %f peers per node\n", sim->neighbors.builds,
+               (double)sim->neighbors.start[sim->settings.node_count] / sim->settings.node_count);
+    }
+
+    if (sim->settings.verbose && sim->interference.enabled) {
+        printf("SINR captures: %lu\n", sim->state.sinr_captures);
+    }
+
+    if (sim->settings.verbose) {
+        printf("Message succeess rate: %f\n", (float)sim->ground.messages_received / sim->state.sent_messages);
+    }
+
+    if (sim->settings.verbose) {
+        profile_print(sim);
+    }
+
+    return 0;
+}
+
+// Summary of the simulation so far, spread is horizontal distance from the drop point
+int simulation_result(struct Simulation* sim, struct Sim_Result* result) {
+    double spread = 0;
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        double dx = NODE_KIN(sim, i, x_pos) - sim->settings.start_x;
+        double dy = NODE_KIN(sim, i, y_pos) - sim->settings.start_y;
+        spread += sqrt(dx * dx + dy * dy);
+    }
+    result->cycles = sim->state.current_cycle;
+    result->sim_time = sim->state.current_time;
+    result->collisions = sim->state.collisions;
+    result->sent_messages = sim->state.sent_messages;
+    result->ground_messages_received = sim->ground.messages_received;
+    result->ground_collisions = sim->ground.collisions_detected;
+    result->group_joins = sim->state.group_joins;
+    result->relay_drops = sim->state.relay_drops;
+    result->output_stalls = sim->settings.output ? sim->output_queue.stalls : 0;
+    result->output_stall_time = sim->settings.output ? sim->output_queue.stall_time : 0;
+    result->mean_spread = sim->settings.node_count > 0 ? spread / sim->settings.node_count : 0;
+    return 0;
+}
+
+void simulation_destroy(struct Simulation* sim) {
+    if (sim->settings.use_pthreads) {
+        shutdown_thread_pool(sim);
+    }
+    else if (sim->settings.engine == ENGINE_EVENT) {
+        free_scheduler(&sim->event_queue);
+    }
+    else {
+        free_mcu_wheel(&sim->wheel);
+    }
+    if (sim->settings.output) {
+        close_output_files(sim);
+    }
+    profile_free(sim);
+    free_neighbor_lists(sim);
+    free_spatial_grid(sim);
+    free_interference(sim);
+    free_nodes(sim);
+    free(sim->nodes);
+    free(sim->ground.new_message_available);
+    free_channel_index(sim);
+    free_path_loss(sim);
+    free_signal_store(sim);
+    packet_slab_free(&sim->packets);
+    free(sim->settings.output_dir);
+    free(sim);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file    simulation.h
+ * @brief   Simulation context and single run API
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "channels.h"
+#include "checkpoint.h"
+#include "file_output.h"
+#include "ground.h"
+#include "interference.h"
+#include "kinematics.h"
+#include "mcu_emulation.h"
+#include "neighbors.h"
+#include "node.h"
+#include "profile.h"
+#include "rng.h"
+#include "scheduler.h"
+#include "settings.h"
+#include "signal_store.h"
+#include "spatial_grid.h"
+#include "state.h"
+#include "threads.h"
+#include "trace.h"
+
+#ifndef simulation_H
+#define simulation_H
+
+/**
+ * Everything one simulation owns. Nothing in the simulator is global, so any
+ * number of these can be created and stepped at once, each from its own
+ * thread.
+**/
+struct Simulation {
+    struct Settings settings;
+    struct State state;
+    struct Node* nodes;
+    struct Stack_Arena stacks;
+    struct cycle_timer* timer_table;
+    struct stored_message* relay_table;
+    struct Ground_Station ground;
+    struct Channel_Occupancy* channel_index;
+    struct Channel_Waiters* channel_waiters;
+    struct Node_View* node_views;
+    struct Spatial_Grid grid;
+    struct Neighbor_Lists neighbors;
+    struct Path_Loss path_loss;
+    struct Signal_Store signals;
+    struct Interference interference;
+    struct Packet_Slab packets;
+    struct Output_Writer output;
+    struct Output_Queue output_queue;
+    struct Trace trace;
+#ifdef KINEMATICS_SOA
+    struct Kinematics kinematics;
+#endif
+    struct RNG rng;
+    struct MCU_Wheel wheel;
+    struct Event_Queue event_queue;
+    struct Thread_Pool pool;
+    struct Profile profile;
+};
+
+// Summary of one finished run
+struct Sim_Result {
+    unsigned long cycles;
+    double sim_time;
+    int collisions;
+    unsigned long sent_messages;
+    int ground_messages_received;
+    int ground_collisions;
+    int group_joins;
+    unsigned long relay_drops;
+    unsigned long output_stalls;
+    double output_stall_time;
+    double mean_spread;
+};
+
+// Node fields other MCUs read, through the previous tick view when nodes run
+// on worker threads
+static inline int peer_active_channel(struct Simulation* sim, int id) {
+    return sim->node_views ? sim->node_views[id].active_channel : sim->nodes[id].active_channel;
+}
+
+static inline int peer_transmit_active(struct Simulation* sim, int id) {
+    return sim->node_views ? sim->node_views[id].transmit_active : sim->nodes[id].transmit_active;
+}
+
+// Slab handle of the packet node id has on air
+static inline int peer_send_packet(struct Simulation* sim, int id) {
+    return sim->node_views ? sim->node_views[id].send_packet : sim->nodes[id].send_packet;
+}
+
+// Decodes the packet node id has on air, only the header unless full is set
+static inline int peer_packet(struct Simulation* sim, int id, struct Packet* packet, int full) {
+    return packet_read(&sim->packets, peer_send_packet(sim, id), packet, full);
+}
+
+void simulation_catch_signals(void);
+int simulation_interrupted(void);
+struct Simulation* simulation_create(const struct Settings* settings);
+struct Simulation* simulation_restore(const struct Settings* settings, 
+                                      const struct Checkpoint* checkpoint);
+int simulation_step(struct Simulation* sim);
+int simulation_run_until(struct Simulation* sim, double stop_time);
+int simulation_run(struct Simulation* sim, struct Sim_Result* result);
+int simulation_result(struct Simulation* sim, struct Sim_Result* result);
+void simulation_destroy(struct Simulation* sim);
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * @file    spatial_grid.c
+ * @brief   Uniform 3D cell grid over node positions for range limited queries
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include "simulation.h"
+#include "spatial_grid.h"
+
+// Cell coordinates are clamped well inside int so neighbours never overflow
+#define GRID_CELL_LIMIT     (INT_MAX / 4)
+
+static int cell_coordinate(double position, double cell_size) {
+    double cell = floor(position / cell_size);
+    if (cell > GRID_CELL_LIMIT) {
+        return GRID_CELL_LIMIT;
+    }
+    if (cell < -GRID_CELL_LIMIT) {
+        return -GRID_CELL_LIMIT;
+    }
+    return (int)cell;
+}
+
+static uint32_t cell_bucket(const struct Spatial_Grid* grid, int x, int y, int z) {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u) & grid->bucket_mask;
+}
+
+static void grid_link(struct Spatial_Grid* grid, int id) {
+    int* cell = &grid->cell[3 * id];
+    uint32_t bucket = cell_bucket(grid, cell[0], cell[1], cell[2]);
+    grid->prev[id] = -1;
+    grid->next[id] = grid->bucket_head[bucket];
+    if (grid->next[id] != -1) {
+        grid->prev[grid->next[id]] = id;
+    }
+    grid->bucket_head[bucket] = id;
+    grid->bucket_size[bucket]++;
+}
+
+static void grid_unlink(struct Spatial_Grid* grid, int id) {
+    int* cell = &grid->cell[3 * id];
+    uint32_t bucket = cell_bucket(grid, cell[0], cell[1], cell[2]);
+    if (grid->prev[id] != -1) {
+        grid->next[grid->prev[id]] = grid->next[id];
+    }
+    else {
+        grid->bucket_head[bucket] = grid->next[id];
+    }
+    if (grid->next[id] != -1) {
+        grid->prev[grid->next[id]] = grid->prev[id];
+    }
+    grid->bucket_size[bucket]--;
+}
+
+/**
+ * Initialize spatial grid
+ * Desc: Builds the grid from current node positions when
+ *       receiver_sensitivity is finite, otherwise leaves it disabled. Cells
+ *       are grid_cell_size on a side, or the radio range if that's 0, so a
+ *       range query covers 27 cells.
+**/
+int initialize_spatial_grid(struct Simulation* sim) {
+    struct Spatial_Grid* grid = &sim->grid;
+    int n = sim->settings.node_count;
+    memset(grid, 0, sizeof(*grid));
+    if (!isfinite(sim->settings.receiver_sensitivity) || n == 0) {
+        return 0;
+    }
+
+    grid->range_squared = malloc(sizeof(double) * n);
+    grid->next = malloc(sizeof(int) * n);
+    grid->prev = malloc(sizeof(int) * n);
+    grid->cell = malloc(sizeof(int) * 3 * n);
+    if (grid->range_squared == NULL || grid->next == NULL || grid->prev == NULL || grid->cell == NULL) {
+        printf("Spatial grid memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < n; i++) {
+        double range = signal_range(sim, sim->nodes[i].power_output);
+        grid->range_squared[i] = range * range;
+        if (range > grid->range) {
+            grid->range = range;
+        }
+    }
+
+    grid->cell_size = sim->settings.grid_cell_size > 0 ? sim->settings.grid_cell_size : grid->range;
+    if (!(grid->cell_size > 0) || !isfinite(grid->cell_size)) {
+        grid->cell_size = 1.0;
+    }
+
+    // Twice as many buckets as nodes keeps lists short even with every
+    // node in its own cell
+    uint32_t buckets = 1;
+    while (buckets < 2u * (uint32_t)n && buckets < (1u << 30)) {
+        buckets <<= 1;
+    }
+    grid->bucket_mask = buckets - 1;
+    grid->bucket_head = malloc(sizeof(int) * buckets);
+    grid->bucket_size = calloc(buckets, sizeof(int));
+    if (grid->bucket_head == NULL || grid->bucket_size == NULL) {
+        printf("Spatial grid memory allocation error\n");
+        exit(0);
+    }
+    for (uint32_t b = 0; b < buckets; b++) {
+        grid->bucket_head[b] = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        grid->cell[3 * i] = cell_coordinate(NODE_KIN(sim, i, x_pos), grid->cell_size);
+        grid->cell[3 * i + 1] = cell_coordinate(NODE_KIN(sim, i, y_pos), grid->cell_size);
+        grid->cell[3 * i + 2] = cell_coordinate(NODE_KIN(sim, i, z_pos), grid->cell_size);
+        grid_link(grid, i);
+    }
+    grid->enabled = 1;
+
+    if (sim->settings.verbose) {
+        printf("Spatial grid: radio range %f m, cell size %f m\n", grid->range, grid->cell_size);
+    }
+    return 0;
+}
+
+// Moves nodes that crossed into another cell since the last update
+int update_spatial_grid(struct Simulation* sim) {
+    struct Spatial_Grid* grid = &sim->grid;
+    if (!grid->enabled) {
+        return 0;
+    }
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        int x = cell_coordinate(NODE_KIN(sim, i, x_pos), grid->cell_size);
+        int y = cell_coordinate(NODE_KIN(sim, i, y_pos), grid->cell_size);
+        int z = cell_coordinate(NODE_KIN(sim, i, z_pos), grid->cell_size);
+        int* cell = &grid->cell[3 * i];
+        if (x != cell[0] || y != cell[1] || z != cell[2]) {
+            grid_unlink(grid, i);
+            cell[0] = x;
+            cell[1] = y;
+            cell[2] = z;
+            grid_link(grid, i);
+            grid->moves++;
+        }
+    }
+    return 0;
+}
+
+int free_spatial_grid(struct Simulation* sim) {
+    struct Spatial_Grid* grid = &sim->grid;
+    free(grid->range_squared);
+    free(grid->bucket_head);
+    free(grid->bucket_size);
+    free(grid->next);
+    free(grid->prev);
+    free(grid->cell);
+    memset(grid, 0, sizeof(*grid));
+    return 0;
+}
+
+// Cells from low to high on each axis that a query of range around x, y, z
+// covers, 0 if there are too many to be worth visiting one by one
+static int query_box(const struct Spatial_Grid* grid, double x, double y, double z, double range,
+                     int* low, int* high) {
+    double reach = ceil(range / grid->cell_size);
+    if (!(reach * 2 + 1 <= 1024) || pow(reach * 2 + 1, 3) > grid->bucket_mask + 1.0) {
+        return 0;
+    }
+    double center[3] = {x, y, z};
+    for (int axis = 0; axis < 3; axis++) {
+        int cell = cell_coordinate(center[axis], grid->cell_size);
+        low[axis] = cell - (int)reach;
+        high[axis] = cell + (int)reach;
+    }
+    return 1;
+}
+
+/**
+ * Spatial grid count
+ * Desc: Upper bound on the nodes a spatial_grid_visit() with the same
+ *       arguments would visit, for picking between it and a plain scan.
+ *       Cells sharing a bucket are counted for each of them.
+ *
+ * Returns: the bound, or LONG_MAX if the query covers too many cells
+**/
+long spatial_grid_count(struct Spatial_Grid* grid, double x, double y, double z, double range) {
+    int low[3];
+    int high[3];
+    if (!query_box(grid, x, y, z, range, low, high)) {
+        return LONG_MAX;
+    }
+    long count = 0;
+    for (int cx = low[0]; cx <= high[0]; cx++) {
+        for (int cy = low[1]; cy <= high[1]; cy++) {
+            for (int cz = low[2]; cz <= high[2]; cz++) {
+                count += grid->bucket_size[cell_bucket(grid, cx, cy, cz)];
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Spatial grid visit
+ * Desc: Calls visitor for every node in the cells within range of x, y, z.
+ *       Safe from worker threads, the grid only changes between MCU phases.
+ *
+ * Returns: 0, or -1 without visiting anything if the query covers too many
+ *          cells (see spatial_grid_count())
+**/
+int spatial_grid_visit(struct Simulation* sim, double x, double y, double z, double range,
+                       Grid_Visitor visitor, void* context) {
+    struct Spatial_Grid* grid = &sim->grid;
+    int low[3];
+    int high[3];
+    if (!query_box(grid, x, y, z, range, low, high)) {
+        return -1;
+    }
+    for (int cx = low[0]; cx <= high[0]; cx++) {
+        for (int cy = low[1]; cy <= high[1]; cy++) {
+            for (int cz = low[2]; cz <= high[2]; cz++) {
+                for (int i = grid->bucket_head[cell_bucket(grid, cx, cy, cz)]; i != -1; i = grid->next[i]) {
+                    // Skip other cells hashed to the same bucket
+                    const int* cell = &grid->cell[3 * i];
+                    if (cell[0] == cx && cell[1] == cy && cell[2] == cz) {
+                        visitor(sim, i, context);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file    spatial_grid.h
+ * @brief   Uniform 3D cell grid over node positions for range limited queries
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+
+#ifndef spatial_grid_H
+#define spatial_grid_H
+
+struct Simulation;
+
+// Called for each node in the cells a query covers, which can be a little
+// farther away than the range asked for
+typedef void (*Grid_Visitor)(struct Simulation* sim, int id, void* context);
+
+/**
+ * Nodes are kept in doubly linked lists per cell, hashed into a table of
+ * bucket_count lists so the grid can cover any area without a bound. A
+ * node only moves between lists when it crosses into another cell, which
+ * falling nodes do rarely compared to how often they move.
+ *
+ * Only set up when receiver_sensitivity gives radio a finite range.
+**/
+struct Spatial_Grid {
+    int enabled;
+    double cell_size;
+    double range;                   // farthest any node can be heard from
+    double* range_squared;          // per node, from its power output
+    uint32_t bucket_mask;
+    int* bucket_head;
+    int* bucket_size;
+    int* next;
+    int* prev;
+    int* cell;                      // x, y, z cell of each node
+    unsigned long moves;
+};
+
+int initialize_spatial_grid(struct Simulation* sim);
+int update_spatial_grid(struct Simulation* sim);
+int free_spatial_grid(struct Simulation* sim);
+long spatial_grid_count(struct Spatial_Grid* grid, double x, double y, double z, double range);
+int spatial_grid_visit(struct Simulation* sim, double x, double y, double z, double range,
+                       Grid_Visitor visitor, void* context);
+
+#endif
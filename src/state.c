@@ -8,39 +8,76 @@
 
 #include "file_output.h"
 #include "mcu_emulation.h"
+#include "simulation.h"
 #include "state.h"
 
-extern struct Settings settings;
-extern struct State state;
-
-int initialize_state() {
-    state.start_time = clock();
-    state.moving_nodes = 0;
-    state.current_time = 0;
-    state.collisions = 0;
-    state.current_cycle = 0;
-    state.sent_messages = 0;
+int initialize_state(struct Simulation* sim) {
+    sim->state.start_time = clock();
+    sim->state.moving_nodes = 0;
+    sim->state.current_time = 0;
+    sim->state.collisions = 0;
+    sim->state.current_cycle = 0;
+    sim->state.sent_messages = 0;
+    sim->state.group_joins = 0;
+    sim->state.relay_drops = 0;
+    sim->state.sinr_captures = 0;
 
     return 0;
 }
 
-int clock_tick(struct Node* nodes, struct Ground_Station* ground) {
-    state.current_time += settings.time_resolution;
+// Advance time by one tick and integrate node kinematics
+int clock_advance(struct Simulation* sim) {
+    sim->state.current_time += sim->settings.time_resolution;
     
-    if (settings.debug > 1) {
-        printf("Clock tick: %f\n", state.current_time);
+    if (sim->settings.debug > 1) {
+        printf("Clock tick: %f\n", sim->state.current_time);
     }
 
     // Update current cycle
-    state.current_cycle++;
-    update_acceleration(nodes);
-    update_velocity(nodes);
-    update_position(nodes);
-    update_mcu(nodes);
-    update_ground(nodes, ground);
-
-    if (settings.output) {
-        check_write_interval(nodes);
+    sim->state.current_cycle++;
+    PROFILE_BEGIN(acceleration);
+    update_acceleration(sim);
+    PROFILE_PHASE(sim, PROFILE_ACCELERATION, acceleration);
+    PROFILE_BEGIN(velocity);
+    update_velocity(sim);
+    PROFILE_PHASE(sim, PROFILE_VELOCITY, velocity);
+    PROFILE_BEGIN(position);
+    update_position(sim);
+    PROFILE_PHASE(sim, PROFILE_POSITION, position);
+
+    return 0;
+}
+
+// Advance time by up to ticks ticks in one kinematics span, for ticks where
+// no node MCU runs. Returns ticks advanced, fewer once every node has landed.
+unsigned long clock_advance_span(struct Simulation* sim, unsigned long ticks) {
+    PROFILE_BEGIN(position);
+    ticks = update_kinematics_span(sim, sim->state.current_cycle + 1, ticks);
+    PROFILE_PHASE(sim, PROFILE_POSITION, position);
+
+    // Time is summed tick by tick so it matches clock_advance() exactly
+    for (unsigned long i = 0; i < ticks; i++) {
+        sim->state.current_time += sim->settings.time_resolution;
+    }
+    sim->state.current_cycle += ticks;
+    return ticks;
+}
+
+int clock_tick(struct Simulation* sim) {
+    clock_advance(sim);
+    PROFILE_BEGIN(mcu);
+    update_spatial_grid(sim);
+    update_neighbor_lists(sim);
+    update_mcu(sim);
+    PROFILE_PHASE(sim, PROFILE_MCU, mcu);
+    PROFILE_BEGIN(ground);
+    update_ground(sim);
+    PROFILE_PHASE(sim, PROFILE_GROUND, ground);
+
+    if (sim->settings.output) {
+        PROFILE_BEGIN(output);
+        check_write_interval(sim);
+        PROFILE_PHASE(sim, PROFILE_OUTPUT, output);
     }
 
     return 0;
@@ -21,9 +21,16 @@ struct State {
     int collisions;
     unsigned long current_cycle;
     unsigned long sent_messages;
+    int group_joins;
+    unsigned long relay_drops;
+    unsigned long sinr_captures;
 };
 
-int initialize_state();
-int clock_tick(struct Node* nodes, struct Ground_Station* ground);
+struct Simulation;
+
+int initialize_state(struct Simulation* sim);
+int clock_advance(struct Simulation* sim);
+unsigned long clock_advance_span(struct Simulation* sim, unsigned long ticks);
+int clock_tick(struct Simulation* sim);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,442 @@
+/**
+ * @file    sweep.c
+ * @brief   Parameter sweep runner
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "settings.h"
+#include "simulation.h"
+#include "sweep.h"
+
+// Scripts pick columns by number, new metrics go on the end
+static const char* metric_names[SWEEP_METRICS] = {
+    "success_rate",
+    "sent",
+    "received",
+    "collisions",
+    "ground_collisions",
+    "group_joins",
+    "mean_spread",
+    "cycles",
+    "sim_time",
+    "relay_drops"
+};
+
+static void result_metrics(const struct Sim_Result* result, double* metrics) {
+    metrics[0] = result->sent_messages > 0 ?
+        (double)result->ground_messages_received / result->sent_messages : 0;
+    metrics[1] = result->sent_messages;
+    metrics[2] = result->ground_messages_received;
+    metrics[3] = result->collisions;
+    metrics[4] = result->ground_collisions;
+    metrics[5] = result->group_joins;
+    metrics[6] = result->mean_spread;
+    metrics[7] = result->cycles;
+    metrics[8] = result->sim_time;
+    metrics[9] = result->relay_drops;
+}
+
+// Welford's update so variance doesn't need a second pass over the replicas
+static void stats_add(struct Sweep_Stats* stats, const double* metrics) {
+    stats->runs++;
+    for (int i = 0; i < SWEEP_METRICS; i++) {
+        double delta = metrics[i] - stats->mean[i];
+        stats->mean[i] += delta / stats->runs;
+        stats->m2[i] += delta * (metrics[i] - stats->mean[i]);
+    }
+}
+
+/**
+ * Parse sweep parameter
+ * Desc: Expands "name=start:end[:step]" into each value of the range, or
+ *       "name=a,b,c" into the listed values
+**/
+static int parse_sweep_parameter(const struct Settings* base, const char* spec, 
+                                 struct Sweep_Parameter* parameter) {
+    const char* equals = strchr(spec, '=');
+    if (equals == NULL || equals == spec) {
+        fprintf(stderr, "Sweep parameter '%s' must be name=start:end[:step] or name=a,b,c\n", spec);
+        return 1;
+    }
+    parameter->name = strndup(spec, equals - spec);
+    parameter->values = NULL;
+    parameter->value_count = 0;
+
+    const char* range = equals + 1;
+    if (strchr(range, ':') != NULL) {
+        double start = 0;
+        double end = 0;
+        double step = 1;
+        int fields = sscanf(range, "%lf:%lf:%lf", &start, &end, &step);
+        if (fields < 2 || step == 0 || (end - start) / step < 0) {
+            fprintf(stderr, "Invalid sweep range '%s'\n", range);
+            return 1;
+        }
+        int count = (int)((end - start) / step + 1e-9) + 1;
+        parameter->values = malloc(sizeof(char*) * count);
+        for (int i = 0; i < count; i++) {
+            char value[32];
+            snprintf(value, sizeof(value), "%.10g", start + i * step);
+            parameter->values[i] = strdup(value);
+        }
+        parameter->value_count = count;
+    }
+    else {
+        char* list = strdup(range);
+        char* saveptr;
+        for (char* token = strtok_r(list, ",", &saveptr); token != NULL;
+            token = strtok_r(NULL, ",", &saveptr)) {
+            parameter->values = realloc(parameter->values,
+                sizeof(char*) * (parameter->value_count + 1));
+            parameter->values[parameter->value_count++] = strdup(token);
+        }
+        free(list);
+    }
+
+    if (parameter->value_count == 0) {
+        fprintf(stderr, "Sweep parameter '%s' has no values\n", spec);
+        return 1;
+    }
+
+    // Make sure the name maps to a settings field before running anything
+    struct Settings check = *base;
+    if (!apply_setting(&check, parameter->name, parameter->values[0])) {
+        fprintf(stderr, "Unknown sweep parameter '%s'\n", parameter->name);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Settings for one replica, replica index is grid point major and the first
+// parameter varies slowest
+static void replica_settings(struct Sweep* sweep, int replica, struct Settings* config) {
+    int point = replica / sweep->repeats;
+
+    *config = *sweep->base;
+    for (int i = sweep->parameter_count - 1; i >= 0; i--) {
+        apply_setting(config, sweep->parameters[i].name,
+            sweep->parameters[i].values[point % sweep->parameters[i].value_count]);
+        point /= sweep->parameters[i].value_count;
+    }
+    config->random_seed += replica % sweep->repeats;
+    config->verbose = 0;
+    config->debug = 0;
+    config->output = 0;
+    config->profile_csv = NULL;
+}
+
+static int run_replica(struct Sweep* sweep, int replica, struct Sim_Result* result) {
+    struct Settings config;
+
+    replica_settings(sweep, replica, &config);
+    memset(result, 0, sizeof(*result));
+    struct Simulation* sim;
+    if (sweep->checkpoint != NULL) {
+        sim = simulation_restore(&config, sweep->checkpoint);
+        if (sim == NULL) {
+            return 1;
+        }
+    }
+    else {
+        sim = simulation_create(&config);
+    }
+    simulation_run(sim, result);
+    simulation_destroy(sim);
+
+    return 0;
+}
+
+/**
+ * Sweep checkpoint
+ * Desc: Runs the shared prefix once, from the start or from restore_file,
+ *       until checkpoint_time and keeps it in memory for every replica to
+ *       branch from. Forked replicas share it copy-on-write.
+**/
+static int sweep_checkpoint(const struct Settings* settings, struct Checkpoint* checkpoint) {
+    struct Settings config = *settings;
+    struct Simulation* sim;
+
+    config.verbose = 0;
+    config.debug = 0;
+    config.output = 0;
+    config.profile_csv = NULL;
+    if (settings->restore_file != NULL) {
+        struct Checkpoint restored;
+        if (checkpoint_load(&restored, settings->restore_file) != 0) {
+            return 1;
+        }
+        sim = simulation_restore(&config, &restored);
+        checkpoint_free(&restored);
+        if (sim == NULL) {
+            return 1;
+        }
+    }
+    else {
+        sim = simulation_create(&config);
+    }
+
+    simulation_run_until(sim, settings->checkpoint_time);
+    int ret = checkpoint_capture(sim, checkpoint);
+    if (ret == 0 && settings->verbose) {
+        printf("# Branching from cycle %lu (%f seconds)\n", 
+            sim->state.current_cycle, sim->state.current_time);
+    }
+    simulation_destroy(sim);
+
+    if (ret == 0 && settings->checkpoint_file != NULL) {
+        ret = checkpoint_save(checkpoint, settings->checkpoint_file);
+    }
+    return ret;
+}
+
+// Thread worker, takes replicas off the shared counter until none are left
+static void* sweep_thread(void* arg) {
+    struct Sweep* sweep = arg;
+    while (1) {
+        int replica = __atomic_fetch_add(&sweep->next_replica, 1, __ATOMIC_RELAXED);
+        if (replica >= sweep->replica_count) {
+            break;
+        }
+        if (run_replica(sweep, replica, &sweep->results[replica]) == 0) {
+            sweep->completed[replica] = 1;
+        }
+    }
+    return NULL;
+}
+
+static int run_threads(struct Sweep* sweep, int workers) {
+    pthread_t threads[workers];
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, sweep_thread, sweep) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return 0;
+}
+
+// Forked workers, each replica reports its result through a pipe
+static int run_processes(struct Sweep* sweep, int workers) {
+    pid_t worker_pid[workers];
+    int worker_fd[workers];
+    int worker_replica[workers];
+    for (int i = 0; i < workers; i++) {
+        worker_pid[i] = -1;
+    }
+
+    int running = 0;
+    while (sweep->next_replica < sweep->replica_count || running > 0) {
+        // Fill free worker slots
+        for (int i = 0; i < workers && sweep->next_replica < sweep->replica_count; i++) {
+            if (worker_pid[i] != -1) {
+                continue;
+            }
+            int fds[2];
+            if (pipe(fds) != 0) {
+                perror("pipe");
+                return 1;
+            }
+            int replica = sweep->next_replica;
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (pid == 0) {
+                struct Sim_Result result;
+                close(fds[0]);
+                int ret = run_replica(sweep, replica, &result);
+                if (write(fds[1], &result, sizeof(result)) != sizeof(result)) {
+                    ret = 1;
+                }
+                close(fds[1]);
+                _exit(ret);
+            }
+            close(fds[1]);
+            worker_pid[i] = pid;
+            worker_fd[i] = fds[0];
+            worker_replica[i] = replica;
+            running++;
+            sweep->next_replica++;
+        }
+
+        // Collect whichever replica finishes first
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            perror("wait");
+            return 1;
+        }
+        for (int i = 0; i < workers; i++) {
+            if (worker_pid[i] != pid) {
+                continue;
+            }
+            int replica = worker_replica[i];
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                read(worker_fd[i], &sweep->results[replica], sizeof(struct Sim_Result)) == 
+                sizeof(struct Sim_Result)) {
+                sweep->completed[replica] = 1;
+            }
+            close(worker_fd[i]);
+            worker_pid[i] = -1;
+            running--;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Run sweep
+ * Desc: Runs every combination of the sweep parameters sweep_repeats times
+ *       and prints one table with the mean and variance of each metric per
+ *       combination. Each replica is its own simulation built from the
+ *       settings already loaded, so nothing is re-parsed. Replicas run on
+ *       sweep_workers threads in this process, or in forked processes with
+ *       sweep_threads = 0. Repeat r of every combination uses seed + r.
+ *       With checkpoint_time or restore_file set replicas all carry on from
+ *       one checkpoint instead of each simulating the drop from the start.
+**/
+int run_sweep(const struct Settings* settings) {
+    struct Sweep sweep;
+    int parameter_count = settings->sweep_parameter_count;
+    struct Sweep_Parameter parameters[parameter_count > 0 ? parameter_count : 1];
+    int point_count = 1;
+
+    for (int i = 0; i < parameter_count; i++) {
+        if (parse_sweep_parameter(settings, settings->sweep_parameters[i], &parameters[i])) {
+            return 1;
+        }
+        point_count *= parameters[i].value_count;
+    }
+
+    sweep.base = settings;
+    sweep.parameters = parameters;
+    sweep.parameter_count = parameter_count;
+    sweep.repeats = settings->sweep_repeats > 0 ? settings->sweep_repeats : 1;
+    sweep.replica_count = point_count * sweep.repeats;
+    sweep.next_replica = 0;
+    sweep.results = calloc(sweep.replica_count, sizeof(struct Sim_Result));
+    sweep.completed = calloc(sweep.replica_count, sizeof(int));
+    if (sweep.results == NULL || sweep.completed == NULL) {
+        printf("Sweep memory allocation error\n");
+        exit(0);
+    }
+
+    // Branch every replica from one checkpoint when there's a prefix to share
+    struct Checkpoint checkpoint;
+    sweep.checkpoint = NULL;
+    if (settings->restore_file != NULL || settings->checkpoint_time > 0) {
+        if (sweep_checkpoint(settings, &checkpoint) != 0) {
+            return 1;
+        }
+        sweep.checkpoint = &checkpoint;
+        for (int replica = 0; replica < sweep.replica_count; replica++) {
+            struct Settings config;
+            replica_settings(&sweep, replica, &config);
+            if (checkpoint_check(&checkpoint, &config) != 0) {
+                fprintf(stderr, "Swept settings must keep the checkpoint's node layout\n");
+                return 1;
+            }
+        }
+    }
+
+    int workers = settings->sweep_workers;
+    if (workers <= 0) {
+        workers = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (workers > sweep.replica_count) {
+        workers = sweep.replica_count;
+    }
+    if (workers <= 0) {
+        workers = 1;
+    }
+
+    if (settings->verbose) {
+        printf("# Sweep: %d combinations x %d repeats on %d %s\n",
+            point_count, sweep.repeats, workers, 
+            settings->sweep_threads ? "threads" : "processes");
+        fflush(stdout);
+    }
+
+    int ret;
+    if (settings->sweep_threads) {
+        ret = run_threads(&sweep, workers);
+    }
+    else {
+        ret = run_processes(&sweep, workers);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Aggregate in replica order so results don't depend on finishing order
+    struct Sweep_Stats* stats = calloc(point_count, sizeof(struct Sweep_Stats));
+    int failed = 0;
+    for (int replica = 0; replica < sweep.replica_count; replica++) {
+        if (sweep.completed[replica]) {
+            double metrics[SWEEP_METRICS];
+            result_metrics(&sweep.results[replica], metrics);
+            stats_add(&stats[replica / sweep.repeats], metrics);
+        }
+        else {
+            failed++;
+        }
+    }
+
+    // Results table, tab separated so it can go straight into gnuplot
+    printf("#");
+    for (int i = 0; i < parameter_count; i++) {
+        printf("%s\t", parameters[i].name);
+    }
+    printf("runs");
+    for (int i = 0; i < SWEEP_METRICS; i++) {
+        printf("\t%s_mean\t%s_var", metric_names[i], metric_names[i]);
+    }
+    printf("\n");
+
+    for (int point = 0; point < point_count; point++) {
+        int index = point;
+        const char* values[parameter_count > 0 ? parameter_count : 1];
+        for (int i = parameter_count - 1; i >= 0; i--) {
+            values[i] = parameters[i].values[index % parameters[i].value_count];
+            index /= parameters[i].value_count;
+        }
+        for (int i = 0; i < parameter_count; i++) {
+            printf("%s\t", values[i]);
+        }
+        printf("%d", stats[point].runs);
+        for (int i = 0; i < SWEEP_METRICS; i++) {
+            double variance = stats[point].runs > 1 ?
+                stats[point].m2[i] / (stats[point].runs - 1) : 0;
+            printf("\t%f\t%f", stats[point].mean[i], variance);
+        }
+        printf("\n");
+    }
+
+    if (failed > 0) {
+        fprintf(stderr, "%d of %d sweep replicas failed\n", failed, sweep.replica_count);
+    }
+
+    free(stats);
+    free(sweep.results);
+    free(sweep.completed);
+    if (sweep.checkpoint != NULL) {
+        checkpoint_free(sweep.checkpoint);
+    }
+
+    return failed > 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file    sweep.h
+ * @brief   Parameter sweep runner
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include "checkpoint.h"
+#include "settings.h"
+#include "simulation.h"
+
+#ifndef sweep_H
+#define sweep_H
+
+#define SWEEP_METRICS   10
+
+// One swept field and the values it takes
+struct Sweep_Parameter {
+    char* name;
+    char** values;
+    int value_count;
+};
+
+// Running mean and variance of each metric for one grid point
+struct Sweep_Stats {
+    int runs;
+    double mean[SWEEP_METRICS];
+    double m2[SWEEP_METRICS];
+};
+
+// Replicas to run and where their results go
+struct Sweep {
+    const struct Settings* base;
+    struct Sweep_Parameter* parameters;
+    int parameter_count;
+    int repeats;
+    int replica_count;
+    int next_replica;
+    struct Sim_Result* results;
+    int* completed;
+    struct Checkpoint* checkpoint;
+};
+
+int run_sweep(const struct Settings* settings);
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file    threads.c
+ * @brief   Multi-threaded tick engine for dynamic wireless network simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <unistd.h>
+#include "channels.h"
+#include "file_output.h"
+#include "mcu_emulation.h"
+#include "simulation.h"
+#include "state.h"
+#include "threads.h"
+
+/**
+ * Worker tick
+ * Desc: Runs one tick for the worker's slice of nodes. Each phase only writes
+ *       to nodes in the slice, other nodes are read through the previous tick
+ *       view so the result doesn't depend on how nodes are split up.
+ *
+ * Phases:
+ * ----------------
+ *  0: kinematics and previous tick view for own nodes
+ *  1: MCU functions for own nodes, after worker 0 updates the spatial grid
+ *     and neighbor lists
+**/
+static void worker_tick(struct Simulation* sim, int worker) {
+    struct Thread_Pool* pool = &sim->pool;
+    int start = (int)((long)sim->settings.node_count * worker / pool->thread_count);
+    int end = (int)((long)sim->settings.node_count * (worker + 1) / pool->thread_count);
+
+    // Only worker 0, the simulation thread, adds to the profile phases
+    PROFILE_BEGIN(acceleration);
+    update_acceleration_range(sim, start, end);
+    if (worker == 0) {
+        PROFILE_PHASE(sim, PROFILE_ACCELERATION, acceleration);
+    }
+    PROFILE_BEGIN(velocity);
+    update_velocity_range(sim, start, end);
+    if (worker == 0) {
+        PROFILE_PHASE(sim, PROFILE_VELOCITY, velocity);
+    }
+    PROFILE_BEGIN(position);
+    update_position_range(sim, start, end);
+    for (int i = start; i < end; i++) {
+        update_node_view(sim, i);
+    }
+    if (worker == 0) {
+        PROFILE_PHASE(sim, PROFILE_POSITION, position);
+    }
+    PROFILE_BEGIN(sync);
+    pthread_barrier_wait(&pool->phase_barrier);
+    // Grid and neighbor list updates need every position, and have to be
+    // done before any MCU queries them
+    if (sim->grid.enabled) {
+        if (worker == 0) {
+            update_spatial_grid(sim);
+            update_neighbor_lists(sim);
+        }
+        pthread_barrier_wait(&pool->phase_barrier);
+    }
+    if (worker == 0) {
+        PROFILE_PHASE(sim, PROFILE_SYNC, sync);
+    }
+
+    PROFILE_BEGIN(mcu);
+    for (int i = start; i < end; i++) {
+        mcu_run_function(sim, i);
+    }
+    if (worker == 0) {
+        PROFILE_PHASE(sim, PROFILE_MCU, mcu);
+    }
+}
+
+static void* worker_main(void* arg) {
+    struct Thread_Worker* worker = arg;
+    struct Thread_Pool* pool = &worker->sim->pool;
+    while (1) {
+        pthread_barrier_wait(&pool->start_barrier);
+        if (!pool->running) {
+            break;
+        }
+        worker_tick(worker->sim, worker->index);
+        pthread_barrier_wait(&pool->end_barrier);
+    }
+    return NULL;
+}
+
+int initialize_thread_pool(struct Simulation* sim) {
+    struct Thread_Pool* pool = &sim->pool;
+
+    pool->thread_count = sim->settings.thread_count;
+    if (pool->thread_count <= 0) {
+        pool->thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (pool->thread_count > sim->settings.node_count) {
+        pool->thread_count = sim->settings.node_count;
+    }
+    if (pool->thread_count < 1) {
+        pool->thread_count = 1;
+    }
+    pool->running = 1;
+
+    sim->node_views = malloc(sizeof(struct Node_View) * sim->settings.node_count);
+    pool->threads = malloc(sizeof(pthread_t) * pool->thread_count);
+    pool->workers = malloc(sizeof(struct Thread_Worker) * pool->thread_count);
+    if (sim->node_views == NULL || pool->threads == NULL || pool->workers == NULL) {
+        printf("Thread pool memory allocation error\n");
+        exit(0);
+    }
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        sim->node_views[i].transmit_active = 0;
+        sim->node_views[i].active_channel = 0;
+        sim->node_views[i].send_packet = PACKET_NONE;
+    }
+
+    pthread_barrier_init(&pool->start_barrier, NULL, pool->thread_count);
+    pthread_barrier_init(&pool->phase_barrier, NULL, pool->thread_count);
+    pthread_barrier_init(&pool->end_barrier, NULL, pool->thread_count);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pool->workers[i].sim = sim;
+        pool->workers[i].index = i;
+    }
+    for (int i = 1; i < pool->thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]) != 0) {
+            printf("Unable to create worker thread %d\n", i);
+            exit(1);
+        }
+    }
+    if (sim->settings.verbose) {
+        printf("Worker threads: %d\n", pool->thread_count);
+    }
+    return 0;
+}
+
+int clock_tick_threaded(struct Simulation* sim) {
+    struct Thread_Pool* pool = &sim->pool;
+
+    sim->state.current_time += sim->settings.time_resolution;
+    
+    if (sim->settings.debug > 1) {
+        printf("Clock tick: %f\n", sim->state.current_time);
+    }
+
+    // Update current cycle
+    sim->state.current_cycle++;
+
+    PROFILE_BEGIN(start_sync);
+    pthread_barrier_wait(&pool->start_barrier);
+    PROFILE_PHASE(sim, PROFILE_SYNC, start_sync);
+    worker_tick(sim, 0);
+    PROFILE_BEGIN(end_sync);
+    pthread_barrier_wait(&pool->end_barrier);
+    PROFILE_PHASE(sim, PROFILE_SYNC, end_sync);
+
+    // Live transmitters are also what MCUs see as the previous tick next time
+    PROFILE_BEGIN(channels);
+    channel_index_rebuild(sim);
+    update_interference(sim);
+    PROFILE_PHASE(sim, PROFILE_CHANNELS, channels);
+
+    PROFILE_BEGIN(ground);
+    update_ground(sim);
+    PROFILE_PHASE(sim, PROFILE_GROUND, ground);
+
+    if (sim->settings.output) {
+        PROFILE_BEGIN(output);
+        check_write_interval(sim);
+        PROFILE_PHASE(sim, PROFILE_OUTPUT, output);
+    }
+
+    return 0;
+}
+
+int shutdown_thread_pool(struct Simulation* sim) {
+    struct Thread_Pool* pool = &sim->pool;
+
+    pool->running = 0;
+    pthread_barrier_wait(&pool->start_barrier);
+    for (int i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_barrier_destroy(&pool->start_barrier);
+    pthread_barrier_destroy(&pool->phase_barrier);
+    pthread_barrier_destroy(&pool->end_barrier);
+    free(pool->threads);
+    free(pool->workers);
+    for (int i = 0; i < sim->settings.node_count; i++) {
+        packet_unref(&sim->packets, sim->node_views[i].send_packet);
+    }
+    free(sim->node_views);
+    sim->node_views = NULL;
+    return 0;
+}
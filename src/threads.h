@@ -0,0 +1,39 @@
+/**
+ * @file    threads.h
+ * @brief   Multi-threaded tick engine for dynamic wireless network simulation
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <pthread.h>
+#include "node.h"
+#include "ground.h"
+
+#ifndef threads_H
+#define threads_H
+
+struct Simulation;
+
+// What each worker thread is handed
+struct Thread_Worker {
+    struct Simulation* sim;
+    int index;
+};
+
+// Persistent worker pool, the calling thread works as worker 0
+struct Thread_Pool {
+    pthread_t* threads;
+    struct Thread_Worker* workers;
+    int thread_count;
+    int running;
+    pthread_barrier_t start_barrier;
+    pthread_barrier_t phase_barrier;
+    pthread_barrier_t end_barrier;
+};
+
+int initialize_thread_pool(struct Simulation* sim);
+int clock_tick_threaded(struct Simulation* sim);
+int shutdown_thread_pool(struct Simulation* sim);
+
+#endif
@@ -6,109 +6,64 @@
  * @date    2/19/2021
 **/
 
+#include <limits.h>
 #include <stdio.h>
-#include "settings.h"
-#include "state.h"
+#include <stdlib.h>
+#include "timers.h"
 
-extern struct State state;
-
-struct cycle_timer* cycle_timer_create(struct cycle_timer* head, 
-                                       int function, 
-                                       int label, 
-                                       unsigned long start,
-                                       unsigned long expiration) {
-    // Allocate memory for new timer node
-    struct cycle_timer* new_timer = malloc(sizeof(struct cycle_timer));
-    if (new_timer == NULL) {
-        printf("Timer memory allocation error\n");
+// Slot for a (function, label) key in a node's timer table
+static struct cycle_timer* cycle_timer_slot(struct cycle_timer* timers, int function, int label) {
+    if (function < 0 || function >= CYCLE_TIMER_FUNCTIONS || label < 0 || label >= CYCLE_TIMER_LABELS) {
+        printf("Timer key %d/%d out of range\n", function, label);
         exit(0);
     }
+    return &timers[function * CYCLE_TIMER_LABELS + label];
+}
 
-    // Assign parameters to new timer node
-    new_timer->function = function;
-    new_timer->label = label;
-    new_timer->start = start;
-    new_timer->expiration = expiration;
-    new_timer->next = head;
+// Arming a key that is already armed restarts it
+int cycle_timer_arm(struct cycle_timer* timers, 
+                    int function, 
+                    int label, 
+                    unsigned long start,
+                    unsigned long expiration) {
+    struct cycle_timer* timer = cycle_timer_slot(timers, function, label);
+    timer->armed = 1;
+    timer->start = start;
+    timer->expiration = expiration;
 
-    return new_timer;
+    return 0;
 }
 
-struct cycle_timer* cycle_timer_get(struct cycle_timer* head, int function, int label) {
- 
-    struct cycle_timer *cursor = head; 
-    while (cursor != NULL) {
-        if (cursor->function == function && cursor->label == label) {
-            return cursor;
-        }
-        cursor = cursor->next;
-    }
-    return NULL;
+int cycle_timer_cancel(struct cycle_timer* timers, int function, int label) {
+    cycle_timer_slot(timers, function, label)->armed = 0;
+    return 0;
 }
 
-struct cycle_timer* cycle_timer_remove(struct cycle_timer* head, struct cycle_timer* nd) {
-    // first node
-    if (nd == head) {
-        struct cycle_timer* front = head;
-        head = head->next;
-        front->next = NULL;
-        /* is this the last node in the list */
-        if (front == head) {
-            head = NULL;
-        }
-        free(front);
-    }
- 
-    // last node 
-    else if (nd->next == NULL) { 
-        struct cycle_timer* cursor = head;
-        struct cycle_timer* back = NULL;
-        while (cursor->next != NULL) {
-            back = cursor;
-            cursor = cursor->next;
-        }
-        if (back != NULL) {
-            back->next = NULL;
-        }
-    
-        // if this is the last node in the list
-        if (cursor == head) {
-            head = NULL;
-        }
-    
-        free(cursor);
-    }
- 
-    // node is in the middle
-    else {
-        struct cycle_timer* cursor = head;
-        while (cursor != NULL) {
-            if (cursor->next == nd) {
-                break;
-            }
-            cursor = cursor->next;
-        }
-    
-        if (cursor != NULL) {
-            struct cycle_timer* tmp = cursor->next;
-            cursor->next = tmp->next;
-            tmp->next = NULL;
-            free(tmp);
-        }
-    }
-    return head;
+struct cycle_timer* cycle_timer_get(struct cycle_timer* timers, int function, int label) {
+    struct cycle_timer* timer = cycle_timer_slot(timers, function, label);
+    return timer->armed ? timer : NULL;
 }
 
-int cycle_timer_check_expired(struct cycle_timer* head, int function, int label) {
+int cycle_timer_check_expired(struct cycle_timer* timers, int function, int label, unsigned long current_cycle) {
     int expired = 0;
-    struct cycle_timer* tmp_timer = cycle_timer_get(head, function, label);
+    struct cycle_timer* tmp_timer = cycle_timer_get(timers, function, label);
     if (tmp_timer != NULL) {
         // Timer found, see if expired
-        if (tmp_timer->start + tmp_timer->expiration  < state.current_cycle) {
-            // time expired, delete timer inform caller
-            head = cycle_timer_remove(head, tmp_timer);
+        if (tmp_timer->start + tmp_timer->expiration  < current_cycle) {
+            // time expired, disarm timer inform caller
+            tmp_timer->armed = 0;
             expired = 1;
         }
     }
     return expired;
-}
\ No newline at end of file
+}
+
+// First cycle cycle_timer_check_expired() finds the timer expired on,
+// ULONG_MAX if it isn't armed
+unsigned long cycle_timer_expiry(struct cycle_timer* timers, int function, int label) {
+    struct cycle_timer* timer = cycle_timer_get(timers, function, label);
+    if (timer == NULL) {
+        return ULONG_MAX;
+    }
+    return timer->start + timer->expiration + 1;
+}
@@ -9,17 +9,23 @@
 #ifndef timers_H
 #define timers_H
 
+// Each node has one timer slot per MCU function number and label. Sized to
+// MCU_FUNCTION_COUNT (checked in mcu_emulation.c) and the labels protocol
+// functions use, every node carries the whole table.
+#define CYCLE_TIMER_FUNCTIONS   18
+#define CYCLE_TIMER_LABELS      1
+#define CYCLE_TIMER_SLOTS       (CYCLE_TIMER_FUNCTIONS * CYCLE_TIMER_LABELS)
+
 struct cycle_timer {
-    int function;
-    int label;
+    int armed;
     unsigned long start;
     unsigned long expiration;
-    struct cycle_timer* next;
 };
 
-struct cycle_timer* cycle_timer_create(struct cycle_timer* head, int function, int label, unsigned long start, unsigned long expiration);
-struct cycle_timer* cycle_timer_get(struct cycle_timer* head, int function, int label);
-struct cycle_timer* cycle_timer_remove(struct cycle_timer* head, struct cycle_timer* nd);
-int cycle_timer_check_expired(struct cycle_timer* head, int function, int label);
+int cycle_timer_arm(struct cycle_timer* timers, int function, int label, unsigned long start, unsigned long expiration);
+int cycle_timer_cancel(struct cycle_timer* timers, int function, int label);
+struct cycle_timer* cycle_timer_get(struct cycle_timer* timers, int function, int label);
+int cycle_timer_check_expired(struct cycle_timer* timers, int function, int label, unsigned long current_cycle);
+unsigned long cycle_timer_expiry(struct cycle_timer* timers, int function, int label);
 
-#endif
\ No newline at end of file
+#endif
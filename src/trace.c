@@ -0,0 +1,141 @@
+/**
+ * @file    trace.c
+ * @brief   Binary trajectory trace written in place of the node text files
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "file_output.h"
+#include "simulation.h"
+
+static void put_u32(unsigned char* data, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        data[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+static void put_u64(unsigned char* data, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        data[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+static void put_f64(unsigned char* data, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u64(data, bits);
+}
+
+/**
+ * Create trace files
+ * Desc: Starts trace.bin (and trace_signals.bin when signals are kept) in
+ *       the run's output directory
+**/
+int create_trace_files(struct Simulation* sim) {
+    struct Trace* trace = &sim->trace;
+    char file_path[100];
+    unsigned char header[TRACE_HEADER_SIZE] = {0};
+    int node_count = sim->settings.node_count;
+
+    trace->record_size = TRACE_RECORD_SIZE(node_count);
+    trace->record = calloc(trace->record_size, 1);
+    if (trace->record == NULL) {
+        printf("Trace memory allocation error\n");
+        exit(0);
+    }
+    trace->signal_offset = TRACE_SIGNALS_HEADER_SIZE;
+
+    snprintf(file_path, sizeof(file_path), "%s/%s", sim->settings.output_dir, TRACE_FILE);
+    if (sim->settings.debug) {
+        printf("Creating output file \"%s\"\n", file_path);
+    }
+    output_file_create(&sim->output, OUTPUT_TRACE(sim), file_path);
+
+    memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    put_u32(header + 8, TRACE_VERSION);
+    put_u32(header + 12, TRACE_HEADER_SIZE);
+    put_u32(header + 16, trace->record_size);
+    put_u32(header + 20, node_count);
+    put_u32(header + 24, sim->settings.channels);
+    put_u32(header + 28, sim->settings.trace_signals ? TRACE_FLAG_SIGNALS : 0);
+    put_f64(header + 32, sim->settings.write_interval);
+    put_f64(header + 40, sim->settings.time_resolution);
+    put_u32(header + 48, (uint32_t)sim->settings.random_seed);
+    output_write(&sim->output, OUTPUT_TRACE(sim), (char*)header, sizeof(header));
+
+    if (sim->settings.trace_signals) {
+        unsigned char signals_header[TRACE_SIGNALS_HEADER_SIZE] = {0};
+        snprintf(file_path, sizeof(file_path), "%s/%s", sim->settings.output_dir, TRACE_SIGNALS_FILE);
+        output_file_create(&sim->output, OUTPUT_TRACE_SIGNALS(sim), file_path);
+        memcpy(signals_header, TRACE_SIGNALS_MAGIC, sizeof(TRACE_SIGNALS_MAGIC));
+        put_u32(signals_header + 8, TRACE_VERSION);
+        put_u32(signals_header + 12, TRACE_SIGNAL_SIZE);
+        output_write(&sim->output, OUTPUT_TRACE_SIGNALS(sim), (char*)signals_header,
+                     sizeof(signals_header));
+    }
+
+    return 0;
+}
+
+// Appends one record, plus a block of the nonzero received signals when
+// they're kept
+int write_trace_sample(struct Simulation* sim, const struct Output_Sample* sample) {
+    struct Trace* trace = &sim->trace;
+    unsigned char* record = trace->record;
+    int node_count = sim->settings.node_count;
+    uint32_t signal_count = 0;
+
+    if (sim->settings.trace_signals) {
+        unsigned char entry[TRACE_SIGNAL_SIZE];
+        int file = OUTPUT_TRACE_SIGNALS(sim);
+
+        // Row starts first, then the entries they point into
+        for (int i = 0; i < node_count; i++) {
+            put_u32(entry, signal_count);
+            output_write(&sim->output, file, (char*)entry, 4);
+            for (int j = 0; j < node_count; j++) {
+                signal_count += sample->signals[(size_t)i * node_count + j] != 0;
+            }
+        }
+        put_u32(entry, signal_count);
+        output_write(&sim->output, file, (char*)entry, 4);
+
+        for (int i = 0; i < node_count; i++) {
+            const double* signals = sample->signals + (size_t)i * node_count;
+            for (int j = 0; j < node_count; j++) {
+                if (signals[j] != 0) {
+                    put_u32(entry, j);
+                    put_f64(entry + 4, signals[j]);
+                    output_write(&sim->output, file, (char*)entry, sizeof(entry));
+                }
+            }
+        }
+    }
+
+    put_f64(record, sample->time);
+    put_u64(record + 8, sim->settings.trace_signals ? trace->signal_offset : 0);
+    put_u32(record + 16, signal_count);
+    for (int i = 0; i < node_count; i++) {
+        put_f64(record + TRACE_COLUMN_X(node_count) + i * 8, sample->x[i]);
+        put_f64(record + TRACE_COLUMN_Y(node_count) + i * 8, sample->y[i]);
+        put_f64(record + TRACE_COLUMN_Z(node_count) + i * 8, sample->z[i]);
+        put_u32(record + TRACE_COLUMN_CHANNEL(node_count) + i * 4, (uint32_t)sample->channel[i]);
+        put_u32(record + TRACE_COLUMN_FUNCTION(node_count) + i * 4, (uint32_t)sample->function[i]);
+    }
+    output_write(&sim->output, OUTPUT_TRACE(sim), (char*)record, trace->record_size);
+    if (sim->settings.trace_signals) {
+        trace->signal_offset += TRACE_SIGNAL_ROWS_SIZE(node_count) + (uint64_t)signal_count * TRACE_SIGNAL_SIZE;
+    }
+
+    return 0;
+}
+
+void free_trace(struct Simulation* sim) {
+    free(sim->trace.record);
+    sim->trace.record = NULL;
+}
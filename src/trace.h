@@ -0,0 +1,76 @@
+/**
+ * @file    trace.h
+ * @brief   Binary trajectory trace written in place of the node text files
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdint.h>
+
+#ifndef trace_H
+#define trace_H
+
+#define TRACE_FILE                  "trace.bin"
+#define TRACE_SIGNALS_FILE          "trace_signals.bin"
+#define TRACE_MAGIC                 "DWSNTRC"
+#define TRACE_SIGNALS_MAGIC         "DWSNSIG"
+#define TRACE_VERSION               1
+
+// Header flags
+#define TRACE_FLAG_SIGNALS          1
+
+/**
+ * trace.bin layout, every field little endian
+ *  header (64 bytes):
+ *      magic char[8], version u32, header size u32, record size u32,
+ *      node count u32, channels u32, flags u32, write interval f64,
+ *      time resolution f64, seed i32, reserved to 64
+ *  one fixed size record per write interval:
+ *      time f64, signal block offset u64, signal count u32, reserved u32,
+ *      then columns of node count values each: x f64, y f64, z f64,
+ *      channel i32, function i32
+ *
+ * Record k starts at header size + k * record size, so the sample count is
+ * just the file size divided down.
+**/
+#define TRACE_HEADER_SIZE           64
+#define TRACE_RECORD_FIXED          24
+#define TRACE_RECORD_SIZE(nodes)    (TRACE_RECORD_FIXED + (nodes) * (3 * 8 + 2 * 4))
+
+// Column offsets inside a record
+#define TRACE_COLUMN_X(nodes)           TRACE_RECORD_FIXED
+#define TRACE_COLUMN_Y(nodes)           (TRACE_RECORD_FIXED + (nodes) * 8)
+#define TRACE_COLUMN_Z(nodes)           (TRACE_RECORD_FIXED + (nodes) * 16)
+#define TRACE_COLUMN_CHANNEL(nodes)     (TRACE_RECORD_FIXED + (nodes) * 24)
+#define TRACE_COLUMN_FUNCTION(nodes)    (TRACE_RECORD_FIXED + (nodes) * 28)
+
+/**
+ * trace_signals.bin layout, only written with TRACE_FLAG_SIGNALS
+ *  header (16 bytes): magic char[8], version u32, entry size u32
+ *  one block per record, at the record's signal block offset:
+ *      row start u32 for each receiver plus one for the end, then
+ *      signal count entries of transmitter u32, signal f64
+ *
+ * Receiver r's entries are row start[r] up to row start[r + 1], sorted by
+ * transmitter. Signals a node hasn't heard (0) are left out.
+**/
+#define TRACE_SIGNALS_HEADER_SIZE   16
+#define TRACE_SIGNAL_SIZE           12
+#define TRACE_SIGNAL_ROWS_SIZE(nodes)   (((nodes) + 1) * 4)
+
+// Record being built for the next sample
+struct Trace {
+    unsigned char* record;
+    int record_size;
+    uint64_t signal_offset;         // where the next signal block goes
+};
+
+struct Simulation;
+struct Output_Sample;
+
+int create_trace_files(struct Simulation*);
+int write_trace_sample(struct Simulation*, const struct Output_Sample*);
+void free_trace(struct Simulation*);
+
+#endif
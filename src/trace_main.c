@@ -0,0 +1,139 @@
+/**
+ * @file    trace_main.c
+ * @brief   dwsn-trace, pulls series and slices out of a binary trace
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_reader.h"
+
+static void usage(void) {
+    fprintf(stderr,
+        "Usage: dwsn-trace <run dir> info\n"
+        "       dwsn-trace <run dir> node <id>        node's series, same lines as node-<id>.txt\n"
+        "       dwsn-trace <run dir> slice <time>     every node at the first sample at or after time\n"
+        "       dwsn-trace <run dir> signals <time>   stored signals of that sample\n");
+}
+
+static void print_info(const struct Trace_Reader* reader) {
+    printf("Nodes: %d\n", reader->node_count);
+    printf("Channels: %d\n", reader->channels);
+    printf("Seed: %d\n", reader->seed);
+    printf("Write interval: %f\n", reader->write_interval);
+    printf("Time resolution: %f\n", reader->time_resolution);
+    printf("Samples: %ld\n", reader->sample_count);
+    if (reader->sample_count > 0) {
+        printf("Time: %f - %f\n", trace_time(reader, 0), trace_time(reader, reader->sample_count - 1));
+    }
+    printf("Signals: %s\n", reader->signals != NULL ? "stored" : "not stored");
+}
+
+// Without stored signals the line stops after the position
+static int print_node(const struct Trace_Reader* reader, int node) {
+    struct Trace_Node_Sample s;
+    double* row = malloc(sizeof(double) * (reader->node_count > 0 ? reader->node_count : 1));
+    if (row == NULL) {
+        printf("Trace memory allocation error\n");
+        exit(0);
+    }
+    if (node < 0 || node >= reader->node_count) {
+        fprintf(stderr, "No node %d, trace has %d nodes\n", node, reader->node_count);
+        free(row);
+        return 1;
+    }
+    for (long i = 0; i < reader->sample_count; i++) {
+        trace_node(reader, i, node, &s);
+        printf("%f\t%i\t%i\t%f\t%f\t%f", s.time, s.channel, s.function, s.x, s.y, s.z);
+        if (reader->signals != NULL) {
+            trace_received_signals(reader, i, node, row);
+            printf(" ");
+            for (int j = 0; j < reader->node_count; j++) {
+                printf(j < reader->node_count - 1 ? "%f\t" : "%f", row[j]);
+            }
+        }
+        printf("\n");
+    }
+    free(row);
+    return 0;
+}
+
+static long sample_at(const struct Trace_Reader* reader, double time) {
+    long sample = trace_find_time(reader, time);
+    if (sample >= reader->sample_count) {
+        fprintf(stderr, "No sample at or after %f\n", time);
+        return -1;
+    }
+    return sample;
+}
+
+static int print_slice(const struct Trace_Reader* reader, double time) {
+    struct Trace_Node_Sample s;
+    long sample = sample_at(reader, time);
+    if (sample < 0) {
+        return 1;
+    }
+    printf("Time %f\n", trace_time(reader, sample));
+    printf("Node\tChannel\tFunction\tX\t\tY\t\tZ\n");
+    for (int i = 0; i < reader->node_count; i++) {
+        trace_node(reader, sample, i, &s);
+        printf("%d\t%i\t%i\t\t%f\t%f\t%f\n", i, s.channel, s.function, s.x, s.y, s.z);
+    }
+    return 0;
+}
+
+static int print_signals(const struct Trace_Reader* reader, double time) {
+    struct Trace_Signal signal;
+    long sample = sample_at(reader, time);
+    if (sample < 0) {
+        return 1;
+    }
+    if (reader->signals == NULL) {
+        fprintf(stderr, "Trace has no signals stored\n");
+        return 1;
+    }
+    printf("Time %f\n", trace_time(reader, sample));
+    printf("Receiver\tTransmitter\tSignal\n");
+    int count = trace_signal_count(reader, sample);
+    for (int i = 0; i < count; i++) {
+        trace_signal(reader, sample, i, &signal);
+        printf("%d\t\t%d\t\t%f\n", signal.receiver, signal.transmitter, signal.value);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    struct Trace_Reader reader;
+    int ret = 0;
+
+    if (argc < 3 || (strcmp(argv[2], "info") != 0 && argc < 4)) {
+        usage();
+        return 2;
+    }
+    if (trace_open(&reader, argv[1]) != 0) {
+        return 1;
+    }
+
+    if (strcmp(argv[2], "info") == 0) {
+        print_info(&reader);
+    }
+    else if (strcmp(argv[2], "node") == 0) {
+        ret = print_node(&reader, atoi(argv[3]));
+    }
+    else if (strcmp(argv[2], "slice") == 0) {
+        ret = print_slice(&reader, atof(argv[3]));
+    }
+    else if (strcmp(argv[2], "signals") == 0) {
+        ret = print_signals(&reader, atof(argv[3]));
+    }
+    else {
+        usage();
+        ret = 2;
+    }
+
+    trace_close(&reader);
+    return ret;
+}
@@ -0,0 +1,249 @@
+/**
+ * @file    trace_reader.c
+ * @brief   Reads binary trajectory traces through mmap
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace_reader.h"
+
+static uint32_t get_u32(const unsigned char* data) {
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static uint64_t get_u64(const unsigned char* data) {
+    return (uint64_t)get_u32(data) | (uint64_t)get_u32(data + 4) << 32;
+}
+
+static double get_f64(const unsigned char* data) {
+    uint64_t bits = get_u64(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Maps path read only, an empty file maps to NULL. Returns 0 or -1
+static int map_file(const char* path, const unsigned char** data, size_t* size) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open trace file \"%s\": %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Unable to read trace file \"%s\": %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    *size = st.st_size;
+    *data = NULL;
+    if (*size > 0) {
+        void* map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Unable to map trace file \"%s\": %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        *data = map;
+    }
+    close(fd);
+    return 0;
+}
+
+/**
+ * Trace open
+ * Desc: Maps trace.bin and, when the trace kept signals, trace_signals.bin
+ *       from a run's output directory. A trailing partial record (a run
+ *       that was killed) isn't counted as a sample.
+ *
+ * Returns: 0, or -1 if the files are missing or aren't a trace
+**/
+int trace_open(struct Trace_Reader* reader, const char* dir) {
+    char path[512];
+    memset(reader, 0, sizeof(*reader));
+
+    snprintf(path, sizeof(path), "%s/%s", dir, TRACE_FILE);
+    if (map_file(path, &reader->data, &reader->size) != 0) {
+        return -1;
+    }
+    if (reader->size < TRACE_HEADER_SIZE || memcmp(reader->data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        get_u32(reader->data + 8) != TRACE_VERSION) {
+        fprintf(stderr, "\"%s\" is not a version %d trace\n", path, TRACE_VERSION);
+        trace_close(reader);
+        return -1;
+    }
+
+    reader->header_size = get_u32(reader->data + 12);
+    reader->record_size = get_u32(reader->data + 16);
+    reader->node_count = get_u32(reader->data + 20);
+    reader->channels = get_u32(reader->data + 24);
+    reader->flags = get_u32(reader->data + 28);
+    reader->write_interval = get_f64(reader->data + 32);
+    reader->time_resolution = get_f64(reader->data + 40);
+    reader->seed = (int32_t)get_u32(reader->data + 48);
+    if (reader->record_size != TRACE_RECORD_SIZE(reader->node_count) ||
+        reader->header_size < TRACE_HEADER_SIZE || (size_t)reader->header_size > reader->size) {
+        fprintf(stderr, "\"%s\" has a bad header\n", path);
+        trace_close(reader);
+        return -1;
+    }
+    reader->sample_count = (reader->size - reader->header_size) / reader->record_size;
+
+    if (reader->flags & TRACE_FLAG_SIGNALS) {
+        snprintf(path, sizeof(path), "%s/%s", dir, TRACE_SIGNALS_FILE);
+        if (map_file(path, &reader->signals, &reader->signals_size) != 0) {
+            trace_close(reader);
+            return -1;
+        }
+        if (reader->signals_size < TRACE_SIGNALS_HEADER_SIZE ||
+            memcmp(reader->signals, TRACE_SIGNALS_MAGIC, sizeof(TRACE_SIGNALS_MAGIC)) != 0 ||
+            get_u32(reader->signals + 12) != TRACE_SIGNAL_SIZE) {
+            fprintf(stderr, "\"%s\" is not a version %d trace\n", path, TRACE_VERSION);
+            trace_close(reader);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void trace_close(struct Trace_Reader* reader) {
+    if (reader->data != NULL) {
+        munmap((void*)reader->data, reader->size);
+    }
+    if (reader->signals != NULL) {
+        munmap((void*)reader->signals, reader->signals_size);
+    }
+    reader->data = NULL;
+    reader->signals = NULL;
+    reader->sample_count = 0;
+}
+
+static const unsigned char* record(const struct Trace_Reader* reader, long sample) {
+    return reader->data + reader->header_size + (size_t)sample * reader->record_size;
+}
+
+double trace_time(const struct Trace_Reader* reader, long sample) {
+    return get_f64(record(reader, sample));
+}
+
+// First sample at or after time, sample_count if there is none
+long trace_find_time(const struct Trace_Reader* reader, double time) {
+    long low = 0;
+    long high = reader->sample_count;
+    while (low < high) {
+        long mid = low + (high - low) / 2;
+        if (trace_time(reader, mid) < time) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Reads node's columns from one record. Returns 0, or -1 if out of range
+int trace_node(const struct Trace_Reader* reader, long sample, int node, struct Trace_Node_Sample* out) {
+    if (sample < 0 || sample >= reader->sample_count || node < 0 || node >= reader->node_count) {
+        return -1;
+    }
+    const unsigned char* r = record(reader, sample);
+    int n = reader->node_count;
+    out->time = get_f64(r);
+    out->x = get_f64(r + TRACE_COLUMN_X(n) + node * 8);
+    out->y = get_f64(r + TRACE_COLUMN_Y(n) + node * 8);
+    out->z = get_f64(r + TRACE_COLUMN_Z(n) + node * 8);
+    out->channel = (int32_t)get_u32(r + TRACE_COLUMN_CHANNEL(n) + node * 4);
+    out->function = (int32_t)get_u32(r + TRACE_COLUMN_FUNCTION(n) + node * 4);
+    return 0;
+}
+
+// Start of sample's signal block, NULL when the trace has no signals or
+// the signal file was cut short before the block's end
+static const unsigned char* signal_block(const struct Trace_Reader* reader, long sample, int* count) {
+    if (reader->signals == NULL || sample < 0 || sample >= reader->sample_count) {
+        return NULL;
+    }
+    const unsigned char* r = record(reader, sample);
+    uint64_t offset = get_u64(r + 8);
+    *count = get_u32(r + 16);
+    uint64_t end = offset + TRACE_SIGNAL_ROWS_SIZE(reader->node_count) + (uint64_t)*count * TRACE_SIGNAL_SIZE;
+    if (offset < TRACE_SIGNALS_HEADER_SIZE || end > reader->signals_size) {
+        return NULL;
+    }
+    return reader->signals + offset;
+}
+
+int trace_signal_count(const struct Trace_Reader* reader, long sample) {
+    int count;
+    return signal_block(reader, sample, &count) != NULL ? count : 0;
+}
+
+// Entry index of sample's signals, receiver comes from the row starts
+int trace_signal(const struct Trace_Reader* reader, long sample, int index, struct Trace_Signal* out) {
+    int count;
+    const unsigned char* block = signal_block(reader, sample, &count);
+    if (block == NULL || index < 0 || index >= count) {
+        return -1;
+    }
+    // Last row starting at or before index
+    int low = 0;
+    int high = reader->node_count - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (get_u32(block + mid * 4) <= (uint32_t)index) {
+            low = mid;
+        }
+        else {
+            high = mid - 1;
+        }
+    }
+    const unsigned char* entry = block + TRACE_SIGNAL_ROWS_SIZE(reader->node_count) + 
+                                 (size_t)index * TRACE_SIGNAL_SIZE;
+    out->receiver = low;
+    out->transmitter = get_u32(entry);
+    out->value = get_f64(entry + 4);
+    return 0;
+}
+
+/**
+ * Trace received signals
+ * Desc: Fills row (node count values) with what receiver heard in sample,
+ *       0 for anything not stored
+ *
+ * Returns: number of stored signals for receiver
+**/
+int trace_received_signals(const struct Trace_Reader* reader, long sample, int receiver, double* row) {
+    int count;
+    const unsigned char* block = signal_block(reader, sample, &count);
+
+    for (int i = 0; i < reader->node_count; i++) {
+        row[i] = 0;
+    }
+    if (block == NULL || receiver < 0 || receiver >= reader->node_count) {
+        return 0;
+    }
+
+    uint32_t first = get_u32(block + receiver * 4);
+    uint32_t last = get_u32(block + (receiver + 1) * 4);
+    if (first > last || last > (uint32_t)count) {
+        return 0;
+    }
+    const unsigned char* entries = block + TRACE_SIGNAL_ROWS_SIZE(reader->node_count);
+    for (uint32_t i = first; i < last; i++) {
+        const unsigned char* entry = entries + (size_t)i * TRACE_SIGNAL_SIZE;
+        uint32_t transmitter = get_u32(entry);
+        if (transmitter < (uint32_t)reader->node_count) {
+            row[transmitter] = get_f64(entry + 4);
+        }
+    }
+    return last - first;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file    trace_reader.h
+ * @brief   Reads binary trajectory traces through mmap
+ *
+ * @author  Mitchell Clay
+ * @date    10/16/2026
+**/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "trace.h"
+
+#ifndef trace_reader_H
+#define trace_reader_H
+
+// An open trace, fields come from the header and the data stays mapped
+struct Trace_Reader {
+    const unsigned char* data;
+    size_t size;
+    const unsigned char* signals;   // NULL when the trace has no signals
+    size_t signals_size;
+    int node_count;
+    int channels;
+    int flags;
+    int header_size;
+    int record_size;
+    int seed;
+    double write_interval;
+    double time_resolution;
+    long sample_count;
+};
+
+// One node in one sample
+struct Trace_Node_Sample {
+    double time;
+    double x;
+    double y;
+    double z;
+    int channel;
+    int function;
+};
+
+struct Trace_Signal {
+    int receiver;
+    int transmitter;
+    double value;
+};
+
+int trace_open(struct Trace_Reader* reader, const char* dir);
+void trace_close(struct Trace_Reader* reader);
+double trace_time(const struct Trace_Reader* reader, long sample);
+long trace_find_time(const struct Trace_Reader* reader, double time);
+int trace_node(const struct Trace_Reader* reader, long sample, int node, struct Trace_Node_Sample* out);
+int trace_signal_count(const struct Trace_Reader* reader, long sample);
+int trace_signal(const struct Trace_Reader* reader, long sample, int index, struct Trace_Signal* out);
+int trace_received_signals(const struct Trace_Reader* reader, long sample, int receiver, double* row);
+
+#endif